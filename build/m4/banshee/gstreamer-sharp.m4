@@ -12,5 +12,7 @@ AC_DEFUN([BANSHEE_CHECK_GSTREAMER_SHARP],
 		dnl Clutter support is not available in Gst# backend (and was opt-in in the unmanaged one)
 		AM_CONDITIONAL(HAVE_CLUTTER, false)
 	fi
+
+	AM_CONDITIONAL(ENABLE_GST_SHARP, test "x$enable_gst_sharp" = "xyes")
 ])
 
@@ -14,7 +14,8 @@ AC_DEFUN([BANSHEE_CHECK_GSTREAMER],
 		gstreamer-fft-1.0 >= $GSTREAMER_REQUIRED_VERSION
 		gstreamer-pbutils-1.0 >= $GSTREAMER_REQUIRED_VERSION
 		gstreamer-tag-1.0 >= $GSTREAMER_REQUIRED_VERSION
-		gstreamer-video-1.0 >= $GSTREAMER_REQUIRED_VERSION)
+		gstreamer-video-1.0 >= $GSTREAMER_REQUIRED_VERSION
+		gio-2.0)
 
 	AC_SUBST(GST_CFLAGS)
 	AC_SUBST(GST_LIBS)
@@ -0,0 +1,156 @@
+//
+// BulkTagReader.cs
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+
+namespace Banshee.GStreamer
+{
+    public class NativeTagInfo
+    {
+        public string Path { get; internal set; }
+
+        // null when the file was read, in which case the rest is unset
+        public string Error { get; internal set; }
+
+        public TimeSpan Duration { get; internal set; }
+        public int BitRate { get; internal set; }
+        public int Channels { get; internal set; }
+        public int SampleRate { get; internal set; }
+        public string Codec { get; internal set; }
+
+        public string Title { get; internal set; }
+        public string Artist { get; internal set; }
+        public string Album { get; internal set; }
+        public string AlbumArtist { get; internal set; }
+        public string Composer { get; internal set; }
+        public string Genre { get; internal set; }
+        public int TrackNumber { get; internal set; }
+        public int TrackCount { get; internal set; }
+        public int DiscNumber { get; internal set; }
+        public int DiscCount { get; internal set; }
+        public int Year { get; internal set; }
+    }
+
+    // Reads stream properties and core tags of many files at once with
+    // GstDiscoverer on native worker threads; a fast path and a cross-check
+    // for files TagLib# is slow to handle during import
+    public static class BulkTagReader
+    {
+        // Mirrors BansheeTagReaderResult
+        [StructLayout (LayoutKind.Sequential)]
+        private struct NativeResult
+        {
+            public long DurationMs;
+            public int BitRate;
+            public int Channels;
+            public int SampleRate;
+            public int TrackNumber;
+            public int TrackCount;
+            public int DiscNumber;
+            public int DiscCount;
+            public int Year;
+            public IntPtr Codec;
+            public IntPtr Title;
+            public IntPtr Artist;
+            public IntPtr Album;
+            public IntPtr AlbumArtist;
+            public IntPtr Composer;
+            public IntPtr Genre;
+            public IntPtr Error;
+        }
+
+        // Blocks until every path was read; results are in the same order
+        public static NativeTagInfo [] Read (IList<string> paths, int maxThreads)
+        {
+            var path_ptrs = new IntPtr[paths.Count];
+            var infos = new NativeTagInfo[paths.Count];
+            IntPtr results = IntPtr.Zero;
+
+            try {
+                for (int i = 0; i < paths.Count; i++) {
+                    path_ptrs[i] = GLib.Marshaller.StringToPtrGStrdup (paths[i]);
+                }
+
+                results = btr_read_batch (path_ptrs, paths.Count, maxThreads);
+                if (results == IntPtr.Zero) {
+                    return infos;
+                }
+
+                int size = Marshal.SizeOf (typeof (NativeResult));
+                for (int i = 0; i < paths.Count; i++) {
+                    var result = (NativeResult)Marshal.PtrToStructure (
+                        new IntPtr (results.ToInt64 () + i * size), typeof (NativeResult));
+                    infos[i] = ToTagInfo (paths[i], result);
+                }
+            } finally {
+                btr_free_batch (results, paths.Count);
+                foreach (var ptr in path_ptrs) {
+                    GLib.Marshaller.Free (ptr);
+                }
+            }
+
+            return infos;
+        }
+
+        private static NativeTagInfo ToTagInfo (string path, NativeResult result)
+        {
+            var info = new NativeTagInfo () {
+                Path = path,
+                Error = GLib.Marshaller.Utf8PtrToString (result.Error)
+            };
+
+            if (info.Error != null) {
+                return info;
+            }
+
+            info.Duration = TimeSpan.FromMilliseconds (result.DurationMs);
+            info.BitRate = result.BitRate;
+            info.Channels = result.Channels;
+            info.SampleRate = result.SampleRate;
+            info.Codec = GLib.Marshaller.Utf8PtrToString (result.Codec);
+            info.Title = GLib.Marshaller.Utf8PtrToString (result.Title);
+            info.Artist = GLib.Marshaller.Utf8PtrToString (result.Artist);
+            info.Album = GLib.Marshaller.Utf8PtrToString (result.Album);
+            info.AlbumArtist = GLib.Marshaller.Utf8PtrToString (result.AlbumArtist);
+            info.Composer = GLib.Marshaller.Utf8PtrToString (result.Composer);
+            info.Genre = GLib.Marshaller.Utf8PtrToString (result.Genre);
+            info.TrackNumber = result.TrackNumber;
+            info.TrackCount = result.TrackCount;
+            info.DiscNumber = result.DiscNumber;
+            info.DiscCount = result.DiscCount;
+            info.Year = result.Year;
+            return info;
+        }
+
+        [DllImport ("libbanshee.dll")]
+        private static extern IntPtr btr_read_batch (IntPtr [] paths, int count, int maxThreads);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void btr_free_batch (IntPtr results, int count);
+    }
+}
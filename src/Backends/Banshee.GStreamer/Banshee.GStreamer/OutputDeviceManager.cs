@@ -0,0 +1,137 @@
+//
+// OutputDeviceManager.cs
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+
+namespace Banshee.GStreamer
+{
+    public class OutputDevice
+    {
+        public string Id { get; internal set; }
+        public string DisplayName { get; internal set; }
+
+        // GStreamer caps string of the formats the device accepts
+        public string Caps { get; internal set; }
+
+        // The sink's default buffer, null if it does not say
+        public TimeSpan? Latency { get; internal set; }
+
+        public bool HasVolume { get; internal set; }
+        public bool IsDefault { get; internal set; }
+
+        public override string ToString ()
+        {
+            return DisplayName;
+        }
+    }
+
+    // The audio outputs libbanshee enumerated with GstDeviceMonitor; empty
+    // when no device provider is available and players autodetect their sink
+    public static class OutputDeviceManager
+    {
+        private delegate void DevicesChangedCallback ();
+
+        // Mirrors BansheeOutputDeviceInfo
+        [StructLayout (LayoutKind.Sequential)]
+        private struct NativeDeviceInfo
+        {
+            public IntPtr Id;
+            public IntPtr DisplayName;
+            public IntPtr Caps;
+            public long LatencyUs;
+            public bool HasVolume;
+            public bool IsDefault;
+        }
+
+        private static DevicesChangedCallback changed_callback;
+        private static EventHandler devices_changed;
+
+        // Raised on the main loop when a device is plugged in or removed
+        public static event EventHandler DevicesChanged {
+            add {
+                lock (typeof (OutputDeviceManager)) {
+                    if (changed_callback == null) {
+                        changed_callback = OnDevicesChanged;
+                        bom_set_devices_changed_callback (changed_callback);
+                    }
+                    devices_changed += value;
+                }
+            }
+            remove {
+                lock (typeof (OutputDeviceManager)) {
+                    devices_changed -= value;
+                }
+            }
+        }
+
+        public static IList<OutputDevice> Devices {
+            get {
+                int count;
+                var devices = new List<OutputDevice> ();
+                IntPtr infos = bom_get_devices (out count);
+
+                try {
+                    int size = Marshal.SizeOf (typeof (NativeDeviceInfo));
+                    for (int i = 0; i < count; i++) {
+                        var info = (NativeDeviceInfo)Marshal.PtrToStructure (
+                            new IntPtr (infos.ToInt64 () + i * size), typeof (NativeDeviceInfo));
+                        devices.Add (new OutputDevice () {
+                            Id = GLib.Marshaller.Utf8PtrToString (info.Id),
+                            DisplayName = GLib.Marshaller.Utf8PtrToString (info.DisplayName),
+                            Caps = GLib.Marshaller.Utf8PtrToString (info.Caps),
+                            Latency = info.LatencyUs < 0 ? (TimeSpan?)null : TimeSpan.FromTicks (info.LatencyUs * 10),
+                            HasVolume = info.HasVolume,
+                            IsDefault = info.IsDefault
+                        });
+                    }
+                } finally {
+                    bom_free_devices (infos, count);
+                }
+
+                return devices;
+            }
+        }
+
+        private static void OnDevicesChanged ()
+        {
+            EventHandler handler = devices_changed;
+            if (handler != null) {
+                handler (null, EventArgs.Empty);
+            }
+        }
+
+        [DllImport ("libbanshee.dll")]
+        private static extern IntPtr bom_get_devices (out int count);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bom_free_devices (IntPtr infos, int count);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bom_set_devices_changed_callback (DevicesChangedCallback cb);
+    }
+}
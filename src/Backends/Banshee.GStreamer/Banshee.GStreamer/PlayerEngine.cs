@@ -73,6 +73,9 @@ namespace Banshee.GStreamer
     internal delegate void VideoPrepareWindowHandler (IntPtr player);
     [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
     internal delegate void BansheePlayerVolumeChangedCallback (IntPtr player, double newVolume);
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    internal delegate void BansheePlayerStreamInfoCallback (IntPtr player, int n_audio, int n_video, int n_text,
+        int width, int height, int fps_n, int fps_d, int par_n, int par_d);
 
     [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
     internal delegate void GstTaggerTagFoundCallback (IntPtr player, string tagName, ref GLib.Value value);
@@ -87,6 +90,7 @@ namespace Banshee.GStreamer
 
         private HandleRef handle;
         private bool is_initialized;
+        private string output_device;
 
         private BansheePlayerEosCallback eos_callback;
         private BansheePlayerErrorCallback error_callback;
@@ -99,6 +103,7 @@ namespace Banshee.GStreamer
         private BansheePlayerNextTrackStartingCallback next_track_starting_callback;
         private BansheePlayerAboutToFinishCallback about_to_finish_callback;
         private BansheePlayerVolumeChangedCallback volume_changed_callback;
+        private BansheePlayerStreamInfoCallback stream_info_callback;
 
         private bool next_track_pending;
         private SafeUri pending_uri;
@@ -165,6 +170,7 @@ namespace Banshee.GStreamer
             next_track_starting_callback = new BansheePlayerNextTrackStartingCallback (OnNextTrackStarting);
             about_to_finish_callback = new BansheePlayerAboutToFinishCallback (OnAboutToFinish);
             volume_changed_callback = new BansheePlayerVolumeChangedCallback (OnVolumeChanged);
+            stream_info_callback = new BansheePlayerStreamInfoCallback (OnStreamInfo);
             bp_set_eos_callback (handle, eos_callback);
             bp_set_error_callback (handle, error_callback);
             bp_set_state_changed_callback (handle, state_changed_callback);
@@ -174,6 +180,7 @@ namespace Banshee.GStreamer
             bp_set_video_pipeline_setup_callback (handle, video_pipeline_setup_callback);
             bp_set_video_prepare_window_callback (handle, video_prepare_window_callback);
             bp_set_volume_changed_callback (handle, volume_changed_callback);
+            bp_set_stream_info_callback (handle, stream_info_callback);
 
             next_track_set = new EventWaitHandle (false, EventResetMode.ManualReset);
         }
@@ -185,6 +192,12 @@ namespace Banshee.GStreamer
                 ((IExtensionService)service).Initialize ();
             }
 
+            // Set before the pipeline is built so its sink is made for this device
+            string output_device = OutputDeviceSchema.Get ();
+            if (!String.IsNullOrEmpty (output_device)) {
+                OutputDevice = output_device;
+            }
+
             if (!bp_initialize_pipeline (handle)) {
                 bp_destroy (handle);
                 handle = new HandleRef (this, IntPtr.Zero);
@@ -196,6 +209,9 @@ namespace Banshee.GStreamer
             InstallPreferences ();
             ReplayGainEnabled = ReplayGainEnabledSchema.Get ();
             GaplessEnabled = GaplessEnabledSchema.Get ();
+            bp_cdda_set_readahead (handle, (uint)Math.Max (0, CddaReadAheadSchema.Get ()));
+            SetupStreamCache ();
+            OutputLatencyMode = ParseOutputLatencyMode (OutputLatencyModeSchema.Get ());
             Log.InformationFormat ("GStreamer version {0}, gapless: {1}, replaygain: {2}", gstreamer_version_string (), GaplessEnabled, ReplayGainEnabled);
 
             is_initialized = true;
@@ -205,6 +221,17 @@ namespace Banshee.GStreamer
             }
         }
 
+        private void SetupStreamCache ()
+        {
+            ulong max_size = (ulong)Math.Max (0, StreamCacheSizeSchema.Get ()) * 1024 * 1024;
+            IntPtr dir_ptr = GLib.Marshaller.StringToPtrGStrdup (Paths.Combine (Paths.ApplicationCache, "streams"));
+            try {
+                bp_set_download_cache (handle, dir_ptr, max_size);
+            } finally {
+                GLib.Marshaller.Free (dir_ptr);
+            }
+        }
+
         public override void Dispose ()
         {
             UninstallPreferences ();
@@ -469,6 +496,7 @@ namespace Banshee.GStreamer
             } else if (old_state == GstState.Paused && new_state == GstState.Playing && pending_state == GstState.VoidPending) {
                 if (CurrentState == PlayerState.Loaded) {
                     OnEventChanged (PlayerEvent.StartOfStream);
+                    RecordOpenTimings ();
                 }
                 OnStateChanged (PlayerState.Playing);
                 // Start iterating only when going to playing
@@ -485,6 +513,43 @@ namespace Banshee.GStreamer
             }
         }
 
+        // The first audible buffer reaches the sink only after the pipeline
+        // went to PLAYING, so wait a little for it before recording
+        private uint open_timings_timeout;
+        private int open_timings_polls;
+
+        private void RecordOpenTimings ()
+        {
+            if (Banshee.Metrics.BansheeMetrics.Instance == null) {
+                return;
+            }
+
+            open_timings_polls = 0;
+            if (open_timings_timeout == 0) {
+                open_timings_timeout = Application.RunTimeout (50, OnOpenTimingsTimeout);
+            }
+        }
+
+        private bool OnOpenTimingsTimeout ()
+        {
+            var timings = LastOpenTimings;
+            if (timings.FirstAudibleUs < 0 && ++open_timings_polls < 20) {
+                return true;
+            }
+
+            open_timings_timeout = 0;
+            var metrics = Banshee.Metrics.BansheeMetrics.Instance;
+            if (metrics == null || timings.FirstAudibleUs < 0) {
+                return false;
+            }
+
+            metrics.AddLatency ("PlayerEngine/OpenToSourceSetup", timings.SourceSetupUs / 1000.0);
+            metrics.AddLatency ("PlayerEngine/OpenToFirstDecoded", timings.FirstDecodedUs / 1000.0);
+            metrics.AddLatency ("PlayerEngine/OpenToAsyncDone", timings.AsyncDoneUs / 1000.0);
+            metrics.AddLatency ("PlayerEngine/OpenToFirstAudible", timings.FirstAudibleUs / 1000.0);
+            return false;
+        }
+
         private uint ready_timeout;
         private bool OnReadyTimeout ()
         {
@@ -606,6 +671,25 @@ namespace Banshee.GStreamer
             OnEventChanged (PlayerEvent.Volume);
         }
 
+        // Only called when the stream counts or the video geometry changed
+        private void OnStreamInfo (IntPtr player, int n_audio, int n_video, int n_text,
+            int width, int height, int fps_n, int fps_d, int par_n, int par_d)
+        {
+            StreamInfo info = new StreamInfo ();
+            info.AudioStreams = n_audio;
+            info.VideoStreams = n_video;
+            info.TextStreams = n_text;
+            info.Width = width;
+            info.Height = height;
+            info.FpsN = fps_n;
+            info.FpsD = fps_d;
+            info.ParN = par_n;
+            info.ParD = par_d;
+            stream_info = info;
+
+            TrackInfoUpdated ();
+        }
+
         private static StreamTag ProcessNativeTagResult (string tagName, ref GLib.Value valueRaw)
         {
             if (tagName == String.Empty || tagName == null) {
@@ -805,6 +889,233 @@ namespace Banshee.GStreamer
             get { return bp_dvd_is_menu (handle); }
         }
 
+        // Mirrors BpBufferingInfo; rates are in bytes per second
+        [StructLayout (LayoutKind.Sequential)]
+        public struct BufferingInfo
+        {
+            public int Percent;
+            public int DownloadRate;
+            public int Bitrate;
+            public long DurationMs;
+            public int Size;
+            public uint Rebuffers;
+        }
+
+        public BufferingInfo CurrentBufferingInfo {
+            get {
+                BufferingInfo info;
+                bp_get_buffering_info (handle, out info);
+                return info;
+            }
+        }
+
+        // Mirrors BpOpenTimings; microseconds after the open, -1 if not reached
+        [StructLayout (LayoutKind.Sequential)]
+        public struct OpenTimings
+        {
+            public long UriSetUs;
+            public long SourceSetupUs;
+            public long FirstDecodedUs;
+            public long AsyncDoneUs;
+            public long FirstAudibleUs;
+        }
+
+        public OpenTimings LastOpenTimings {
+            get {
+                OpenTimings timings;
+                bp_get_last_open_timings (handle, out timings);
+                return timings;
+            }
+        }
+
+        // Mirrors BpQueueHealth; overruns on a leaky queue are dropped buffers
+        [StructLayout (LayoutKind.Sequential)]
+        public struct QueueHealth
+        {
+            public long LevelTimeMs;
+            public uint LevelBytes;
+            public uint LevelBuffers;
+            public uint Overruns;
+            public uint Underruns;
+        }
+
+        // Mirrors BpTelemetry; counters restart with each opened stream
+        [StructLayout (LayoutKind.Sequential)]
+        public struct Telemetry
+        {
+            public QueueHealth ReadAhead;
+            public QueueHealth Sink;
+            public QueueHealth Visualization;
+            public long SinkLatencyUs;
+            public long SinkDriftUs;
+        }
+
+        public Telemetry CurrentTelemetry {
+            get {
+                Telemetry telemetry;
+                bp_get_telemetry (handle, out telemetry);
+                return telemetry;
+            }
+        }
+
+        // Stream counts and video geometry of the current stream, as last
+        // reported by libbanshee; the geometry is zero without video
+        public struct StreamInfo
+        {
+            public int AudioStreams;
+            public int VideoStreams;
+            public int TextStreams;
+            public int Width;
+            public int Height;
+            public int FpsN;
+            public int FpsD;
+            public int ParN;
+            public int ParD;
+        }
+
+        private StreamInfo stream_info;
+        public StreamInfo CurrentStreamInfo {
+            get { return stream_info; }
+        }
+
+        // Mirrors BpMeterSnapshot; levels in dBFS, loudness in LUFS, -120 for
+        // silence. RMS and peaks cover the time since the previous snapshot.
+        [StructLayout (LayoutKind.Sequential)]
+        public struct MeterSnapshot
+        {
+            public int Channels;
+            [MarshalAs (UnmanagedType.ByValArray, SizeConst = 8)]
+            public double [] RmsDb;
+            [MarshalAs (UnmanagedType.ByValArray, SizeConst = 8)]
+            public double [] PeakDb;
+            [MarshalAs (UnmanagedType.ByValArray, SizeConst = 8)]
+            public double [] TruePeakDb;
+            [MarshalAs (UnmanagedType.ByValArray, SizeConst = 8)]
+            public double [] MomentaryLufs;
+            public double MomentaryLufsTotal;
+        }
+
+        private bool metering_enabled;
+        public bool MeteringEnabled {
+            get { return metering_enabled; }
+            set {
+                metering_enabled = value;
+                bp_set_meter_enabled (handle, value);
+            }
+        }
+
+        // Cheap enough to poll from a UI timer; enable MeteringEnabled first
+        public MeterSnapshot Meter {
+            get {
+                MeterSnapshot snapshot;
+                bp_get_meter_snapshot (handle, out snapshot);
+                return snapshot;
+            }
+        }
+
+        // Mirrors BpOutputLatencyMode
+        public enum LatencyMode
+        {
+            Standard,
+            Low,
+            UltraLow
+        }
+
+        // Sizes the audio device buffer; takes effect with the next opened stream
+        public LatencyMode OutputLatencyMode {
+            get { return bp_get_output_latency_mode (handle); }
+            set {
+                bp_set_output_latency_mode (handle, value);
+                OutputLatencyModeSchema.Set (FormatOutputLatencyMode (value));
+            }
+        }
+
+        // How long a volume or equalizer change takes to be heard, as
+        // negotiated with the device; null while nothing is playing
+        public TimeSpan? OutputLatency {
+            get {
+                long latency_us = bp_get_output_latency (handle);
+                return latency_us < 0 ? (TimeSpan?)null : TimeSpan.FromTicks (latency_us * 10);
+            }
+        }
+
+        // Id of an OutputDeviceManager device, null for the default one.
+        // Switching keeps the position and decoders; only the sink is replaced.
+        // A device that is not available leaves the current one in place.
+        public string OutputDevice {
+            get { return output_device; }
+            set {
+                string device = String.IsNullOrEmpty (value) ? null : value;
+                IntPtr device_ptr = GLib.Marshaller.StringToPtrGStrdup (device);
+                bool switched;
+                try {
+                    switched = bp_set_output_device (handle, device_ptr);
+                } finally {
+                    GLib.Marshaller.Free (device_ptr);
+                }
+
+                if (!switched) {
+                    Log.WarningFormat ("GStreamer output device {0} is not available", device ?? "(default)");
+                    return;
+                }
+
+                output_device = device;
+                OutputDeviceSchema.Set (output_device ?? String.Empty);
+            }
+        }
+
+        // Also plays to another OutputDeviceManager device, in sync with the
+        // primary output; returns an id for the other output methods, or -1
+        public int AddOutput (string deviceId, double volume)
+        {
+            IntPtr device_ptr = GLib.Marshaller.StringToPtrGStrdup (deviceId);
+            try {
+                return bp_add_output (handle, device_ptr, volume);
+            } finally {
+                GLib.Marshaller.Free (device_ptr);
+            }
+        }
+
+        public bool RemoveOutput (int outputId)
+        {
+            return bp_remove_output (handle, outputId);
+        }
+
+        public void SetOutputVolume (int outputId, double volume)
+        {
+            bp_set_output_volume (handle, outputId, volume);
+        }
+
+        // Latency the device adds beyond what its sink reports, such as the
+        // buffer of a network speaker, so the other outputs wait for it
+        public void SetOutputDelay (int outputId, TimeSpan delay)
+        {
+            bp_set_output_delay (handle, outputId, delay.Ticks / 10);
+        }
+
+        public TimeSpan GetOutputCompensation (int outputId)
+        {
+            return TimeSpan.FromTicks (Math.Max (0, bp_get_output_compensation (handle, outputId)) * 10);
+        }
+
+        private static LatencyMode ParseOutputLatencyMode (string mode)
+        {
+            switch (mode) {
+                case "low": return LatencyMode.Low;
+                case "ultra-low": return LatencyMode.UltraLow;
+                default: return LatencyMode.Standard;
+            }
+        }
+
+        private static string FormatOutputLatencyMode (LatencyMode mode)
+        {
+            switch (mode) {
+                case LatencyMode.Low: return "low";
+                case LatencyMode.UltraLow: return "ultra-low";
+                default: return "standard";
+            }
+        }
+
 #region ISupportClutter
 
         private IntPtr clutter_video_sink;
@@ -832,6 +1143,22 @@ namespace Banshee.GStreamer
         }
 
 
+        public ClutterVideoSinkStats GetClutterVideoSinkStats ()
+        {
+            ClutterVideoSinkStats stats = new ClutterVideoSinkStats ();
+            if (IsClutterVideoSinkInitialized) {
+                clutter_gst_video_sink_get_stats (clutter_video_sink, out stats);
+            }
+            return stats;
+        }
+
+        public void ResetClutterVideoSinkStats ()
+        {
+            if (IsClutterVideoSinkInitialized) {
+                clutter_gst_video_sink_reset_stats (clutter_video_sink);
+            }
+        }
+
         private IntPtr OnVideoPipelineSetup (IntPtr player, IntPtr bus)
         {
             try {
@@ -913,6 +1240,34 @@ namespace Banshee.GStreamer
             "Eliminate the small playback gap on track change. Useful for concept albums and classical music"
         );
 
+        public static readonly SchemaEntry<int> CddaReadAheadSchema = new SchemaEntry<int> (
+            "player_engine", "cdda_read_ahead_seconds",
+            180,
+            "Audio CD read-ahead",
+            "Seconds of audio to read ahead of playback from audio CDs, so the drive can spin down (0 disables)"
+        );
+
+        public static readonly SchemaEntry<int> StreamCacheSizeSchema = new SchemaEntry<int> (
+            "player_engine", "stream_cache_size",
+            512,
+            "Stream cache size",
+            "Megabytes of downloaded podcasts and other remote streams kept on disk for replay and seeking (0 disables)"
+        );
+
+        public static readonly SchemaEntry<string> OutputDeviceSchema = new SchemaEntry<string> (
+            "player_engine", "output_device",
+            String.Empty,
+            "Audio output device",
+            "Id of the audio output device to play on; empty for the system default"
+        );
+
+        public static readonly SchemaEntry<string> OutputLatencyModeSchema = new SchemaEntry<string> (
+            "player_engine", "output_latency_mode",
+            "standard",
+            "Audio output latency",
+            "How much audio the sound device buffers: standard, low or ultra-low. Lower values make volume and equalizer changes heard sooner but may cause dropouts on busy systems"
+        );
+
 
 #endregion
 
@@ -958,6 +1313,10 @@ namespace Banshee.GStreamer
         private static extern void bp_set_next_track_starting_callback (HandleRef player,
             BansheePlayerNextTrackStartingCallback cb);
 
+        [DllImport ("libbanshee.dll")]
+        private static extern void bp_set_stream_info_callback (HandleRef player,
+            BansheePlayerStreamInfoCallback cb);
+
         [DllImport ("libbanshee.dll")]
         private static extern void bp_set_about_to_finish_callback (HandleRef player,
             BansheePlayerAboutToFinishCallback cb);
@@ -1053,9 +1412,64 @@ namespace Banshee.GStreamer
         [DllImport ("libbanshee.dll")]
         private static extern bool bp_replaygain_get_enabled (HandleRef player);
 
+        [DllImport ("libbanshee.dll")]
+        private static extern void bp_cdda_set_readahead (HandleRef player, uint seconds);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bp_set_download_cache (HandleRef player, IntPtr directory, ulong max_size);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bp_set_output_latency_mode (HandleRef player, LatencyMode mode);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern LatencyMode bp_get_output_latency_mode (HandleRef player);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern long bp_get_output_latency (HandleRef player);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern bool bp_set_output_device (HandleRef player, IntPtr device_id);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bp_set_meter_enabled (HandleRef player, bool enabled);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bp_get_meter_snapshot (HandleRef player, out MeterSnapshot snapshot);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern int bp_add_output (HandleRef player, IntPtr device_id, double volume);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern bool bp_remove_output (HandleRef player, int output_id);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bp_set_output_volume (HandleRef player, int output_id, double volume);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bp_set_output_delay (HandleRef player, int output_id, long delay_us);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern long bp_get_output_compensation (HandleRef player, int output_id);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bp_get_buffering_info (HandleRef player, out BufferingInfo info);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bp_get_last_open_timings (HandleRef player, out OpenTimings timings);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bp_get_telemetry (HandleRef player, out Telemetry telemetry);
+
         [DllImport ("libbanshee.dll")]
         private static extern IntPtr clutter_gst_video_sink_new (IntPtr texture);
 
+        [DllImport ("libbanshee.dll")]
+        private static extern void clutter_gst_video_sink_get_stats (IntPtr sink,
+            out ClutterVideoSinkStats stats);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void clutter_gst_video_sink_reset_stats (IntPtr sink);
+
         [DllImport ("libbanshee.dll")]
         private static extern int bp_get_subtitle_count (HandleRef player);
 
@@ -77,7 +77,19 @@ namespace Banshee.GStreamer
                 Pipeline.AddSExprFunction ("gst-construct-element", SExprConstructElement);
 
                 profile_manager.TestProfile += OnTestMediaProfile;
+
+                // Only pipelines not tested with the same set of plugins
+                // before actually get parsed
+                IntPtr path_ptr = GLib.Marshaller.StringToPtrGStrdup (
+                    Paths.Combine (Paths.ApplicationCache, "gstreamer-pipeline-tests"));
+                try {
+                    gstreamer_load_test_cache (path_ptr);
+                } finally {
+                    GLib.Marshaller.Free (path_ptr);
+                }
+
                 profile_manager.TestAll ();
+                gstreamer_save_test_cache ();
             }
         }
 
@@ -121,6 +133,12 @@ namespace Banshee.GStreamer
         [DllImport ("libbanshee.dll")]
         private static extern bool gstreamer_test_pipeline (IntPtr pipeline);
 
+        [DllImport ("libbanshee.dll")]
+        private static extern void gstreamer_load_test_cache (IntPtr path);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void gstreamer_save_test_cache ();
+
         internal static bool TestPipeline (string pipeline)
         {
             if (String.IsNullOrEmpty (pipeline)) {
@@ -48,6 +48,19 @@ namespace Banshee.GStreamer
             Merge (track);
         }
 
+        private TagList (IntPtr raw)
+        {
+            handle = new HandleRef (this, raw);
+        }
+
+        // Restores a list from a blob written by Serialize or TagListBlob.Write;
+        // returns null if the blob is malformed
+        public static TagList Deserialize (byte [] blob)
+        {
+            IntPtr raw = bt_tag_list_deserialize (blob, (uint)blob.Length);
+            return raw == IntPtr.Zero ? null : new TagList (raw);
+        }
+
         public void Merge (TrackInfo track)
         {
             AddTag (CommonTags.Artist, track.ArtistName);
@@ -92,6 +105,20 @@ namespace Banshee.GStreamer
             bt_tag_list_add_date (Handle, date.Year, date.Month, date.Day);
         }
 
+        public void AddDateTime (DateTime date)
+        {
+            date = date.ToUniversalTime ();
+            bt_tag_list_add_date_time (Handle, date.Year, date.Month, date.Day,
+                date.Hour, date.Minute, date.Second);
+        }
+
+        // Adds encoded image data as a front cover; returns false if the
+        // data is not a recognised image format
+        public bool AddImage (byte [] data)
+        {
+            return bt_tag_list_add_image (Handle, data, (uint)data.Length);
+        }
+
         public void AddYear (int year)
         {
             if (year > 1) {
@@ -105,6 +132,37 @@ namespace Banshee.GStreamer
             bt_tag_list_add_value (Handle, tagName, ref g_value);
         }
 
+        public byte [] Serialize ()
+        {
+            uint size;
+            IntPtr data = bt_tag_list_serialize (Handle, out size);
+            try {
+                byte [] blob = new byte[size];
+                Marshal.Copy (data, blob, 0, (int)size);
+                return blob;
+            } finally {
+                GLib.Marshaller.Free (data);
+            }
+        }
+
+        // Fetches the data behind an image reference read from this list's blob
+        public byte [] GetImage (TagListBlob.ImageReference image)
+        {
+            uint size;
+            IntPtr data = bt_tag_list_get_image (Handle, image.TagName, image.Index, out size);
+            if (data == IntPtr.Zero) {
+                return null;
+            }
+
+            try {
+                byte [] bytes = new byte[size];
+                Marshal.Copy (data, bytes, 0, (int)size);
+                return bytes;
+            } finally {
+                GLib.Marshaller.Free (data);
+            }
+        }
+
         public void Dispose ()
         {
             if (handle.Handle != IntPtr.Zero) {
@@ -130,5 +188,21 @@ namespace Banshee.GStreamer
 
         [DllImport ("libbanshee.dll")]
         private static extern void bt_tag_list_add_date (HandleRef tag_list, int year, int month, int day);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bt_tag_list_add_date_time (HandleRef tag_list, int year, int month, int day,
+            int hour, int minute, int second);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern bool bt_tag_list_add_image (HandleRef tag_list, byte [] data, uint size);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern IntPtr bt_tag_list_serialize (HandleRef tag_list, out uint size);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern IntPtr bt_tag_list_deserialize (byte [] data, uint size);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern IntPtr bt_tag_list_get_image (HandleRef tag_list, string tag_name, uint index, out uint size);
     }
 }
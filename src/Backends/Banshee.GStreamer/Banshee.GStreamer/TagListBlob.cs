@@ -0,0 +1,218 @@
+//
+// TagListBlob.cs
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Text;
+
+namespace Banshee.GStreamer
+{
+    // Reads and writes the binary tag list format of bt_tag_list_serialize
+    // without going through GStreamer, so blobs can be stored and inspected
+    // (e.g. as a metadata cache) with no native round trip
+    public static class TagListBlob
+    {
+        private static readonly byte [] Magic = Encoding.ASCII.GetBytes ("BTL1");
+
+        // Must match BtTagValueType in banshee-tagger.c
+        public enum ValueType : byte
+        {
+            String = 1,
+            UInt,
+            Int,
+            UInt64,
+            Int64,
+            Double,
+            Boolean,
+            Date,
+            DateTime,
+            ImageReference
+        }
+
+        public class ImageReference
+        {
+            public string TagName { get; internal set; }
+            public uint Index { get; internal set; }
+            public uint Size { get; internal set; }
+            public string MimeType { get; internal set; }
+        }
+
+        public class Entry
+        {
+            public Entry (string name, ValueType type, object value)
+            {
+                Name = name;
+                Type = type;
+                Value = value;
+            }
+
+            public Entry (string name, string value) : this (name, ValueType.String, value) {}
+            public Entry (string name, uint value) : this (name, ValueType.UInt, value) {}
+            public Entry (string name, int value) : this (name, ValueType.Int, value) {}
+            public Entry (string name, double value) : this (name, ValueType.Double, value) {}
+            public Entry (string name, bool value) : this (name, ValueType.Boolean, value) {}
+            public Entry (string name, DateTime value) : this (name, ValueType.Date, value) {}
+
+            public string Name { get; private set; }
+            public ValueType Type { get; private set; }
+
+            // A DateTime for Date, an ISO 8601 string for DateTime and an
+            // ImageReference for images; otherwise the matching CLR type
+            public object Value { get; private set; }
+        }
+
+        public static IList<Entry> Read (byte [] blob)
+        {
+            var entries = new List<Entry> ();
+
+            using (var reader = new BinaryReader (new MemoryStream (blob, false))) {
+                byte [] magic = reader.ReadBytes (Magic.Length);
+                for (int i = 0; i < Magic.Length; i++) {
+                    if (magic.Length != Magic.Length || magic[i] != Magic[i]) {
+                        throw new FormatException ("Not a tag list blob");
+                    }
+                }
+
+                try {
+                    uint count = reader.ReadUInt32 ();
+                    for (uint i = 0; i < count; i++) {
+                        string name = ReadString (reader, reader.ReadUInt16 ());
+                        var type = (ValueType)reader.ReadByte ();
+                        entries.Add (new Entry (name, type, ReadValue (reader, name, type)));
+                    }
+                } catch (EndOfStreamException e) {
+                    throw new FormatException ("Truncated tag list blob", e);
+                }
+            }
+
+            return entries;
+        }
+
+        public static byte [] Write (IEnumerable<Entry> entries)
+        {
+            using (var stream = new MemoryStream ()) {
+                var writer = new BinaryWriter (stream);
+                writer.Write (Magic);
+                writer.Write ((uint)0);
+
+                uint count = 0;
+                foreach (var entry in entries) {
+                    byte [] name = Encoding.UTF8.GetBytes (entry.Name);
+                    writer.Write ((ushort)name.Length);
+                    writer.Write (name);
+                    writer.Write ((byte)entry.Type);
+                    WriteValue (writer, entry);
+                    count++;
+                }
+
+                writer.Seek (Magic.Length, SeekOrigin.Begin);
+                writer.Write (count);
+                writer.Flush ();
+                return stream.ToArray ();
+            }
+        }
+
+        private static object ReadValue (BinaryReader reader, string name, ValueType type)
+        {
+            switch (type) {
+                case ValueType.String:
+                case ValueType.DateTime:
+                    return ReadString (reader, reader.ReadUInt32 ());
+                case ValueType.UInt: return reader.ReadUInt32 ();
+                case ValueType.Int: return reader.ReadInt32 ();
+                case ValueType.UInt64: return reader.ReadUInt64 ();
+                case ValueType.Int64: return reader.ReadInt64 ();
+                case ValueType.Double: return reader.ReadDouble ();
+                case ValueType.Boolean: return reader.ReadByte () != 0;
+                case ValueType.Date:
+                    int year = reader.ReadUInt16 ();
+                    int month = reader.ReadByte ();
+                    int day = reader.ReadByte ();
+                    if (year < 1 || month < 1 || month > 12 || day < 1 || day > DateTime.DaysInMonth (year, month)) {
+                        throw new FormatException (String.Format ("Invalid date {0}-{1}-{2} for tag {3}",
+                            year, month, day, name));
+                    }
+                    return new DateTime (year, month, day);
+                case ValueType.ImageReference:
+                    return new ImageReference () {
+                        TagName = name,
+                        Index = reader.ReadUInt32 (),
+                        Size = reader.ReadUInt32 (),
+                        MimeType = ReadString (reader, reader.ReadUInt32 ())
+                    };
+                default:
+                    throw new FormatException (String.Format ("Unknown tag value type {0}", (byte)type));
+            }
+        }
+
+        private static void WriteValue (BinaryWriter writer, Entry entry)
+        {
+            switch (entry.Type) {
+                case ValueType.String:
+                case ValueType.DateTime:
+                    WriteString (writer, (string)entry.Value);
+                    break;
+                case ValueType.UInt: writer.Write ((uint)entry.Value); break;
+                case ValueType.Int: writer.Write ((int)entry.Value); break;
+                case ValueType.UInt64: writer.Write ((ulong)entry.Value); break;
+                case ValueType.Int64: writer.Write ((long)entry.Value); break;
+                case ValueType.Double: writer.Write ((double)entry.Value); break;
+                case ValueType.Boolean: writer.Write ((byte)((bool)entry.Value ? 1 : 0)); break;
+                case ValueType.Date:
+                    var date = (DateTime)entry.Value;
+                    writer.Write ((ushort)date.Year);
+                    writer.Write ((byte)date.Month);
+                    writer.Write ((byte)date.Day);
+                    break;
+                case ValueType.ImageReference:
+                    var image = (ImageReference)entry.Value;
+                    writer.Write (image.Index);
+                    writer.Write (image.Size);
+                    WriteString (writer, image.MimeType);
+                    break;
+                default:
+                    throw new ArgumentException (String.Format ("Unknown tag value type {0}", (byte)entry.Type));
+            }
+        }
+
+        private static string ReadString (BinaryReader reader, uint length)
+        {
+            byte [] bytes = reader.ReadBytes ((int)length);
+            if (bytes.Length != length) {
+                throw new EndOfStreamException ();
+            }
+            return Encoding.UTF8.GetString (bytes);
+        }
+
+        private static void WriteString (BinaryWriter writer, string value)
+        {
+            byte [] bytes = value == null ? new byte[0] : Encoding.UTF8.GetBytes (value);
+            writer.Write ((uint)bytes.Length);
+            writer.Write (bytes);
+        }
+    }
+}
@@ -0,0 +1,186 @@
+//
+// TagListBlobTests.cs
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#if ENABLE_TESTS
+
+using System;
+using System.Collections.Generic;
+using NUnit.Framework;
+
+using Banshee.GStreamer;
+
+namespace Banshee.GStreamer.Tests
+{
+    [TestFixture]
+    public class TagListBlobTests
+    {
+        // A 1x1 transparent PNG
+        private static readonly byte [] Png = Convert.FromBase64String (
+            "iVBORw0KGgoAAAANSUhEUgAAAAEAAAABCAYAAAAfFcSJAAAADUlEQVR42mNkYPhfDwAChwGA60e6kgAAAABJRU5ErkJggg==");
+
+        private static TagList CreateTagList ()
+        {
+            var list = new TagList ();
+            list.AddTag ("title", "Título");
+            list.AddTag ("artist", "Artist");
+            list.AddTag ("track-number", (uint)7);
+            list.AddTag ("duration", (object)(ulong)123456789000);
+            list.AddTag ("beats-per-minute", (object)128.5);
+            list.AddDate (new DateTime (2011, 2, 28));
+            list.AddDateTime (new DateTime (2012, 3, 4, 5, 6, 7, DateTimeKind.Utc));
+            Assert.IsTrue (list.AddImage (Png));
+            return list;
+        }
+
+        private static Dictionary<string, TagListBlob.Entry> ByName (IList<TagListBlob.Entry> entries)
+        {
+            var by_name = new Dictionary<string, TagListBlob.Entry> ();
+            foreach (var entry in entries) {
+                by_name[entry.Name] = entry;
+            }
+            return by_name;
+        }
+
+        private static void AssertEntry (Dictionary<string, TagListBlob.Entry> entries, string name,
+            TagListBlob.ValueType type, object value)
+        {
+            Assert.IsTrue (entries.ContainsKey (name), name);
+            Assert.AreEqual (type, entries[name].Type, name);
+            Assert.AreEqual (value, entries[name].Value, name);
+        }
+
+        [Test]
+        public void ReadNativeBlob ()
+        {
+            using (var list = CreateTagList ()) {
+                var entries = ByName (TagListBlob.Read (list.Serialize ()));
+                Assert.AreEqual (8, entries.Count);
+
+                AssertEntry (entries, "title", TagListBlob.ValueType.String, "Título");
+                AssertEntry (entries, "artist", TagListBlob.ValueType.String, "Artist");
+                AssertEntry (entries, "track-number", TagListBlob.ValueType.UInt, (uint)7);
+                AssertEntry (entries, "duration", TagListBlob.ValueType.UInt64, (ulong)123456789000);
+                AssertEntry (entries, "beats-per-minute", TagListBlob.ValueType.Double, 128.5);
+                AssertEntry (entries, "date", TagListBlob.ValueType.Date, new DateTime (2011, 2, 28));
+                AssertEntry (entries, "datetime", TagListBlob.ValueType.DateTime, "2012-03-04T05:06:07Z");
+
+                Assert.AreEqual (TagListBlob.ValueType.ImageReference, entries["image"].Type);
+                var image = (TagListBlob.ImageReference)entries["image"].Value;
+                Assert.AreEqual ("image", image.TagName);
+                Assert.AreEqual (0, image.Index);
+                Assert.AreEqual (Png.Length, image.Size);
+                Assert.AreEqual ("image/png", image.MimeType);
+                Assert.AreEqual (Png, list.GetImage (image));
+            }
+        }
+
+        [Test]
+        public void WriteMatchesNative ()
+        {
+            using (var list = CreateTagList ()) {
+                byte [] blob = list.Serialize ();
+                Assert.AreEqual (blob, TagListBlob.Write (TagListBlob.Read (blob)));
+            }
+        }
+
+        [Test]
+        public void RoundTripThroughNative ()
+        {
+            IList<TagListBlob.Entry> original;
+            using (var list = CreateTagList ()) {
+                original = TagListBlob.Read (list.Serialize ());
+            }
+
+            // Image references only point into the list they were read from,
+            // so deserializing drops them
+            using (var list = TagList.Deserialize (TagListBlob.Write (original))) {
+                Assert.IsNotNull (list);
+                var entries = ByName (TagListBlob.Read (list.Serialize ()));
+                Assert.IsFalse (entries.ContainsKey ("image"));
+
+                foreach (var entry in original) {
+                    if (entry.Type != TagListBlob.ValueType.ImageReference) {
+                        AssertEntry (entries, entry.Name, entry.Type, entry.Value);
+                    }
+                }
+                Assert.AreEqual (original.Count - 1, entries.Count);
+            }
+        }
+
+        [Test]
+        public void RoundTripManagedValues ()
+        {
+            var entries = new List<TagListBlob.Entry> () {
+                new TagListBlob.Entry ("int", -42),
+                new TagListBlob.Entry ("int64", TagListBlob.ValueType.Int64, (long)-1 << 40),
+                new TagListBlob.Entry ("boolean", true),
+                new TagListBlob.Entry ("empty", "")
+            };
+
+            var read = ByName (TagListBlob.Read (TagListBlob.Write (entries)));
+            AssertEntry (read, "int", TagListBlob.ValueType.Int, -42);
+            AssertEntry (read, "int64", TagListBlob.ValueType.Int64, (long)-1 << 40);
+            AssertEntry (read, "boolean", TagListBlob.ValueType.Boolean, true);
+            AssertEntry (read, "empty", TagListBlob.ValueType.String, "");
+        }
+
+        [Test]
+        [ExpectedException (typeof (FormatException))]
+        public void ZeroMonthDate ()
+        {
+            TagListBlob.Read (DateBlob (2011, 0, 1));
+        }
+
+        [Test]
+        [ExpectedException (typeof (FormatException))]
+        public void ZeroDayDate ()
+        {
+            TagListBlob.Read (DateBlob (2011, 1, 0));
+        }
+
+        [Test]
+        [ExpectedException (typeof (FormatException))]
+        public void TruncatedBlob ()
+        {
+            byte [] blob = DateBlob (2011, 2, 28);
+            Array.Resize (ref blob, blob.Length - 1);
+            TagListBlob.Read (blob);
+        }
+
+        private static byte [] DateBlob (int year, int month, int day)
+        {
+            byte [] blob = TagListBlob.Write (new [] { new TagListBlob.Entry ("date", new DateTime (2000, 1, 1)) });
+
+            // The date is the last four bytes: year (uint16), month, day
+            blob[blob.Length - 4] = (byte)(year & 0xff);
+            blob[blob.Length - 3] = (byte)(year >> 8);
+            blob[blob.Length - 2] = (byte)month;
+            blob[blob.Length - 1] = (byte)day;
+            return blob;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,164 @@
+//
+// VideoThumbnailer.cs
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+using System;
+using System.Runtime.InteropServices;
+
+using Mono.Unix;
+
+using Hyena;
+
+namespace Banshee.GStreamer
+{
+    public class VideoThumbnailEventArgs : EventArgs
+    {
+        public VideoThumbnailEventArgs (int id, SafeUri uri, string path, string spritePath, string error)
+        {
+            Id = id;
+            Uri = uri;
+            Path = path;
+            SpritePath = spritePath;
+            Error = error;
+        }
+
+        public int Id { get; private set; }
+        public SafeUri Uri { get; private set; }
+
+        // null when the thumbnail could not be created, see Error
+        public string Path { get; private set; }
+
+        // null unless SpriteTiles is set and the duration is known
+        public string SpritePath { get; private set; }
+
+        public string Error { get; private set; }
+    }
+
+    // Creates PNG poster frames (and optionally seek bar sprites) in a cache
+    // directory, on a pool of native worker threads. ThumbnailFinished is
+    // raised on the main loop.
+    public class VideoThumbnailer : IDisposable
+    {
+        private HandleRef handle;
+        private ThumbnailerFinishedHandler finished_cb;
+
+        public event EventHandler<VideoThumbnailEventArgs> ThumbnailFinished;
+
+        public VideoThumbnailer (int width, int maxThreads)
+            : this (Paths.Combine (Paths.ApplicationCache, "video-thumbnails"), width, maxThreads)
+        {
+        }
+
+        public VideoThumbnailer (string cacheDirectory, int width, int maxThreads)
+        {
+            IntPtr dir_ptr = GLib.Marshaller.StringToPtrGStrdup (cacheDirectory);
+            try {
+                handle = new HandleRef (this, bvt_new (dir_ptr, width, maxThreads));
+            } finally {
+                GLib.Marshaller.Free (dir_ptr);
+            }
+
+            if (handle.Handle == IntPtr.Zero) {
+                throw new ApplicationException (Catalog.GetString ("Could not create the video thumbnailer."));
+            }
+
+            finished_cb = new ThumbnailerFinishedHandler (OnNativeFinished);
+            bvt_set_finished_callback (handle, finished_cb);
+        }
+
+        public void Dispose ()
+        {
+            if (handle.Handle != IntPtr.Zero) {
+                bvt_destroy (handle);
+                handle = new HandleRef (this, IntPtr.Zero);
+            }
+        }
+
+        // Number of frames in the seek bar sprite, 0 (the default) for none
+        public int SpriteTiles {
+            set { bvt_set_sprite_tiles (handle, value); }
+        }
+
+        // Queues a thumbnail of the frame at the key frame nearest to position,
+        // or a third into the video if position is null. Returns the id passed
+        // back in ThumbnailFinished.
+        public int Request (SafeUri uri, TimeSpan? position)
+        {
+            IntPtr uri_ptr = GLib.Marshaller.StringToPtrGStrdup (uri.AbsoluteUri);
+            try {
+                return bvt_request (handle, uri_ptr,
+                    position == null ? -1 : (long)position.Value.TotalMilliseconds);
+            } finally {
+                GLib.Marshaller.Free (uri_ptr);
+            }
+        }
+
+        // Drops the queued requests; their ThumbnailFinished is never raised
+        public void Cancel ()
+        {
+            bvt_cancel (handle);
+        }
+
+        private void OnNativeFinished (int id, IntPtr uri, IntPtr path, IntPtr spritePath, IntPtr error)
+        {
+            EventHandler<VideoThumbnailEventArgs> handler = ThumbnailFinished;
+            if (handler == null) {
+                return;
+            }
+
+            string error_message = GLib.Marshaller.Utf8PtrToString (error);
+            if (error_message != null) {
+                Log.DebugFormat ("Could not create a thumbnail for {0}: {1}",
+                    GLib.Marshaller.Utf8PtrToString (uri), error_message);
+            }
+
+            handler (this, new VideoThumbnailEventArgs (id,
+                new SafeUri (GLib.Marshaller.Utf8PtrToString (uri)),
+                GLib.Marshaller.Utf8PtrToString (path),
+                GLib.Marshaller.Utf8PtrToString (spritePath),
+                error_message));
+        }
+
+        [UnmanagedFunctionPointer (CallingConvention.Cdecl)]
+        private delegate void ThumbnailerFinishedHandler (int id, IntPtr uri, IntPtr path, IntPtr spritePath, IntPtr error);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern IntPtr bvt_new (IntPtr cacheDir, int width, int maxThreads);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bvt_destroy (HandleRef handle);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bvt_cancel (HandleRef handle);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern int bvt_request (HandleRef handle, IntPtr uri, long positionMs);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bvt_set_sprite_tiles (HandleRef handle, int tiles);
+
+        [DllImport ("libbanshee.dll")]
+        private static extern void bvt_set_finished_callback (HandleRef handle, ThumbnailerFinishedHandler callback);
+    }
+}
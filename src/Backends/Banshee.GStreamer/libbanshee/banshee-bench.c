@@ -0,0 +1,742 @@
+//
+// banshee-bench.c
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+// Headless benchmarks for libbanshee: drives the player, the BPM detector,
+// the transcoder and the ripper against fakesink, and writes the results
+// in the NUnit XML format tests/Analyzer reads, so runs can be compared
+// with tests/compare-perf-results. Every result is a time where lower is
+// better. Run it with `make bench`; the ripper is only measured when
+// BANSHEE_BENCH_CDDA_DEVICE names a drive with an audio CD in it. The
+// player plays to fakesink unless BANSHEE_BENCH_AUDIOSINK names another
+// sink factory.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <glib/gstdio.h>
+
+#include "banshee-player-private.h"
+#include "banshee-player-output.h"
+#include "banshee-services.h"
+
+#define BENCH_DEFAULT_RUNS       3
+#define BENCH_TIMEOUT            (30 * GST_SECOND)
+#define BENCH_SYNTHETIC_SECONDS  60
+#define BENCH_VIS_SECONDS        5
+#define BENCH_ENCODER            "audioconvert ! vorbisenc ! oggmux"
+#define BENCH_SWITCH_VOLUME      0.25
+
+typedef struct {
+    gchar *name;
+    gboolean executed;
+    gboolean success;
+    gdouble seconds;
+} BenchResult;
+
+// Filled in by the probe on the audiosink's pad, from the streaming thread
+static struct {
+    volatile gint armed;            // the next buffer's arrival is wanted
+    volatile gint arrived;          // and has been seen,
+    GstClockTime buffer_time;       // at this wall clock time
+    volatile gint streams;          // stream-start events seen
+    GstClockTime last_end;          // running time the last buffer ended at
+    GstClockTimeDiff gap;           // between the first two streams
+    volatile gint gap_measured;
+} sink_state;
+
+static GPtrArray *results;
+static volatile gint job_done;
+static gboolean job_failed;
+static gint ripped_msec;
+static const gchar *next_uri;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static void
+bench_add_result (const gchar *name, gboolean executed, gboolean success, gdouble seconds)
+{
+    BenchResult *result = g_new0 (BenchResult, 1);
+    result->name = g_strdup_printf ("libbanshee.%s", name);
+    result->executed = executed;
+    result->success = executed && success;
+    result->seconds = seconds;
+    g_ptr_array_add (results, result);
+
+    if (executed && !success) {
+        g_printerr ("%s failed\n", result->name);
+    }
+}
+
+// Runs the default main context until the flag is set or the timeout hits
+static gboolean
+bench_wait (volatile gint *flag, GstClockTime timeout)
+{
+    GstClockTime deadline = gst_util_get_timestamp () + timeout;
+
+    while (!g_atomic_int_get (flag)) {
+        if (gst_util_get_timestamp () > deadline) {
+            return FALSE;
+        }
+        while (g_main_context_iteration (NULL, FALSE));
+        g_usleep (1000);
+    }
+
+    return TRUE;
+}
+
+static gdouble
+bench_seconds_since (GstClockTime start)
+{
+    return (gdouble)(gst_util_get_timestamp () - start) / GST_SECOND;
+}
+
+static gdouble
+bench_media_seconds (const gchar *uri)
+{
+    GstDiscoverer *discoverer;
+    GstDiscovererInfo *info;
+    gdouble seconds = 0;
+
+    if ((discoverer = gst_discoverer_new (10 * GST_SECOND, NULL)) == NULL) {
+        return 0;
+    }
+
+    if ((info = gst_discoverer_discover_uri (discoverer, uri, NULL)) != NULL) {
+        seconds = (gdouble)gst_discoverer_info_get_duration (info) / GST_SECOND;
+        gst_discoverer_info_unref (info);
+    }
+
+    g_object_unref (discoverer);
+    return seconds;
+}
+
+// Encodes a minute of ticks with audiotestsrc, long enough for throughput
+// numbers that the short clips in tests/data can't give
+static gboolean
+bench_make_synthetic (const gchar *path)
+{
+    GstElement *pipeline;
+    GstMessage *message;
+    gchar *description;
+    gboolean success = FALSE;
+
+    description = g_strdup_printf ("audiotestsrc wave=ticks samplesperbuffer=4410 num-buffers=%d ! "
+        "audio/x-raw,rate=44100,channels=2 ! " BENCH_ENCODER " ! filesink location=\"%s\"",
+        BENCH_SYNTHETIC_SECONDS * 10, path);
+    pipeline = gst_parse_launch (description, NULL);
+    g_free (description);
+
+    if (pipeline == NULL) {
+        return FALSE;
+    }
+
+    gst_element_set_state (pipeline, GST_STATE_PLAYING);
+    message = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline), BENCH_TIMEOUT,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    if (message != NULL) {
+        success = GST_MESSAGE_TYPE (message) == GST_MESSAGE_EOS;
+        gst_message_unref (message);
+    }
+
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+    gst_object_unref (pipeline);
+    return success;
+}
+
+// ---------------------------------------------------------------------------
+// Player
+// ---------------------------------------------------------------------------
+
+static GstPadProbeReturn
+bench_sink_probe (GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+    GstBuffer *buffer;
+    GstEvent *event;
+    GstClockTime start, end;
+
+    if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_STREAM_START) {
+            g_atomic_int_inc (&sink_state.streams);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    if (g_atomic_int_get (&sink_state.armed)) {
+        sink_state.buffer_time = gst_util_get_timestamp ();
+        g_atomic_int_set (&sink_state.armed, 0);
+        g_atomic_int_set (&sink_state.arrived, 1);
+    }
+
+    if (!GST_BUFFER_PTS_IS_VALID (buffer) ||
+        (event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0)) == NULL) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    {
+        const GstSegment *segment;
+        gst_event_parse_segment (event, &segment);
+        start = gst_segment_to_running_time (segment, GST_FORMAT_TIME, GST_BUFFER_PTS (buffer));
+        end = start + (GST_BUFFER_DURATION_IS_VALID (buffer) ? GST_BUFFER_DURATION (buffer) : 0);
+    }
+    gst_event_unref (event);
+
+    // The first buffer after the second stream-start shows the gap
+    if (g_atomic_int_get (&sink_state.streams) > 1 && !g_atomic_int_get (&sink_state.gap_measured)) {
+        if (GST_CLOCK_TIME_IS_VALID (sink_state.last_end)) {
+            sink_state.gap = GST_CLOCK_DIFF (sink_state.last_end, start);
+            g_atomic_int_set (&sink_state.gap_measured, 1);
+        }
+    } else {
+        sink_state.last_end = end;
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+static void
+bench_sink_arm ()
+{
+    g_atomic_int_set (&sink_state.arrived, 0);
+    g_atomic_int_set (&sink_state.armed, 1);
+}
+
+static void
+bench_sink_reset ()
+{
+    bench_sink_arm ();
+    g_atomic_int_set (&sink_state.streams, 0);
+    g_atomic_int_set (&sink_state.gap_measured, 0);
+    sink_state.buffer_time = GST_CLOCK_TIME_NONE;
+    sink_state.last_end = GST_CLOCK_TIME_NONE;
+    sink_state.gap = 0;
+}
+
+static GstElement *
+bench_player_sink (BansheePlayer *player)
+{
+    GstElement *playbin = NULL, *audiobin = NULL, *audiotee = NULL;
+
+    if (!bp_get_pipeline_elements (player, &playbin, &audiobin, &audiotee) || audiobin == NULL) {
+        return NULL;
+    }
+
+    return gst_bin_get_by_name (GST_BIN (audiobin), "audiosink");
+}
+
+static void
+bench_about_to_finish (BansheePlayer *player)
+{
+    if (next_uri != NULL) {
+        bp_set_next_track (player, next_uri, FALSE);
+        next_uri = NULL;
+    }
+}
+
+static void
+bench_vis_data (BansheePlayer *player, gint channels, gint samples, gfloat *data, gint bands, gfloat *spectrum)
+{
+}
+
+// Opens the URI from a stopped player and waits for its first buffer to
+// reach the sink, returning the time that took or a negative value
+static gdouble
+bench_player_start (BansheePlayer *player, const gchar *uri)
+{
+    GstClockTime start;
+
+    bp_stop (player, TRUE);
+    bench_sink_reset ();
+
+    start = gst_util_get_timestamp ();
+    if (!bp_open (player, uri, FALSE)) {
+        return -1;
+    }
+    bp_play (player);
+
+    if (!bench_wait (&sink_state.arrived, BENCH_TIMEOUT)) {
+        return -1;
+    }
+
+    return (gdouble)(sink_state.buffer_time - start) / GST_SECOND;
+}
+
+static void
+bench_player_open (BansheePlayer *player, const gchar *uri)
+{
+    gdouble seconds = bench_player_start (player, uri);
+    bench_add_result ("Player.OpenToFirstBuffer", TRUE, seconds >= 0, seconds);
+}
+
+static void
+bench_player_seek (BansheePlayer *player, const gchar *uri)
+{
+    GstClockTime start;
+    guint64 duration;
+    gboolean success = FALSE;
+
+    if (bench_player_start (player, uri) >= 0 && (duration = bp_get_duration (player)) > 0) {
+        bench_sink_arm ();
+        start = gst_util_get_timestamp ();
+        if (bp_set_position (player, duration / 2, FALSE) &&
+            bench_wait (&sink_state.arrived, BENCH_TIMEOUT)) {
+            bench_add_result ("Player.SeekToFirstBuffer", TRUE, TRUE,
+                (gdouble)(sink_state.buffer_time - start) / GST_SECOND);
+            success = TRUE;
+        }
+    }
+
+    if (!success) {
+        bench_add_result ("Player.SeekToFirstBuffer", TRUE, FALSE, 0);
+    }
+}
+
+static void
+bench_player_gapless (BansheePlayer *player, const gchar *uri, const gchar *following_uri)
+{
+    gboolean success;
+
+    next_uri = following_uri;
+    bp_set_about_to_finish_callback (player, bench_about_to_finish);
+
+    success = bench_player_start (player, uri) >= 0 &&
+        bench_wait (&sink_state.gap_measured, BENCH_TIMEOUT);
+
+    bp_set_about_to_finish_callback (player, NULL);
+    next_uri = NULL;
+
+    // Overlaps count as much as silences
+    bench_add_result ("Player.GaplessGap", TRUE, success,
+        success ? (gdouble)ABS (sink_state.gap) / GST_SECOND : 0);
+}
+
+// Process CPU time spent playing in real time for a few seconds
+static gdouble
+bench_player_cpu_seconds (BansheePlayer *player, const gchar *uri)
+{
+    clock_t cpu_start;
+    GstClockTime start;
+
+    if (bench_player_start (player, uri) < 0) {
+        return -1;
+    }
+
+    cpu_start = clock ();
+    start = gst_util_get_timestamp ();
+    while (gst_util_get_timestamp () - start < BENCH_VIS_SECONDS * GST_SECOND) {
+        while (g_main_context_iteration (NULL, FALSE));
+        g_usleep (10000);
+    }
+
+    return (gdouble)(clock () - cpu_start) / CLOCKS_PER_SEC;
+}
+
+static void
+bench_player_vis (BansheePlayer *player, GstElement *sink, const gchar *uri)
+{
+    gdouble plain, vis;
+
+    // The visualization only costs anything when it runs in real time
+    g_object_set (sink, "sync", TRUE, NULL);
+
+    plain = bench_player_cpu_seconds (player, uri);
+    bp_set_vis_data_callback (player, bench_vis_data);
+    vis = bench_player_cpu_seconds (player, uri);
+    bp_set_vis_data_callback (player, NULL);
+
+    g_object_set (sink, "sync", FALSE, NULL);
+
+    // CPU seconds per minute of playback
+    bench_add_result ("Player.VisualizationCpu", TRUE, plain >= 0 && vis >= 0,
+        MAX (0, vis - plain) * 60 / BENCH_VIS_SECONDS);
+}
+
+// Switches the stopped player to the first real output device and back to
+// the default one, checking the volume is still applied after each switch.
+// Not run without a device; nothing is played.
+static void
+bench_player_output_switch (BansheePlayer *player)
+{
+    BansheeOutputDeviceInfo *devices;
+    GstClockTime start;
+    gboolean success;
+    gint count;
+
+    devices = bom_get_devices (&count);
+    if (count == 0) {
+        bench_add_result ("Player.OutputSwitch", FALSE, FALSE, 0);
+        bom_free_devices (devices, count);
+        return;
+    }
+
+    bp_stop (player, TRUE);
+    bp_set_volume (player, BENCH_SWITCH_VOLUME);
+
+    start = gst_util_get_timestamp ();
+    success = bp_set_output_device (player, devices[0].id) &&
+        ABS (_bp_output_get_applied_volume (player) - BENCH_SWITCH_VOLUME) < 0.001;
+    success = success && bp_set_output_device (player, NULL) &&
+        ABS (_bp_output_get_applied_volume (player) - BENCH_SWITCH_VOLUME) < 0.001;
+
+    if (!success) {
+        g_printerr ("Volume %f after switching outputs, expected %f\n",
+            _bp_output_get_applied_volume (player), BENCH_SWITCH_VOLUME);
+    }
+    bench_add_result ("Player.OutputSwitch", TRUE, success, bench_seconds_since (start));
+
+    bom_free_devices (devices, count);
+}
+
+static void
+bench_player (GPtrArray *uris, const gchar *synthetic_uri, gint runs)
+{
+    BansheePlayer *player;
+    GstElement *sink;
+    GstPad *pad;
+    guint i;
+    gint run;
+
+    player = bp_new ();
+
+    // Nothing should be heard, and no audio device is needed
+    if (player != NULL) {
+        const gchar *audiosink = g_getenv ("BANSHEE_BENCH_AUDIOSINK");
+        bp_set_audiosink_factory (player, audiosink != NULL ? audiosink : "fakesink");
+    }
+
+    if (player == NULL || !bp_initialize_pipeline (player) || (sink = bench_player_sink (player)) == NULL) {
+        g_printerr ("Could not construct the player pipeline\n");
+        return;
+    }
+
+    g_object_set (sink, "sync", FALSE, NULL);
+    pad = gst_element_get_static_pad (sink, "sink");
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+        bench_sink_probe, NULL, NULL);
+    gst_object_unref (pad);
+
+    for (run = 0; run < runs; run++) {
+        for (i = 0; i < uris->len; i++) {
+            bench_player_open (player, g_ptr_array_index (uris, i));
+            bench_player_seek (player, g_ptr_array_index (uris, i));
+            if (uris->len > 1) {
+                bench_player_gapless (player, g_ptr_array_index (uris, i),
+                    g_ptr_array_index (uris, (i + 1) % uris->len));
+            }
+        }
+        bench_player_vis (player, sink, synthetic_uri);
+    }
+
+    // Last, since it leaves the player on a real device
+    bench_player_output_switch (player);
+
+    bp_stop (player, TRUE);
+    gst_object_unref (sink);
+    bp_destroy (player);
+}
+
+// ---------------------------------------------------------------------------
+// BPM Detector, Transcoder and Ripper
+// ---------------------------------------------------------------------------
+
+static void
+bench_job_finished ()
+{
+    g_atomic_int_set (&job_done, 1);
+}
+
+static void
+bench_job_failed (const gchar *error)
+{
+    g_printerr ("%s\n", error);
+    job_failed = TRUE;
+    g_atomic_int_set (&job_done, 1);
+}
+
+static void
+bench_bpm_error (const gchar *error, const gchar *debug)
+{
+    bench_job_failed (error);
+}
+
+static void
+bench_transcoder_finished (GstTranscoder *transcoder)
+{
+    bench_job_finished ();
+}
+
+static void
+bench_transcoder_error (GstTranscoder *transcoder, const gchar *error, const gchar *debug)
+{
+    bench_job_failed (error);
+}
+
+static void
+bench_ripper_finished (BansheeRipper *ripper)
+{
+    bench_job_finished ();
+}
+
+static void
+bench_ripper_error (BansheeRipper *ripper, const gchar *error, const gchar *debug)
+{
+    bench_job_failed (error);
+}
+
+static void
+bench_ripper_progress (BansheeRipper *ripper, gint msec, gpointer user_info)
+{
+    ripped_msec = msec;
+}
+
+// Turns the wall time a job took into seconds per minute of audio
+static void
+bench_add_job_result (const gchar *name, gboolean started, GstClockTime start, gdouble media_seconds)
+{
+    gboolean success = started && bench_wait (&job_done, 10 * BENCH_TIMEOUT) && !job_failed && media_seconds > 0;
+    bench_add_result (name, TRUE, success, success ? bench_seconds_since (start) * 60 / media_seconds : 0);
+}
+
+static void
+bench_bpm_detector (const gchar *path, gdouble media_seconds)
+{
+    BansheeBpmDetector *detector = bbd_new ();
+    GstClockTime start;
+
+    bbd_set_finished_callback (detector, bench_job_finished);
+    bbd_set_error_callback (detector, bench_bpm_error);
+
+    job_done = 0;
+    job_failed = FALSE;
+    start = gst_util_get_timestamp ();
+    bench_add_job_result ("BpmDetector.SecondsPerMinute", bbd_process_file (detector, path), start, media_seconds);
+
+    bbd_destroy (detector);
+}
+
+static void
+bench_transcoder (const gchar *uri, const gchar *output_uri, gdouble media_seconds)
+{
+    GstTranscoder *transcoder = gst_transcoder_new ();
+    GstClockTime start;
+
+    gst_transcoder_set_finished_callback (transcoder, bench_transcoder_finished);
+    gst_transcoder_set_error_callback (transcoder, bench_transcoder_error);
+
+    job_done = 0;
+    job_failed = FALSE;
+    start = gst_util_get_timestamp ();
+    gst_transcoder_transcode (transcoder, uri, output_uri, BENCH_ENCODER);
+    bench_add_job_result ("Transcoder.SecondsPerMinute", TRUE, start, media_seconds);
+
+    gst_transcoder_free (transcoder);
+}
+
+static void
+bench_ripper (const gchar *device, const gchar *output_path)
+{
+    BansheeRipper *ripper;
+    GstClockTime start;
+    gboolean tagging_supported = FALSE;
+
+    if (device == NULL) {
+        bench_add_result ("Ripper.SecondsPerMinute", FALSE, FALSE, 0);
+        return;
+    }
+
+    ripper = br_new ((gchar *)device, 0, BENCH_ENCODER);
+    br_set_progress_callback (ripper, bench_ripper_progress);
+    br_set_finished_callback (ripper, bench_ripper_finished);
+    br_set_error_callback (ripper, bench_ripper_error);
+
+    job_done = 0;
+    job_failed = FALSE;
+    ripped_msec = 0;
+    start = gst_util_get_timestamp ();
+    if (br_rip_track (ripper, 1, (gchar *)output_path, NULL, &tagging_supported) &&
+        bench_wait (&job_done, 10 * BENCH_TIMEOUT) && !job_failed && ripped_msec > 0) {
+        bench_add_result ("Ripper.SecondsPerMinute", TRUE, TRUE,
+            bench_seconds_since (start) * 60000 / ripped_msec);
+    } else {
+        bench_add_result ("Ripper.SecondsPerMinute", TRUE, FALSE, 0);
+    }
+
+    br_destroy (ripper);
+}
+
+// ---------------------------------------------------------------------------
+// Output
+// ---------------------------------------------------------------------------
+
+static void
+bench_write_results (FILE *out)
+{
+    gchar time_buffer[G_ASCII_DTOSTR_BUF_SIZE];
+    guint i, failures = 0, not_run = 0;
+
+    for (i = 0; i < results->len; i++) {
+        BenchResult *result = g_ptr_array_index (results, i);
+        failures += result->executed && !result->success;
+        not_run += !result->executed;
+    }
+
+    fprintf (out, "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n");
+    fprintf (out, "<test-results name=\"libbanshee\" total=\"%u\" failures=\"%u\" not-run=\"%u\">\n",
+        results->len, failures, not_run);
+    fprintf (out, "  <test-suite name=\"libbanshee\" success=\"%s\">\n", failures == 0 ? "True" : "False");
+    fprintf (out, "    <results>\n");
+
+    for (i = 0; i < results->len; i++) {
+        BenchResult *result = g_ptr_array_index (results, i);
+        // Not locale dependent, the analyzer parses these
+        g_ascii_formatd (time_buffer, sizeof (time_buffer), "%.6f", result->seconds);
+        fprintf (out, "      <test-case name=\"%s\" executed=\"%s\" success=\"%s\" time=\"%s\" asserts=\"0\" />\n",
+            result->name, result->executed ? "True" : "False", result->success ? "True" : "False", time_buffer);
+    }
+
+    fprintf (out, "    </results>\n");
+    fprintf (out, "  </test-suite>\n");
+    fprintf (out, "</test-results>\n");
+}
+
+// ---------------------------------------------------------------------------
+// Main
+// ---------------------------------------------------------------------------
+
+int
+main (int argc, char **argv)
+{
+    const gchar *output_path = NULL;
+    const gchar *data_dir = ".";
+    GPtrArray *uris;
+    GDir *dir;
+    const gchar *name;
+    gchar *current_dir, *tmp_dir, *synthetic_path, *synthetic_uri, *transcode_uri, *rip_path;
+    gdouble synthetic_seconds;
+    FILE *out = stdout;
+    gint runs = BENCH_DEFAULT_RUNS;
+    gint i, status;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp (argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = MAX (1, atoi (argv[++i]));
+        } else if (strcmp (argv[i], "--output") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (argv[i][0] == '-') {
+            g_printerr ("Usage: %s [--runs N] [--output FILE] [DATA-DIR]\n", argv[0]);
+            return 1;
+        } else {
+            data_dir = argv[i];
+        }
+    }
+
+    gstreamer_initialize (FALSE, NULL);
+    banshee_gst_wait_initialized ();
+
+    results = g_ptr_array_new ();
+    uris = g_ptr_array_new ();
+
+    current_dir = g_get_current_dir ();
+    if ((dir = g_dir_open (data_dir, 0, NULL)) != NULL) {
+        while ((name = g_dir_read_name (dir)) != NULL) {
+            if (g_str_has_suffix (name, ".ogg") || g_str_has_suffix (name, ".mp3")) {
+                gchar *path = g_build_filename (data_dir, name, NULL);
+                gchar *absolute = g_path_is_absolute (path) ? g_strdup (path)
+                    : g_build_filename (current_dir, path, NULL);
+                g_ptr_array_add (uris, g_filename_to_uri (absolute, NULL, NULL));
+                g_free (absolute);
+                g_free (path);
+            }
+        }
+        g_dir_close (dir);
+    }
+
+    if (uris->len == 0) {
+        g_printerr ("No Ogg or MP3 files found in %s\n", data_dir);
+        return 1;
+    }
+
+    tmp_dir = g_build_filename (g_get_tmp_dir (), "banshee-bench", NULL);
+    if (g_mkdir_with_parents (tmp_dir, 0700) != 0) {
+        g_printerr ("Could not create a temporary directory\n");
+        return 1;
+    }
+
+    synthetic_path = g_build_filename (tmp_dir, "synthetic.ogg", NULL);
+    rip_path = g_build_filename (tmp_dir, "ripped.ogg", NULL);
+    synthetic_uri = g_filename_to_uri (synthetic_path, NULL, NULL);
+    {
+        gchar *transcode_path = g_build_filename (tmp_dir, "transcoded.ogg", NULL);
+        transcode_uri = g_filename_to_uri (transcode_path, NULL, NULL);
+        g_free (transcode_path);
+    }
+
+    if (!bench_make_synthetic (synthetic_path)) {
+        g_printerr ("Could not encode the synthetic source\n");
+        return 1;
+    }
+    synthetic_seconds = bench_media_seconds (synthetic_uri);
+
+    bench_player (uris, synthetic_uri, runs);
+
+    for (i = 0; i < runs; i++) {
+        bench_bpm_detector (synthetic_path, synthetic_seconds);
+        bench_transcoder (synthetic_uri, transcode_uri, synthetic_seconds);
+        bench_ripper (g_getenv ("BANSHEE_BENCH_CDDA_DEVICE"), rip_path);
+    }
+
+    if (output_path != NULL && (out = fopen (output_path, "w")) == NULL) {
+        g_printerr ("Could not write %s\n", output_path);
+        return 1;
+    }
+
+    bench_write_results (out);
+    if (out != stdout) {
+        fclose (out);
+    }
+
+    status = 0;
+    for (i = 0; i < (gint)results->len; i++) {
+        BenchResult *result = g_ptr_array_index (results, i);
+        if (result->executed && !result->success) {
+            status = 1;
+        }
+    }
+
+    g_unlink (synthetic_path);
+    g_unlink (rip_path);
+    {
+        gchar *transcode_path = g_filename_from_uri (transcode_uri, NULL, NULL);
+        g_unlink (transcode_path);
+        g_free (transcode_path);
+    }
+    g_rmdir (tmp_dir);
+
+    return status;
+}
@@ -36,12 +36,7 @@
 
 #include "banshee-gst.h"
 #include "banshee-tagger.h"
-
-typedef struct BansheeBpmDetector BansheeBpmDetector;
-
-typedef void (* BansheeBpmDetectorFinishedCallback) ();
-typedef void (* BansheeBpmDetectorProgressCallback) (double bpm);
-typedef void (* BansheeBpmDetectorErrorCallback)    (const gchar *error, const gchar *debug);
+#include "banshee-services.h"
 
 // Only analyze 20 seconds of audio per song
 #define BPM_DETECT_ANALYSIS_DURATION_MS 20*1000
@@ -298,6 +293,8 @@ bbd_process_file (BansheeBpmDetector *detector, const gchar *path)
 
     g_return_val_if_fail (detector != NULL, FALSE);
 
+    banshee_gst_wait_initialized ();
+
     if (!bbd_pipeline_construct (detector)) {
         return FALSE;
     }
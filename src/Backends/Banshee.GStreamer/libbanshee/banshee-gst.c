@@ -34,17 +34,90 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
+#include <sys/stat.h>
 
+#include <glib/gstdio.h>
 #include <gst/gst.h>
 #include <gst/pbutils/pbutils.h>
 
 #include "banshee-gst.h"
 
+// Must be a power of two
+#define BANSHEE_TRACE_RING_SIZE 4096
+
+typedef struct {
+    // Index + 1 of the record in the slot, 0 while it is being written
+    volatile gint sequence;
+    BansheeTraceRecord record;
+} BansheeTraceSlot;
+
 static gboolean gstreamer_initialized = FALSE;
-static gboolean banshee_debugging;
+static GOnce gstreamer_init_once = G_ONCE_INIT;
+gboolean banshee_debugging;
+gboolean banshee_tracing = FALSE;
 static BansheeLogHandler banshee_log_handler = NULL;
 static gint banshee_version = -1;
 
+static BansheeTraceSlot banshee_trace_ring[BANSHEE_TRACE_RING_SIZE];
+static volatile gint banshee_trace_next = 0;
+
+// Pipeline test results by MD5 of the pipeline, see gstreamer_load_test_cache
+G_LOCK_DEFINE_STATIC (test_cache);
+static GHashTable *test_cache = NULL;
+static gchar *test_cache_path = NULL;
+static gboolean test_cache_dirty = FALSE;
+
+typedef enum {
+    BANSHEE_PIPELINE_INVALID,
+    BANSHEE_PIPELINE_VALID,
+    BANSHEE_PIPELINE_UNKNOWN
+} BansheePipelineCheck;
+
+typedef struct {
+    GstElementFactory *factory;
+    GstCaps *sink_caps; // Union of the pad templates, NULL if there are none
+    GstCaps *src_caps;
+} BansheeFactoryCaps;
+
+// Factory name -> BansheeFactoryCaps, or NULL for a missing factory. Only
+// valid for one registry feature list cookie.
+G_LOCK_DEFINE_STATIC (factory_cache);
+static GHashTable *factory_cache = NULL;
+static guint32 factory_cache_cookie = 0;
+
+static const gchar *banshee_trace_components[] = { "player", "cdda", "subtitle" };
+static const gchar *banshee_trace_events[] = {
+    "open", "state-changed", "buffering", "seek", "eos", "error", "underrun", "attach"
+};
+
+static gpointer
+gstreamer_init_func (gpointer data)
+{
+    // Loads (and when plugins changed, rebuilds) the registry, which is most
+    // of the GStreamer startup cost
+    gst_init (NULL, NULL);
+    
+    gst_pb_utils_init ();
+
+    return NULL;
+}
+
+static gpointer
+gstreamer_init_thread (gpointer data)
+{
+    g_once (&gstreamer_init_once, gstreamer_init_func, NULL);
+    return NULL;
+}
+
+// Blocks until GStreamer is initialized; every entry point that uses
+// GStreamer calls this first. If the worker didn't get to it yet, the
+// caller initializes GStreamer itself.
+void
+banshee_gst_wait_initialized ()
+{
+    g_once (&gstreamer_init_once, gstreamer_init_func, NULL);
+}
+
 MYEXPORT void
 gstreamer_initialize (gboolean debugging, BansheeLogHandler log_handler)
 {
@@ -54,27 +127,417 @@ gstreamer_initialize (gboolean debugging, BansheeLogHandler log_handler)
     
     banshee_debugging = debugging;
     banshee_log_handler = log_handler;
+    banshee_tracing = g_getenv ("BANSHEE_GST_TRACE") != NULL;
 
-    gst_init (NULL, NULL);
-    
-    gst_pb_utils_init ();
-    
     gstreamer_initialized = TRUE;
+
+    // Don't hold up startup, the registry is ready long before the first
+    // player or pipeline test needs it
+#if GLIB_CHECK_VERSION(2,32,0)
+    g_thread_unref (g_thread_new ("gst-init", gstreamer_init_thread, NULL));
+#else
+    if (g_thread_create (gstreamer_init_thread, NULL, FALSE, NULL) == NULL) {
+        banshee_gst_wait_initialized ();
+    }
+#endif
+}
+
+// Identifies the plugin set the cached test results are valid for: the
+// GStreamer version, the registry's mtime and the number of plugins
+static gchar *
+gstreamer_registry_key ()
+{
+    const gchar *path, *name;
+    gchar *dir_path, *file_path, *key;
+    GList *plugins;
+    struct stat info;
+    time_t mtime = 0;
+    guint major, minor, micro, nano;
+    GDir *dir;
+
+    path = g_getenv ("GST_REGISTRY_1_0");
+    if (path == NULL) {
+        path = g_getenv ("GST_REGISTRY");
+    }
+
+    if (path != NULL) {
+        if (g_stat (path, &info) == 0) {
+            mtime = info.st_mtime;
+        }
+    } else {
+        // registry.<arch>.bin, there may be one per architecture
+        dir_path = g_build_filename (g_get_user_cache_dir (), "gstreamer-1.0", NULL);
+        dir = g_dir_open (dir_path, 0, NULL);
+        while (dir != NULL && (name = g_dir_read_name (dir)) != NULL) {
+            if (!g_str_has_prefix (name, "registry.")) {
+                continue;
+            }
+            file_path = g_build_filename (dir_path, name, NULL);
+            if (g_stat (file_path, &info) == 0 && info.st_mtime > mtime) {
+                mtime = info.st_mtime;
+            }
+            g_free (file_path);
+        }
+        if (dir != NULL) {
+            g_dir_close (dir);
+        }
+        g_free (dir_path);
+    }
+
+    plugins = gst_registry_get_plugin_list (gst_registry_get ());
+    gst_version (&major, &minor, &micro, &nano);
+
+    key = g_strdup_printf ("%u.%u.%u.%u %ld %u", major, minor, micro, nano,
+        (glong)mtime, g_list_length (plugins));
+
+    gst_plugin_list_free (plugins);
+    return key;
+}
+
+// Loads the pipeline test results persisted at path by a previous run,
+// unless the installed plugins changed since
+MYEXPORT void
+gstreamer_load_test_cache (const gchar *path)
+{
+    GKeyFile *key_file;
+    gchar *key, *cached_key, **pipelines;
+    gsize i, count = 0;
+
+    g_return_if_fail (path != NULL);
+
+    banshee_gst_wait_initialized ();
+
+    G_LOCK (test_cache);
+
+    if (test_cache == NULL) {
+        test_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    }
+    g_hash_table_remove_all (test_cache);
+    g_free (test_cache_path);
+    test_cache_path = g_strdup (path);
+    test_cache_dirty = FALSE;
+
+    key_file = g_key_file_new ();
+    if (g_key_file_load_from_file (key_file, path, G_KEY_FILE_NONE, NULL)) {
+        key = gstreamer_registry_key ();
+        cached_key = g_key_file_get_string (key_file, "registry", "key", NULL);
+
+        if (cached_key != NULL && strcmp (key, cached_key) == 0) {
+            pipelines = g_key_file_get_keys (key_file, "pipelines", &count, NULL);
+            for (i = 0; i < count; i++) {
+                g_hash_table_insert (test_cache, g_strdup (pipelines[i]),
+                    GINT_TO_POINTER (g_key_file_get_boolean (key_file, "pipelines", pipelines[i], NULL) ? 2 : 1));
+            }
+            g_strfreev (pipelines);
+        } else {
+            banshee_log_debug ("gst", "Plugins changed, testing pipelines again");
+            test_cache_dirty = TRUE;
+        }
+
+        g_free (cached_key);
+        g_free (key);
+    }
+    g_key_file_free (key_file);
+
+    G_UNLOCK (test_cache);
+}
+
+MYEXPORT void
+gstreamer_save_test_cache ()
+{
+    GHashTableIter iter;
+    GKeyFile *key_file;
+    gpointer pipeline, result;
+    gchar *key, *data, *dir;
+    gsize length;
+
+    G_LOCK (test_cache);
+
+    if (test_cache == NULL || test_cache_path == NULL || !test_cache_dirty) {
+        G_UNLOCK (test_cache);
+        return;
+    }
+
+    key_file = g_key_file_new ();
+    key = gstreamer_registry_key ();
+    g_key_file_set_string (key_file, "registry", "key", key);
+    g_free (key);
+
+    g_hash_table_iter_init (&iter, test_cache);
+    while (g_hash_table_iter_next (&iter, &pipeline, &result)) {
+        g_key_file_set_boolean (key_file, "pipelines", pipeline, GPOINTER_TO_INT (result) == 2);
+    }
+
+    data = g_key_file_to_data (key_file, &length, NULL);
+    dir = g_path_get_dirname (test_cache_path);
+    g_mkdir_with_parents (dir, 0700);
+    if (g_file_set_contents (test_cache_path, data, length, NULL)) {
+        test_cache_dirty = FALSE;
+    }
+    g_free (dir);
+    g_free (data);
+    g_key_file_free (key_file);
+
+    G_UNLOCK (test_cache);
+}
+
+static void
+gstreamer_factory_caps_free (BansheeFactoryCaps *caps)
+{
+    if (caps == NULL) {
+        return;
+    }
+
+    gst_object_unref (caps->factory);
+    if (caps->sink_caps != NULL) {
+        gst_caps_unref (caps->sink_caps);
+    }
+    if (caps->src_caps != NULL) {
+        gst_caps_unref (caps->src_caps);
+    }
+    g_slice_free (BansheeFactoryCaps, caps);
+}
+
+// Looks a factory up in the cached registry snapshot, reading its static
+// pad templates the first time. Called with the factory_cache lock held.
+static BansheeFactoryCaps *
+gstreamer_factory_caps_lookup (const gchar *name)
+{
+    BansheeFactoryCaps *caps;
+    GstElementFactory *factory;
+    const GList *templates;
+    guint32 cookie;
+
+    cookie = gst_registry_get_feature_list_cookie (gst_registry_get ());
+    if (factory_cache == NULL || cookie != factory_cache_cookie) {
+        if (factory_cache != NULL) {
+            g_hash_table_destroy (factory_cache);
+        }
+        factory_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+            (GDestroyNotify)gstreamer_factory_caps_free);
+        factory_cache_cookie = cookie;
+    }
+
+    if (g_hash_table_lookup_extended (factory_cache, name, NULL, (gpointer *)&caps)) {
+        return caps;
+    }
+
+    factory = gst_element_factory_find (name);
+    if (factory == NULL) {
+        g_hash_table_insert (factory_cache, g_strdup (name), NULL);
+        return NULL;
+    }
+
+    caps = g_slice_new0 (BansheeFactoryCaps);
+    caps->factory = factory;
+
+    for (templates = gst_element_factory_get_static_pad_templates (factory);
+        templates != NULL; templates = templates->next) {
+        GstStaticPadTemplate *template = (GstStaticPadTemplate *)templates->data;
+        GstCaps **all = template->direction == GST_PAD_SINK ? &caps->sink_caps : &caps->src_caps;
+        GstCaps *template_caps = gst_static_pad_template_get_caps (template);
+
+        *all = *all == NULL ? template_caps : gst_caps_merge (*all, template_caps);
+    }
+
+    g_hash_table_insert (factory_cache, g_strdup (name), caps);
+    return caps;
+}
+
+// Splits at the links, skipping '!' in quoted property values
+static gchar **
+gstreamer_pipeline_split (const gchar *pipeline)
+{
+    GPtrArray *parts = g_ptr_array_new ();
+    const gchar *start = pipeline, *p;
+    gboolean quoted = FALSE;
+
+    for (p = pipeline; ; p++) {
+        if (*p == '"' && (p == pipeline || p[-1] != '\\')) {
+            quoted = !quoted;
+        } else if ((*p == '!' && !quoted) || *p == '\0') {
+            g_ptr_array_add (parts, g_strstrip (g_strndup (start, p - start)));
+            if (*p == '\0') {
+                break;
+            }
+            start = p + 1;
+        }
+    }
+
+    g_ptr_array_add (parts, NULL);
+    return (gchar **)g_ptr_array_free (parts, FALSE);
+}
+
+// Checks a linear pipeline of factories and caps filters against the
+// factories' pad templates, without loading plugins or instantiating
+// elements. Templates are what the elements can do at best, so
+// incompatible templates mean the pipeline can't link, but anything the
+// simple model doesn't cover (bins, references to named elements, pads,
+// property values) is left to gst_parse_launch. Only chains without
+// element arguments are ever reported as valid.
+static BansheePipelineCheck
+gstreamer_check_pipeline (const gchar *pipeline)
+{
+    BansheePipelineCheck result = BANSHEE_PIPELINE_VALID;
+    gboolean unverified = FALSE;
+    GstCaps *current = NULL;
+    gchar **parts;
+    gint i;
+
+    if (strpbrk (pipeline, "()[]{}") != NULL) {
+        return BANSHEE_PIPELINE_UNKNOWN;
+    }
+
+    parts = gstreamer_pipeline_split (pipeline);
+
+    G_LOCK (factory_cache);
+
+    for (i = 0; parts[i] != NULL && result == BANSHEE_PIPELINE_VALID; i++) {
+        BansheeFactoryCaps *caps;
+        gchar **argv = NULL;
+        gint argc, j;
+
+        if (parts[i][0] == '\0') {
+            result = BANSHEE_PIPELINE_INVALID;
+            break;
+        }
+
+        if (!g_shell_parse_argv (parts[i], &argc, &argv, NULL)) {
+            result = BANSHEE_PIPELINE_UNKNOWN;
+            break;
+        }
+
+        if (strchr (argv[0], '/') != NULL) {
+            // Caps filter, e.g. audio/x-raw,rate=44100
+            GstCaps *filter = gst_caps_from_string (parts[i]);
+
+            if (filter == NULL) {
+                result = BANSHEE_PIPELINE_UNKNOWN;
+            } else if (current != NULL) {
+                GstCaps *filtered = gst_caps_intersect (current, filter);
+                gst_caps_unref (current);
+                gst_caps_unref (filter);
+                current = filtered;
+                if (gst_caps_is_empty (current)) {
+                    result = BANSHEE_PIPELINE_INVALID;
+                }
+            } else {
+                current = filter;
+            }
+
+            g_strfreev (argv);
+            continue;
+        }
+
+        if (strchr (argv[0], '.') != NULL || strchr (argv[0], '=') != NULL) {
+            // A reference to a named element or pad
+            result = BANSHEE_PIPELINE_UNKNOWN;
+            g_strfreev (argv);
+            break;
+        }
+
+        caps = gstreamer_factory_caps_lookup (argv[0]);
+        if (caps == NULL) {
+            result = BANSHEE_PIPELINE_INVALID;
+        } else if (i > 0 && (caps->sink_caps == NULL ||
+            (current != NULL && !gst_caps_can_intersect (current, caps->sink_caps)))) {
+            result = BANSHEE_PIPELINE_INVALID;
+        } else if (argc > 1) {
+            // Property values are never checked, so arguments at best leave
+            // the result unknown. Names can be ruled out cheaply when the
+            // plugin is already loaded.
+            GObjectClass *klass = NULL;
+
+            unverified = TRUE;
+            if (gst_plugin_feature_is_loaded (GST_PLUGIN_FEATURE (caps->factory))) {
+                klass = g_type_class_peek (gst_element_factory_get_element_type (caps->factory));
+            }
+
+            for (j = 1; j < argc && klass != NULL; j++) {
+                gchar *name = g_strndup (argv[j], strcspn (argv[j], "="));
+                if (argv[j][strlen (name)] == '=' && g_object_class_find_property (klass, name) == NULL) {
+                    result = BANSHEE_PIPELINE_INVALID;
+                }
+                g_free (name);
+            }
+        }
+
+        if (current != NULL) {
+            gst_caps_unref (current);
+            current = NULL;
+        }
+        if (caps != NULL && caps->src_caps != NULL) {
+            current = gst_caps_ref (caps->src_caps);
+        } else if (parts[i + 1] != NULL && result == BANSHEE_PIPELINE_VALID) {
+            // A sink in the middle of the pipeline
+            result = BANSHEE_PIPELINE_INVALID;
+        }
+
+        g_strfreev (argv);
+    }
+
+    G_UNLOCK (factory_cache);
+
+    if (current != NULL) {
+        gst_caps_unref (current);
+    }
+    g_strfreev (parts);
+
+    return result == BANSHEE_PIPELINE_VALID && unverified ? BANSHEE_PIPELINE_UNKNOWN : result;
 }
 
 MYEXPORT gboolean 
 gstreamer_test_pipeline (gchar *pipeline)
 {
+    BansheePipelineCheck check;
     GstElement *element = NULL;
     GError *error = NULL;
-    
-    element = gst_parse_launch (pipeline, &error);
+    gchar *checksum;
+    gpointer cached;
 
-    if (element != NULL) {
-        gst_object_unref (GST_OBJECT (element));
+    banshee_gst_wait_initialized ();
+
+    // Cached results are 2 for pass, 1 for fail; pipelines can contain
+    // characters not allowed in key file keys, so key them by checksum
+    checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, pipeline, -1);
+
+    G_LOCK (test_cache);
+    cached = test_cache != NULL ? g_hash_table_lookup (test_cache, checksum) : NULL;
+    G_UNLOCK (test_cache);
+
+    if (cached != NULL) {
+        g_free (checksum);
+        return GPOINTER_TO_INT (cached) == 2;
+    }
+
+    // Only build the element graph when the static check can't tell
+    check = gstreamer_check_pipeline (pipeline);
+    if (check == BANSHEE_PIPELINE_INVALID) {
+        error = g_error_new_literal (GST_PARSE_ERROR, GST_PARSE_ERROR_LINK,
+            "pipeline failed the static check");
+    } else if (check == BANSHEE_PIPELINE_UNKNOWN) {
+        element = gst_parse_launch (pipeline, &error);
+
+        if (element != NULL) {
+            gst_object_unref (GST_OBJECT (element));
+        }
+    }
+
+    G_LOCK (test_cache);
+    if (test_cache != NULL) {
+        g_hash_table_insert (test_cache, checksum, GINT_TO_POINTER (error == NULL ? 2 : 1));
+        test_cache_dirty = TRUE;
+        checksum = NULL;
+    }
+    G_UNLOCK (test_cache);
+    g_free (checksum);
+
+    if (error != NULL) {
+        g_error_free (error);
+        return FALSE;
     }
     
-    return error == NULL;
+    return TRUE;
 }
 
 MYEXPORT gchar *
@@ -144,3 +607,88 @@ banshee_log_debug (const gchar *component, const gchar *format, ...)
     
     g_free (message);
 }
+
+void
+banshee_trace_record (BansheeTraceComponent component, BansheeTraceEvent event, gint64 a, gint64 b)
+{
+    BansheeTraceSlot *slot;
+    guint index;
+
+    // Claiming the slot is the only synchronization; writers never wait on
+    // each other or on a dump, a record being overwritten is simply skipped
+#if GLIB_CHECK_VERSION(2,30,0)
+    index = (guint)g_atomic_int_add (&banshee_trace_next, 1);
+#else
+    index = (guint)g_atomic_int_exchange_and_add (&banshee_trace_next, 1);
+#endif
+    slot = &banshee_trace_ring[index & (BANSHEE_TRACE_RING_SIZE - 1)];
+
+    g_atomic_int_set (&slot->sequence, 0);
+    slot->record.timestamp = gst_util_get_timestamp ();
+    slot->record.component = component;
+    slot->record.event = event;
+    slot->record.a = a;
+    slot->record.b = b;
+    g_atomic_int_set (&slot->sequence, (gint)(index + 1));
+}
+
+MYEXPORT void
+banshee_trace_set_enabled (gboolean enabled)
+{
+    banshee_tracing = enabled;
+}
+
+MYEXPORT guint
+banshee_trace_get_records (BansheeTraceRecord *records, guint length)
+{
+    guint next, first, index, count = 0;
+
+    g_return_val_if_fail (records != NULL || length == 0, 0);
+
+    next = (guint)g_atomic_int_get (&banshee_trace_next);
+    first = next > BANSHEE_TRACE_RING_SIZE ? next - BANSHEE_TRACE_RING_SIZE : 0;
+    if (next - first > length) {
+        first = next - length;
+    }
+
+    for (index = first; index != next; index++) {
+        BansheeTraceSlot *slot = &banshee_trace_ring[index & (BANSHEE_TRACE_RING_SIZE - 1)];
+
+        if ((guint)g_atomic_int_get (&slot->sequence) != index + 1) {
+            continue;
+        }
+
+        records[count] = slot->record;
+
+        // Overwritten while we were copying it
+        if ((guint)g_atomic_int_get (&slot->sequence) != index + 1) {
+            continue;
+        }
+
+        count++;
+    }
+
+    return count;
+}
+
+MYEXPORT void
+banshee_trace_dump ()
+{
+    BansheeTraceRecord *records = g_new (BansheeTraceRecord, BANSHEE_TRACE_RING_SIZE);
+    guint i, count = banshee_trace_get_records (records, BANSHEE_TRACE_RING_SIZE);
+
+    for (i = 0; i < count; i++) {
+        BansheeTraceRecord *record = &records[i];
+        gchar *message = g_strdup_printf ("[trace] %" GST_TIME_FORMAT " %s %s %" G_GINT64_FORMAT " %" G_GINT64_FORMAT,
+            GST_TIME_ARGS (record->timestamp),
+            record->component < G_N_ELEMENTS (banshee_trace_components)
+                ? banshee_trace_components[record->component] : "?",
+            record->event < G_N_ELEMENTS (banshee_trace_events)
+                ? banshee_trace_events[record->event] : "?",
+            record->a, record->b);
+        banshee_log (BANSHEE_LOG_TYPE_DEBUG, "trace", message);
+        g_free (message);
+    }
+
+    g_free (records);
+}
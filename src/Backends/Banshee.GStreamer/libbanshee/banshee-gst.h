@@ -64,11 +64,67 @@ typedef enum {
 
 typedef void (* BansheeLogHandler) (BansheeLogType type, const gchar *component, const gchar *message);
 
+typedef enum {
+    BANSHEE_TRACE_PLAYER,
+    BANSHEE_TRACE_CDDA,
+    BANSHEE_TRACE_SUBTITLE
+} BansheeTraceComponent;
+
+typedef enum {
+    BANSHEE_TRACE_EVENT_OPEN,          // a: maybe video
+    BANSHEE_TRACE_EVENT_STATE_CHANGED, // a: old state, b: new state
+    BANSHEE_TRACE_EVENT_BUFFERING,     // a: percent, b: download rate (B/s)
+    BANSHEE_TRACE_EVENT_SEEK,          // a: position (ms), b: accurate
+    BANSHEE_TRACE_EVENT_EOS,
+    BANSHEE_TRACE_EVENT_ERROR,         // a: domain, b: code
+    BANSHEE_TRACE_EVENT_UNDERRUN,      // a: queued (ms)
+    BANSHEE_TRACE_EVENT_ATTACH         // a: attached
+} BansheeTraceEvent;
+
+typedef struct {
+    guint64 timestamp;
+    guint16 component;
+    guint16 event;
+    gint64 a;
+    gint64 b;
+} BansheeTraceRecord;
+
+// Debug messages are only formatted (and their arguments only evaluated)
+// when the managed side asked for debugging; define BANSHEE_DISABLE_DEBUG
+// to compile them out altogether
+#ifdef BANSHEE_DISABLE_DEBUG
+#define BANSHEE_DEBUG_ENABLED FALSE
+#else
+#define BANSHEE_DEBUG_ENABLED G_UNLIKELY (banshee_debugging)
+#endif
+
+// Trace records are cheap enough for streaming threads: a few stores into
+// a fixed ring, no allocation, no locking. Enabled by BANSHEE_GST_TRACE in
+// the environment; define BANSHEE_DISABLE_TRACE to compile them out.
+#ifdef BANSHEE_DISABLE_TRACE
+#define banshee_trace(component, event, a, b) G_STMT_START { } G_STMT_END
+#else
+#define banshee_trace(component, event, a, b) G_STMT_START { \
+    if (G_UNLIKELY (banshee_tracing)) { \
+        banshee_trace_record ((component), (event), (a), (b)); \
+    } \
+} G_STMT_END
+#endif
+
+extern gboolean banshee_debugging;
+extern gboolean banshee_tracing;
+
 MYEXPORT void
 gstreamer_initialize (gboolean debugging, BansheeLogHandler log_handler);
+void      banshee_gst_wait_initialized ();
 gboolean  banshee_is_debugging ();
 guint     banshee_get_version_number ();
 
 void      banshee_log_debug (const gchar *component, const gchar *format, ...);
 
+void      banshee_trace_record (BansheeTraceComponent component, BansheeTraceEvent event, gint64 a, gint64 b);
+MYEXPORT void  banshee_trace_set_enabled (gboolean enabled);
+MYEXPORT guint banshee_trace_get_records (BansheeTraceRecord *records, guint length);
+MYEXPORT void  banshee_trace_dump ();
+
 #endif /* _BANSHEE_GST_H */
@@ -0,0 +1,376 @@
+//
+// banshee-output-manager.c
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+#include <gst/gst.h>
+
+#include "banshee-gst.h"
+#include "banshee-output-manager.h"
+#include "banshee-services.h"
+
+// Keeps one process wide list of audio outputs from GstDeviceMonitor, so
+// players can build the sink for a device directly instead of having
+// autoaudiosink probe for one every time a pipeline is constructed.
+// Hot-plug messages arrive on the default main context.
+
+static void
+bom_device_info_clear (BansheeOutputDeviceInfo *info)
+{
+    g_free (info->id);
+    g_free (info->display_name);
+    g_free (info->caps);
+}
+
+#if GST_CHECK_VERSION(1,4,0)
+
+typedef struct {
+    GstDevice *device;
+    BansheeOutputDeviceInfo info;
+} BomDevice;
+
+G_LOCK_DEFINE_STATIC (bom_devices);
+static GstDeviceMonitor *bom_monitor = NULL;
+static gboolean bom_monitor_failed = FALSE;
+static GList *bom_devices = NULL;
+static BansheeOutputDevicesChangedCallback bom_changed_cb = NULL;
+
+// Device properties that name the device in a way that survives restarts,
+// in order of preference: PipeWire, PulseAudio, ALSA
+static const gchar *bom_id_properties[] = {
+    "node.name",
+    "device.string",
+    "alsa.name",
+    NULL
+};
+
+// ---------------------------------------------------------------------------
+// Private Functions
+// ---------------------------------------------------------------------------
+
+static gchar *
+bom_device_make_id (GstDevice *device)
+{
+    GstStructure *props = gst_device_get_properties (device);
+    gchar *id = NULL;
+    gint i;
+
+    for (i = 0; props != NULL && bom_id_properties[i] != NULL && id == NULL; i++) {
+        const gchar *value = gst_structure_get_string (props, bom_id_properties[i]);
+        if (value != NULL) {
+            id = g_strdup (value);
+        }
+    }
+
+    if (id == NULL) {
+        id = gst_device_get_display_name (device);
+    }
+
+    if (props != NULL) {
+        gst_structure_free (props);
+    }
+
+    return id;
+}
+
+// Building the element only instantiates it; the device is not opened
+static BomDevice *
+bom_device_new (GstDevice *device)
+{
+    BomDevice *bom_device = g_new0 (BomDevice, 1);
+    GstStructure *props;
+    GstElement *sink;
+    GstCaps *caps;
+    GParamSpec *pspec;
+
+    bom_device->device = gst_object_ref (device);
+    bom_device->info.id = bom_device_make_id (device);
+    bom_device->info.display_name = gst_device_get_display_name (device);
+    bom_device->info.latency_us = -1;
+
+    if ((caps = gst_device_get_caps (device)) != NULL) {
+        bom_device->info.caps = gst_caps_to_string (caps);
+        gst_caps_unref (caps);
+    }
+
+    if ((props = gst_device_get_properties (device)) != NULL) {
+        gst_structure_get_boolean (props, "is-default", &bom_device->info.is_default);
+        gst_structure_free (props);
+    }
+
+    if ((sink = gst_device_create_element (device, NULL)) != NULL) {
+        bom_device->info.has_volume = g_object_class_find_property (G_OBJECT_GET_CLASS (sink), "volume") != NULL;
+        if ((pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (sink), "buffer-time")) != NULL &&
+            G_IS_PARAM_SPEC_INT64 (pspec)) {
+            bom_device->info.latency_us = G_PARAM_SPEC_INT64 (pspec)->default_value;
+        }
+        gst_object_unref (sink);
+    }
+
+    return bom_device;
+}
+
+static void
+bom_device_free (BomDevice *bom_device)
+{
+    bom_device_info_clear (&bom_device->info);
+    gst_object_unref (bom_device->device);
+    g_free (bom_device);
+}
+
+// Called with the lock held; NULL picks the default device, or the first
+// one if no provider marks a default
+static BomDevice *
+bom_find_device (const gchar *device_id)
+{
+    GList *node;
+
+    for (node = bom_devices; node != NULL; node = node->next) {
+        BomDevice *bom_device = (BomDevice *)node->data;
+        if (device_id == NULL ? bom_device->info.is_default : strcmp (device_id, bom_device->info.id) == 0) {
+            return bom_device;
+        }
+    }
+
+    return device_id == NULL && bom_devices != NULL ? (BomDevice *)bom_devices->data : NULL;
+}
+
+static gboolean
+bom_bus_callback (GstBus *bus, GstMessage *message, gpointer userdata)
+{
+    GstDevice *device = NULL;
+    GList *node;
+    gboolean changed = FALSE;
+
+    switch (GST_MESSAGE_TYPE (message)) {
+        case GST_MESSAGE_DEVICE_ADDED:
+            gst_message_parse_device_added (message, &device);
+            G_LOCK (bom_devices);
+            // Providers also announce the devices of the initial probe
+            changed = TRUE;
+            for (node = bom_devices; node != NULL && changed; node = node->next) {
+                changed = ((BomDevice *)node->data)->device != device;
+            }
+            if (changed) {
+                BomDevice *bom_device = bom_device_new (device);
+                bom_devices = g_list_append (bom_devices, bom_device);
+                banshee_log_debug ("output", "Output device added: %s", bom_device->info.id);
+            }
+            G_UNLOCK (bom_devices);
+            break;
+        case GST_MESSAGE_DEVICE_REMOVED:
+            gst_message_parse_device_removed (message, &device);
+            G_LOCK (bom_devices);
+            for (node = bom_devices; node != NULL; node = node->next) {
+                BomDevice *bom_device = (BomDevice *)node->data;
+                if (bom_device->device == device) {
+                    banshee_log_debug ("output", "Output device removed: %s", bom_device->info.id);
+                    bom_devices = g_list_delete_link (bom_devices, node);
+                    bom_device_free (bom_device);
+                    changed = TRUE;
+                    break;
+                }
+            }
+            G_UNLOCK (bom_devices);
+            break;
+        default:
+            break;
+    }
+
+    if (device != NULL) {
+        gst_object_unref (device);
+    }
+
+    if (changed && bom_changed_cb != NULL) {
+        bom_changed_cb ();
+    }
+
+    return TRUE;
+}
+
+// Probes the providers once; afterwards the list is kept current by the
+// bus watch. Returns FALSE when no provider could be started, in which
+// case players fall back to autodetection.
+static gboolean
+bom_ensure_started ()
+{
+    GList *devices, *node;
+    GstBus *bus;
+    gboolean started;
+
+    banshee_gst_wait_initialized ();
+
+    G_LOCK (bom_devices);
+    if (bom_monitor != NULL || bom_monitor_failed) {
+        G_UNLOCK (bom_devices);
+        return !bom_monitor_failed;
+    }
+
+    bom_monitor = gst_device_monitor_new ();
+    gst_device_monitor_add_filter (bom_monitor, "Audio/Sink", NULL);
+
+    // Devices already present are taken from the initial probe, so the
+    // list is complete on return
+    bus = gst_device_monitor_get_bus (bom_monitor);
+    started = gst_device_monitor_start (bom_monitor);
+    if (started) {
+        devices = gst_device_monitor_get_devices (bom_monitor);
+        for (node = devices; node != NULL; node = node->next) {
+            bom_devices = g_list_append (bom_devices, bom_device_new (GST_DEVICE (node->data)));
+            gst_object_unref (node->data);
+        }
+        g_list_free (devices);
+        gst_bus_add_watch (bus, bom_bus_callback, NULL);
+    } else {
+        // Not retried; no provider is going to appear later in the process
+        gst_object_unref (bom_monitor);
+        bom_monitor = NULL;
+        bom_monitor_failed = TRUE;
+    }
+    gst_object_unref (bus);
+
+    banshee_log_debug ("output", "Output device monitor %s, %d devices",
+        started ? "started" : "unavailable", g_list_length (bom_devices));
+    G_UNLOCK (bom_devices);
+
+    return started;
+}
+
+// ---------------------------------------------------------------------------
+// Internal Functions
+// ---------------------------------------------------------------------------
+
+// Builds the sink for a device from the cached list. For NULL it builds
+// the sink of the default device's provider without pinning the device,
+// so playback keeps following the system default. Returns NULL if the
+// device is unknown or there is no monitor.
+GstElement *
+bom_create_sink (const gchar *device_id, gboolean *has_volume)
+{
+    BomDevice *bom_device;
+    GstElement *sink = NULL;
+
+    if (!bom_ensure_started ()) {
+        return NULL;
+    }
+
+    G_LOCK (bom_devices);
+    if ((bom_device = bom_find_device (device_id)) != NULL) {
+        sink = gst_device_create_element (bom_device->device, "audiosink");
+        if (sink != NULL && device_id == NULL) {
+            GstElement *device_sink = sink;
+            sink = gst_element_factory_create (gst_element_get_factory (device_sink), "audiosink");
+            gst_object_unref (device_sink);
+        }
+        if (sink != NULL && has_volume != NULL) {
+            *has_volume = bom_device->info.has_volume;
+        }
+    }
+    G_UNLOCK (bom_devices);
+
+    return sink;
+}
+
+// ---------------------------------------------------------------------------
+// Public Functions
+// ---------------------------------------------------------------------------
+
+// Returns a snapshot of the device list, to free with bom_free_devices
+BansheeOutputDeviceInfo *
+bom_get_devices (gint *count)
+{
+    BansheeOutputDeviceInfo *infos;
+    GList *node;
+    gint i = 0;
+
+    *count = 0;
+
+    if (!bom_ensure_started ()) {
+        return NULL;
+    }
+
+    G_LOCK (bom_devices);
+    *count = g_list_length (bom_devices);
+    infos = g_new0 (BansheeOutputDeviceInfo, MAX (*count, 1));
+    for (node = bom_devices; node != NULL; node = node->next, i++) {
+        BansheeOutputDeviceInfo *info = &((BomDevice *)node->data)->info;
+        infos[i] = *info;
+        infos[i].id = g_strdup (info->id);
+        infos[i].display_name = g_strdup (info->display_name);
+        infos[i].caps = g_strdup (info->caps);
+    }
+    G_UNLOCK (bom_devices);
+
+    return infos;
+}
+
+void
+bom_set_devices_changed_callback (BansheeOutputDevicesChangedCallback cb)
+{
+    bom_changed_cb = cb;
+}
+
+#else
+
+// GstDeviceMonitor needs GStreamer 1.4; players autodetect their sink
+
+GstElement *
+bom_create_sink (const gchar *device_id, gboolean *has_volume)
+{
+    return NULL;
+}
+
+BansheeOutputDeviceInfo *
+bom_get_devices (gint *count)
+{
+    *count = 0;
+    return NULL;
+}
+
+void
+bom_set_devices_changed_callback (BansheeOutputDevicesChangedCallback cb)
+{
+}
+
+#endif
+
+void
+bom_free_devices (BansheeOutputDeviceInfo *infos, gint count)
+{
+    gint i;
+
+    if (infos == NULL) {
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        bom_device_info_clear (&infos[i]);
+    }
+
+    g_free (infos);
+}
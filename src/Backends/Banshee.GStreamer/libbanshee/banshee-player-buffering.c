@@ -0,0 +1,248 @@
+//
+// banshee-player-buffering.c
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "banshee-player-buffering.h"
+
+// Bounds of the buffer the controller may ask for; the size is derived
+// from the duration and the stream bitrate, and is what keeps the memory
+// use bounded for high bitrate streams
+#define BP_BUFFERING_MIN_DURATION     (2 * GST_SECOND)
+#define BP_BUFFERING_DEFAULT_DURATION (5 * GST_SECOND)
+#define BP_BUFFERING_MAX_DURATION     (60 * GST_SECOND)
+#define BP_BUFFERING_MIN_SIZE         (64 * 1024)
+#define BP_BUFFERING_DEFAULT_SIZE     (2 * 1024 * 1024)
+#define BP_BUFFERING_MAX_SIZE         (16 * 1024 * 1024)
+
+// Time without an underrun after which the buffer is shrunk again
+#define BP_BUFFERING_STABLE_TIME      (120 * GST_SECOND)
+
+// Playback resumes before the buffer is full once it holds this much and
+// data comes in this many times faster than it is played
+#define BP_BUFFERING_EARLY_RESUME_PERCENT 30
+#define BP_BUFFERING_EARLY_RESUME_RATIO   1.5
+
+// After an early resume, the level may drop this much before playback is
+// paused again
+#define BP_BUFFERING_HYSTERESIS_PERCENT   10
+
+// ---------------------------------------------------------------------------
+// Private Functions
+// ---------------------------------------------------------------------------
+
+static void
+bp_buffering_apply (BansheePlayer *player, GstElement *queue)
+{
+    gint64 size;
+
+    size = player->buffering_bitrate > 0
+        ? gst_util_uint64_scale (player->buffering_duration, player->buffering_bitrate, GST_SECOND)
+        : BP_BUFFERING_DEFAULT_SIZE;
+    player->buffering_size = (gint)CLAMP (size, BP_BUFFERING_MIN_SIZE, BP_BUFFERING_MAX_SIZE);
+
+    // playbin hands these to the queue2 of the next stream it sets up
+    g_object_set (player->playbin,
+        "buffer-duration", (gint64)player->buffering_duration,
+        "buffer-size", player->buffering_size,
+        NULL);
+
+    // and the queue2 buffering the current stream is updated directly
+    if (queue != NULL) {
+        g_object_set (queue,
+            "max-size-time", (guint64)player->buffering_duration,
+            "max-size-bytes", (guint)player->buffering_size,
+            NULL);
+
+        if (g_object_class_find_property (G_OBJECT_GET_CLASS (queue), "ring-buffer-max-size") != NULL) {
+            guint64 ring_buffer_max_size = 0;
+            g_object_get (queue, "ring-buffer-max-size", &ring_buffer_max_size, NULL);
+            // Only touch it in download mode, 0 disables the ring buffer
+            if (ring_buffer_max_size > 0) {
+                g_object_set (queue, "ring-buffer-max-size", (guint64)player->buffering_size, NULL);
+            }
+        }
+    }
+
+    bp_debug3 ("[buffering] asking for %" G_GINT64_FORMAT " ms / %d bytes",
+        (gint64)(player->buffering_duration / GST_MSECOND), player->buffering_size);
+}
+
+// Grows the buffer after an underrun, shrinks it after a long stretch of
+// smooth playback, and sizes it from the observed bitrate either way
+static void
+bp_buffering_adapt (BansheePlayer *player, GstElement *queue, gboolean underrun)
+{
+    GstClockTime now = gst_util_get_timestamp ();
+    GstClockTime duration = player->buffering_duration;
+
+    if (underrun) {
+        player->buffering_rebuffers++;
+        player->buffering_stable_since = now;
+
+        // The slower the link compared to the stream, the more the buffer
+        // needs to absorb
+        duration *= 2;
+        if (player->buffering_download_rate > 0 && player->buffering_bitrate > player->buffering_download_rate) {
+            duration += BP_BUFFERING_DEFAULT_DURATION;
+        }
+    } else if (now - player->buffering_stable_since > BP_BUFFERING_STABLE_TIME) {
+        player->buffering_stable_since = now;
+        duration /= 2;
+    }
+
+    duration = CLAMP (duration, BP_BUFFERING_MIN_DURATION, BP_BUFFERING_MAX_DURATION);
+    if (duration != player->buffering_duration || underrun) {
+        player->buffering_duration = duration;
+        bp_buffering_apply (player, queue);
+    }
+}
+
+static gboolean
+bp_buffering_can_resume_early (BansheePlayer *player, gint percent)
+{
+    return percent >= BP_BUFFERING_EARLY_RESUME_PERCENT &&
+        player->buffering_bitrate > 0 &&
+        player->buffering_download_rate >= player->buffering_bitrate * BP_BUFFERING_EARLY_RESUME_RATIO;
+}
+
+// ---------------------------------------------------------------------------
+// Internal Functions
+// ---------------------------------------------------------------------------
+
+void
+_bp_buffering_reset (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    player->buffering_percent = 100;
+    player->buffering_pause_below = 100;
+    player->buffering_download_rate = 0;
+    player->buffering_bitrate = 0;
+    player->buffering_rebuffers = 0;
+    player->buffering_stable_since = gst_util_get_timestamp ();
+
+    // Keep what was learned about the link from the previous stream, the
+    // bitrate based size is recomputed once the new stream reports it
+    if (player->buffering_duration == 0) {
+        player->buffering_duration = BP_BUFFERING_DEFAULT_DURATION;
+    }
+
+    if (player->playbin != NULL) {
+        bp_buffering_apply (player, NULL);
+    }
+}
+
+void
+_bp_buffering_handle_message (BansheePlayer *player, GstMessage *message)
+{
+    GstElement *queue = NULL;
+    GstBufferingMode mode;
+    gint percent = 0, avg_in = 0, avg_out = 0;
+    gint64 left = 0;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    gst_message_parse_buffering (message, &percent);
+    gst_message_parse_buffering_stats (message, &mode, &avg_in, &avg_out, &left);
+
+    bp_trace (BANSHEE_TRACE_EVENT_BUFFERING, percent, avg_in);
+
+    // Only network buffering is adapted; the CDDA read-ahead posts its own
+    // messages without stats
+    if (GST_IS_ELEMENT (GST_MESSAGE_SRC (message)) &&
+        g_object_class_find_property (G_OBJECT_GET_CLASS (GST_MESSAGE_SRC (message)), "use-rate-estimate") != NULL) {
+        queue = GST_ELEMENT (GST_MESSAGE_SRC (message));
+    }
+
+    if (queue != NULL && avg_in > 0) {
+        // Smooth the download rate, it is noisy on flaky links
+        player->buffering_download_rate = player->buffering_download_rate == 0
+            ? avg_in
+            : (3 * player->buffering_download_rate + avg_in) / 4;
+    }
+    if (queue != NULL && avg_out > 0) {
+        gboolean resize = player->buffering_bitrate == 0;
+        player->buffering_bitrate = avg_out;
+        if (resize) {
+            bp_buffering_apply (player, queue);
+        }
+    }
+
+    player->buffering_percent = percent;
+
+    if (percent >= 100) {
+        player->buffering = FALSE;
+        player->buffering_pause_below = 100;
+        if (player->target_state == GST_STATE_PLAYING) {
+            gst_element_set_state (player->playbin, GST_STATE_PLAYING);
+        }
+        if (queue != NULL) {
+            bp_buffering_adapt (player, queue, FALSE);
+        }
+    } else if (player->buffering) {
+        if (queue != NULL && bp_buffering_can_resume_early (player, percent)) {
+            bp_debug4 ("[buffering] resuming at %d%%, downloading at %d B/s for %d B/s",
+                percent, player->buffering_download_rate, player->buffering_bitrate);
+            player->buffering = FALSE;
+            player->buffering_pause_below = MAX (percent - BP_BUFFERING_HYSTERESIS_PERCENT, 1);
+            if (player->target_state == GST_STATE_PLAYING) {
+                gst_element_set_state (player->playbin, GST_STATE_PLAYING);
+            }
+        }
+    } else if (percent < player->buffering_pause_below && player->target_state == GST_STATE_PLAYING) {
+        GstState current_state;
+        gst_element_get_state (player->playbin, &current_state, NULL, 0);
+        if (current_state == GST_STATE_PLAYING) {
+            gst_element_set_state (player->playbin, GST_STATE_PAUSED);
+            if (queue != NULL) {
+                bp_buffering_adapt (player, queue, TRUE);
+            }
+        }
+        player->buffering = TRUE;
+        player->buffering_pause_below = 100;
+    }
+
+    if (player->buffering_cb != NULL) {
+        player->buffering_cb (player, percent);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public Functions
+// ---------------------------------------------------------------------------
+
+P_INVOKE void
+bp_get_buffering_info (BansheePlayer *player, BpBufferingInfo *info)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+    g_return_if_fail (info != NULL);
+
+    info->percent = player->buffering_percent;
+    info->download_rate = player->buffering_download_rate;
+    info->bitrate = player->buffering_bitrate;
+    info->duration_ms = (gint64)(player->buffering_duration / GST_MSECOND);
+    info->size = player->buffering_size;
+    info->rebuffers = player->buffering_rebuffers;
+}
@@ -0,0 +1,44 @@
+//
+// banshee-player-buffering.h
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef _BANSHEE_PLAYER_BUFFERING_H
+#define _BANSHEE_PLAYER_BUFFERING_H
+
+#include "banshee-player-private.h"
+
+typedef struct {
+    gint percent;          // fill level of the network buffer
+    gint download_rate;    // bytes per second, smoothed
+    gint bitrate;          // bytes per second the stream is consumed at
+    gint64 duration_ms;    // buffer duration currently asked for
+    gint size;             // and the matching size limit in bytes
+    guint rebuffers;       // underruns since the stream was opened
+} BpBufferingInfo;
+
+void      _bp_buffering_reset          (BansheePlayer *player);
+void      _bp_buffering_handle_message (BansheePlayer *player, GstMessage *message);
+
+#endif /* _BANSHEE_PLAYER_BUFFERING_H */
@@ -0,0 +1,663 @@
+//
+// banshee-player-cache.c
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <string.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "banshee-player-cache.h"
+
+// Progressive download caching: the bytes a remote source pushes are
+// written into a sparse partial file in the cache directory, by a probe on
+// the source's pad, so it works for any stream uridecodebin plays and not
+// only for what it decides to download itself. Once every byte of the
+// stream was seen the file is renamed after the MD5 of its URI, and the
+// next open plays it from disk. The directory is kept under its size
+// bound by evicting the least recently played files.
+//
+// Only streams of a known, finite length that fit in the cache are kept;
+// live streams and radio stations are left alone. An interrupted download
+// keeps its partial file next to a list of the byte ranges it holds, and
+// the next play of the URI carries on filling it in, so an episode is
+// complete once every part of it was downloaded in some session. Until
+// then it still plays from the network: the ranges already on disk are not
+// served from there, and neither are seeks within the first listen, except
+// for the containers uridecodebin downloads itself with the DOWNLOAD flag.
+
+#define GST_PLAY_FLAG_DOWNLOAD    (1 << 7)
+#define BP_CACHE_PARTIAL_SUFFIX   ".partial"
+#define BP_CACHE_RANGES_SUFFIX    ".ranges"
+#define BP_CACHE_WATCHED_KEY      "banshee-cache-watched"
+
+typedef struct {
+    gchar *path;
+    guint64 size;
+    time_t mtime;
+} BpCacheEntry;
+
+typedef struct {
+    guint64 start;
+    guint64 end;
+} BpCacheRange;
+
+// Shared between the player and the probe on the source's streaming
+// thread; everything but the immutable strings is guarded by mutex
+struct BpCacheDownload {
+    volatile gint ref_count;
+    GMutex *mutex;
+    gchar *uri;
+    gchar *path;               // the partial file
+    gchar *ranges_path;        // and the byte ranges it holds
+    GFileIOStream *stream;     // NULL once finished
+    guint64 max_size;
+    gint64 stored_length;      // length the ranges were saved for, -1 if none
+    gint64 length;             // -1 until the first buffer
+    guint64 position;          // where the next buffer goes
+    GSList *ranges;            // BpCacheRange, sorted and disjoint
+    gboolean failed;           // not cacheable, dropped when finished
+};
+
+G_LOCK_DEFINE_STATIC (cache_download);
+
+// ---------------------------------------------------------------------------
+// Private Functions
+// ---------------------------------------------------------------------------
+
+static gboolean
+bp_cache_is_remote_uri (const gchar *uri)
+{
+    return uri != NULL && (g_str_has_prefix (uri, "http://") || g_str_has_prefix (uri, "https://"));
+}
+
+static gchar *
+bp_cache_path_for_uri (BansheePlayer *player, const gchar *uri, const gchar *suffix)
+{
+    gchar *checksum, *name, *path;
+
+    checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+    name = g_strconcat (checksum, suffix, NULL);
+    path = g_build_filename (player->cache_dir, name, NULL);
+    g_free (checksum);
+    g_free (name);
+
+    return path;
+}
+
+static void
+bp_cache_set_download_flag (BansheePlayer *player, gboolean download)
+{
+    gint flags;
+
+    g_object_get (G_OBJECT (player->playbin), "flags", &flags, NULL);
+    if (download) {
+        flags |= GST_PLAY_FLAG_DOWNLOAD;
+    } else {
+        flags &= ~GST_PLAY_FLAG_DOWNLOAD;
+    }
+    g_object_set (G_OBJECT (player->playbin), "flags", flags, NULL);
+}
+
+static gint
+bp_cache_entry_compare (gconstpointer a, gconstpointer b)
+{
+    const BpCacheEntry *entry_a = a, *entry_b = b;
+    return entry_a->mtime < entry_b->mtime ? -1 : (entry_a->mtime > entry_b->mtime ? 1 : 0);
+}
+
+// The ranges file of a partial file, or NULL for a complete one
+static gchar *
+bp_cache_ranges_path_for (const gchar *path)
+{
+    gchar *stem, *ranges_path;
+
+    if (!g_str_has_suffix (path, BP_CACHE_PARTIAL_SUFFIX)) {
+        return NULL;
+    }
+
+    stem = g_strndup (path, strlen (path) - strlen (BP_CACHE_PARTIAL_SUFFIX));
+    ranges_path = g_strconcat (stem, BP_CACHE_RANGES_SUFFIX, NULL);
+    g_free (stem);
+
+    return ranges_path;
+}
+
+static void
+bp_cache_trim (BansheePlayer *player)
+{
+    GDir *dir;
+    const gchar *name;
+    GSList *entries = NULL, *node;
+    guint64 total = 0;
+    const gchar *active_path = NULL;
+
+    if (player->cache_dir == NULL || player->cache_max_size == 0) {
+        return;
+    }
+
+    if ((dir = g_dir_open (player->cache_dir, 0, NULL)) == NULL) {
+        return;
+    }
+
+    G_LOCK (cache_download);
+    if (player->cache_download != NULL) {
+        active_path = player->cache_download->path;
+    }
+
+    while ((name = g_dir_read_name (dir)) != NULL) {
+        BpCacheEntry *entry;
+        struct stat info;
+        gchar *path = g_build_filename (player->cache_dir, name, NULL);
+
+        // Ranges files go with their partial file
+        if (g_str_has_suffix (name, BP_CACHE_RANGES_SUFFIX) ||
+            !g_file_test (path, G_FILE_TEST_IS_REGULAR) || g_stat (path, &info) != 0) {
+            g_free (path);
+            continue;
+        }
+
+        // The download in progress counts against the bound but is never
+        // evicted; it was only started because it fits
+        if (active_path != NULL && strcmp (path, active_path) == 0) {
+            total += info.st_size;
+            g_free (path);
+            continue;
+        }
+
+        entry = g_new0 (BpCacheEntry, 1);
+        entry->path = path;
+        entry->size = info.st_size;
+        entry->mtime = info.st_mtime;
+        entries = g_slist_prepend (entries, entry);
+        total += entry->size;
+    }
+    G_UNLOCK (cache_download);
+    g_dir_close (dir);
+
+    entries = g_slist_sort (entries, bp_cache_entry_compare);
+    for (node = entries; node != NULL; node = node->next) {
+        BpCacheEntry *entry = (BpCacheEntry *)node->data;
+        if (total > player->cache_max_size && g_unlink (entry->path) == 0) {
+            gchar *ranges_path = bp_cache_ranges_path_for (entry->path);
+            if (ranges_path != NULL) {
+                g_unlink (ranges_path);
+                g_free (ranges_path);
+            }
+            bp_debug2 ("[cache] evicted %s", entry->path);
+            total -= entry->size;
+        }
+        g_free (entry->path);
+        g_free (entry);
+    }
+    g_slist_free (entries);
+}
+
+static GSList *
+bp_cache_ranges_add (GSList *ranges, guint64 start, guint64 end)
+{
+    GSList *node, *next;
+    BpCacheRange *range;
+
+    if (end <= start) {
+        return ranges;
+    }
+
+    range = g_new (BpCacheRange, 1);
+    range->start = start;
+    range->end = end;
+
+    // Insert in order, then fold every following range it touches into it
+    for (node = ranges; node != NULL && ((BpCacheRange *)node->data)->start < start; node = node->next);
+    ranges = g_slist_insert_before (ranges, node, range);
+
+    for (node = ranges; node != NULL && node->next != NULL; node = next) {
+        BpCacheRange *current = (BpCacheRange *)node->data;
+        BpCacheRange *following = (BpCacheRange *)node->next->data;
+
+        if (following->start <= current->end) {
+            current->end = MAX (current->end, following->end);
+            g_free (following);
+            ranges = g_slist_delete_link (ranges, node->next);
+            next = node;
+        } else {
+            next = node->next;
+        }
+    }
+
+    return ranges;
+}
+
+static void
+bp_cache_ranges_free (GSList *ranges)
+{
+    g_slist_foreach (ranges, (GFunc)g_free, NULL);
+    g_slist_free (ranges);
+}
+
+// Called with the download locked
+static gboolean
+bp_cache_download_is_complete (BpCacheDownload *download)
+{
+    BpCacheRange *range;
+
+    if (download->length <= 0 || download->ranges == NULL || download->ranges->next != NULL) {
+        return FALSE;
+    }
+
+    range = (BpCacheRange *)download->ranges->data;
+    return range->start == 0 && range->end >= (guint64)download->length;
+}
+
+// The ranges file holds the stream length on the first line and one
+// "start end" byte range per line after it
+static void
+bp_cache_download_load_ranges (BpCacheDownload *download)
+{
+    gchar *contents = NULL;
+    gchar **lines;
+    gint i;
+
+    download->stored_length = -1;
+    if (!g_file_get_contents (download->ranges_path, &contents, NULL, NULL)) {
+        return;
+    }
+
+    lines = g_strsplit (contents, "\n", -1);
+    if (lines[0] != NULL) {
+        download->stored_length = g_ascii_strtoll (lines[0], NULL, 10);
+        for (i = 1; lines[i] != NULL; i++) {
+            gchar *end;
+            guint64 start = g_ascii_strtoull (lines[i], &end, 10);
+            if (end != lines[i]) {
+                download->ranges = bp_cache_ranges_add (download->ranges, start, g_ascii_strtoull (end, NULL, 10));
+            }
+        }
+    }
+
+    g_strfreev (lines);
+    g_free (contents);
+}
+
+static void
+bp_cache_download_save_ranges (BpCacheDownload *download)
+{
+    GString *contents = g_string_new (NULL);
+    GSList *node;
+
+    g_string_append_printf (contents, "%" G_GINT64_FORMAT "\n", download->length);
+    for (node = download->ranges; node != NULL; node = node->next) {
+        BpCacheRange *range = (BpCacheRange *)node->data;
+        g_string_append_printf (contents, "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT "\n", range->start, range->end);
+    }
+
+    g_file_set_contents (download->ranges_path, contents->str, contents->len, NULL);
+    g_string_free (contents, TRUE);
+}
+
+static BpCacheDownload *
+bp_cache_download_new (BansheePlayer *player, const gchar *uri)
+{
+    BpCacheDownload *download;
+    GFile *file;
+
+    download = g_new0 (BpCacheDownload, 1);
+    download->ref_count = 1;
+    download->mutex = g_mutex_new ();
+    download->uri = g_strdup (uri);
+    download->path = bp_cache_path_for_uri (player, uri, BP_CACHE_PARTIAL_SUFFIX);
+    download->ranges_path = bp_cache_path_for_uri (player, uri, BP_CACHE_RANGES_SUFFIX);
+    download->max_size = player->cache_max_size;
+    download->length = -1;
+
+    // Pick up what an earlier session left, unless its file went away
+    file = g_file_new_for_path (download->path);
+    bp_cache_download_load_ranges (download);
+    if (download->ranges != NULL) {
+        download->stream = g_file_open_readwrite (file, NULL, NULL);
+    }
+
+    if (download->stream == NULL) {
+        bp_cache_ranges_free (download->ranges);
+        download->ranges = NULL;
+        download->stored_length = -1;
+        download->stream = g_file_replace_readwrite (file, NULL, FALSE, G_FILE_CREATE_PRIVATE, NULL, NULL);
+    }
+    g_object_unref (file);
+
+    if (download->stream == NULL) {
+        bp_debug2 ("[cache] could not create %s", download->path);
+        download->failed = TRUE;
+    } else if (download->ranges != NULL) {
+        bp_debug3 ("[cache] resuming %s in %s", uri, download->path);
+    } else {
+        bp_debug3 ("[cache] downloading %s to %s", uri, download->path);
+    }
+
+    return download;
+}
+
+static void
+bp_cache_download_unref (BpCacheDownload *download)
+{
+    if (!g_atomic_int_dec_and_test (&download->ref_count)) {
+        return;
+    }
+
+    if (download->stream != NULL) {
+        g_object_unref (download->stream);
+    }
+
+    bp_cache_ranges_free (download->ranges);
+    g_mutex_free (download->mutex);
+    g_free (download->uri);
+    g_free (download->path);
+    g_free (download->ranges_path);
+    g_free (download);
+}
+
+// Called with the download locked; the length comes from the source, e.g.
+// the HTTP Content-Length, once it has a response
+static void
+bp_cache_download_start (BpCacheDownload *download, GstPad *pad)
+{
+    gint64 length = -1;
+
+    if (!gst_pad_query_duration (pad, GST_FORMAT_BYTES, &length) || length <= 0 ||
+        (guint64)length > download->max_size) {
+        bp_debug3 ("[cache] not caching %s (length %" G_GINT64_FORMAT ")", download->uri, length);
+        download->failed = TRUE;
+        return;
+    }
+
+    download->length = length;
+
+    // The resource changed since the partial file was written
+    if (download->stored_length != -1 && download->stored_length != length) {
+        bp_debug2 ("[cache] %s changed, starting over", download->uri);
+        bp_cache_ranges_free (download->ranges);
+        download->ranges = NULL;
+        if (!g_seekable_truncate (G_SEEKABLE (download->stream), 0, NULL, NULL)) {
+            download->failed = TRUE;
+        }
+    }
+}
+
+// Called with the download locked
+static void
+bp_cache_download_write (BpCacheDownload *download, GstBuffer *buffer)
+{
+    GOutputStream *output = g_io_stream_get_output_stream (G_IO_STREAM (download->stream));
+    GstMapInfo map;
+    gboolean written;
+
+    if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+        return;
+    }
+
+    written = g_seekable_seek (G_SEEKABLE (download->stream), download->position, G_SEEK_SET, NULL, NULL) &&
+        g_output_stream_write_all (output, map.data, map.size, NULL, NULL, NULL);
+    gst_buffer_unmap (buffer, &map);
+
+    if (!written) {
+        bp_debug2 ("[cache] could not write to %s", download->path);
+        download->failed = TRUE;
+        return;
+    }
+
+    download->ranges = bp_cache_ranges_add (download->ranges, download->position, download->position + map.size);
+    download->position += map.size;
+}
+
+// Runs on the source's streaming thread; byte sources start every segment,
+// including the one after a seek, at the byte offset of its first buffer
+static GstPadProbeReturn
+bp_cache_source_probe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    BpCacheDownload *download = (BpCacheDownload *)user_data;
+    GstPadProbeReturn result = GST_PAD_PROBE_OK;
+
+    g_mutex_lock (download->mutex);
+
+    if (download->stream == NULL || download->failed) {
+        result = GST_PAD_PROBE_REMOVE;
+    } else if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+        if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT) {
+            const GstSegment *segment;
+            gst_event_parse_segment (event, &segment);
+            if (segment->format == GST_FORMAT_BYTES) {
+                download->position = segment->start;
+            } else {
+                download->failed = TRUE;
+            }
+        }
+    } else {
+        if (download->length < 0) {
+            bp_cache_download_start (download, pad);
+        }
+        if (!download->failed) {
+            bp_cache_download_write (download, GST_PAD_PROBE_INFO_BUFFER (info));
+        }
+    }
+
+    g_mutex_unlock (download->mutex);
+    return result;
+}
+
+// Stops the download that is being tracked: stores it if it is complete,
+// keeps the partial file and its ranges if it got anywhere, and drops it
+// if it was not cacheable
+static void
+bp_cache_finish (BansheePlayer *player)
+{
+    BpCacheDownload *download;
+
+    G_LOCK (cache_download);
+    download = player->cache_download;
+    player->cache_download = NULL;
+    G_UNLOCK (cache_download);
+
+    if (download == NULL) {
+        return;
+    }
+
+    g_mutex_lock (download->mutex);
+
+    if (download->stream != NULL) {
+        g_io_stream_close (G_IO_STREAM (download->stream), NULL, NULL);
+        g_object_unref (download->stream);
+        download->stream = NULL;
+    }
+
+    if (!download->failed && bp_cache_download_is_complete (download)) {
+        gchar *path = bp_cache_path_for_uri (player, download->uri, "");
+        if (g_rename (download->path, path) == 0) {
+            bp_debug3 ("[cache] stored %s as %s", download->uri, path);
+        } else {
+            bp_debug2 ("[cache] could not store %s", download->uri);
+            g_unlink (download->path);
+        }
+        g_unlink (download->ranges_path);
+        g_free (path);
+    } else if (!download->failed && download->length > 0 && download->ranges != NULL) {
+        bp_cache_download_save_ranges (download);
+        bp_debug2 ("[cache] keeping the partial download of %s", download->uri);
+    } else if (!download->failed && download->length < 0 && download->ranges != NULL) {
+        // Nothing new arrived; what an earlier session saved still holds
+    } else {
+        g_unlink (download->path);
+        g_unlink (download->ranges_path);
+    }
+
+    g_mutex_unlock (download->mutex);
+    bp_cache_download_unref (download);
+
+    bp_cache_trim (player);
+}
+
+static void
+bp_cache_on_notify_source (GstElement *playbin, GParamSpec *param, BansheePlayer *player)
+{
+    BpCacheDownload *download;
+    GstElement *source = NULL;
+    GstPad *pad;
+    gchar *uri;
+
+    if (player->cache_dir == NULL) {
+        return;
+    }
+
+    g_object_get (playbin, "source", &source, NULL);
+    if (source == NULL) {
+        return;
+    }
+
+    // Each source is only set up once, even if notify fires again
+    if (g_object_get_data (G_OBJECT (source), BP_CACHE_WATCHED_KEY) != NULL || !GST_IS_URI_HANDLER (source)) {
+        gst_object_unref (source);
+        return;
+    }
+    g_object_set_data (G_OBJECT (source), BP_CACHE_WATCHED_KEY, GINT_TO_POINTER (TRUE));
+
+    uri = gst_uri_handler_get_uri (GST_URI_HANDLER (source));
+    pad = gst_element_get_static_pad (source, "src");
+
+    if (bp_cache_is_remote_uri (uri) && pad != NULL) {
+        // A gapless transition moved on to the next stream
+        bp_cache_finish (player);
+
+        download = bp_cache_download_new (player, uri);
+        if (!download->failed) {
+            g_atomic_int_inc (&download->ref_count);
+            gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                bp_cache_source_probe, download, (GDestroyNotify)bp_cache_download_unref);
+        }
+
+        G_LOCK (cache_download);
+        player->cache_download = download;
+        G_UNLOCK (cache_download);
+    }
+
+    if (pad != NULL) {
+        gst_object_unref (pad);
+    }
+    g_free (uri);
+    gst_object_unref (source);
+}
+
+// ---------------------------------------------------------------------------
+// Internal Functions
+// ---------------------------------------------------------------------------
+
+void
+_bp_cache_pipeline_setup (BansheePlayer *player)
+{
+    if (player != NULL && player->playbin != NULL) {
+        g_signal_connect (player->playbin, "notify::source", G_CALLBACK (bp_cache_on_notify_source), player);
+    }
+}
+
+void
+_bp_cache_reset (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+    bp_cache_finish (player);
+}
+
+gchar *
+_bp_cache_resolve_uri (BansheePlayer *player, const gchar *uri)
+{
+    gchar *path, *cached_uri = NULL;
+
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), NULL);
+
+    if (player->cache_dir == NULL || !bp_cache_is_remote_uri (uri)) {
+        if (player->playbin != NULL) {
+            bp_cache_set_download_flag (player, FALSE);
+        }
+        return g_strdup (uri);
+    }
+
+    path = bp_cache_path_for_uri (player, uri, "");
+    if (g_file_test (path, G_FILE_TEST_IS_REGULAR)) {
+        // Touch it so it is the last to be evicted
+        g_utime (path, NULL);
+        cached_uri = g_filename_to_uri (path, NULL, NULL);
+        bp_debug3 ("[cache] playing %s from %s", uri, path);
+    }
+    g_free (path);
+
+    // Lets uridecodebin serve seeks from its own download where it can
+    if (player->playbin != NULL) {
+        bp_cache_set_download_flag (player, cached_uri == NULL);
+    }
+
+    return cached_uri != NULL ? cached_uri : g_strdup (uri);
+}
+
+void
+_bp_cache_handle_eos (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+    bp_cache_finish (player);
+}
+
+void
+_bp_cache_destroy (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    bp_cache_finish (player);
+    g_free (player->cache_dir);
+    player->cache_dir = NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Public Functions
+// ---------------------------------------------------------------------------
+
+P_INVOKE void
+bp_set_download_cache (BansheePlayer *player, const gchar *directory, guint64 max_size)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    g_free (player->cache_dir);
+    player->cache_dir = NULL;
+    player->cache_max_size = max_size;
+
+    // A NULL directory or a zero size turns caching off
+    if (directory == NULL || max_size == 0) {
+        return;
+    }
+
+    if (g_mkdir_with_parents (directory, 0700) != 0) {
+        bp_debug2 ("[cache] could not create %s", directory);
+        return;
+    }
+
+    player->cache_dir = g_strdup (directory);
+    bp_cache_trim (player);
+}
@@ -0,0 +1,38 @@
+//
+// banshee-player-cache.h
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef _BANSHEE_PLAYER_CACHE_H
+#define _BANSHEE_PLAYER_CACHE_H
+
+#include "banshee-player-private.h"
+
+void      _bp_cache_pipeline_setup     (BansheePlayer *player);
+void      _bp_cache_reset              (BansheePlayer *player);
+gchar    *_bp_cache_resolve_uri        (BansheePlayer *player, const gchar *uri);
+void      _bp_cache_handle_eos         (BansheePlayer *player);
+void      _bp_cache_destroy            (BansheePlayer *player);
+
+#endif /* _BANSHEE_PLAYER_CACHE_H */
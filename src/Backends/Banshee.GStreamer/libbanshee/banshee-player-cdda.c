@@ -32,6 +32,23 @@
 #include <gst/audio/gstaudiocdsrc.h>
 #include "banshee-player-cdda.h"
 
+// Amount of PCM that must be cached again after an underrun before
+// playback resumes
+#define BP_CDDA_READAHEAD_RESUME_TIME (10 * GST_SECOND)
+
+// Audio that must stay cached past a seek target for the seek to be served
+// from the queue, so that it does not run dry right after
+#define BP_CDDA_READAHEAD_SEEK_MARGIN (2 * GST_SECOND)
+
+// The read-ahead queue is only linked in front of the audiotee while a disc
+// is played; its flags are read and written on the streaming threads of
+// both sides of the queue and on the main loop, so all go through
+// g_atomic_int_*. A forward seek that lands inside the cached audio while
+// playing is served from the queue: its output side drops the buffers up
+// to the target and restarts the segment there, without a flush, so the
+// drive keeps reading ahead. Any other seek is flushing and goes back to
+// the drive, as the queue only holds audio ahead of playback.
+
 // ---------------------------------------------------------------------------
 // Private Functions
 // ---------------------------------------------------------------------------
@@ -58,6 +75,252 @@ bp_cdda_get_cdda_source (GstElement *playbin)
     return source;
 }
 
+static GstClockTime
+bp_cdda_readahead_get_level (BansheePlayer *player)
+{
+    guint64 level = 0;
+    g_object_get (player->cdda_readahead, "current-level-time", &level, NULL);
+    return level;
+}
+
+static void
+bp_cdda_readahead_post_buffering (BansheePlayer *player, gint percent)
+{
+    // Reuse the regular BUFFERING bus message so the pipeline bus callback
+    // pauses/resumes playback and forwards the progress to buffering_cb
+    gst_element_post_message (player->cdda_readahead,
+        gst_message_new_buffering (GST_OBJECT (player->cdda_readahead), percent));
+}
+
+static void
+bp_cdda_readahead_set_window (BansheePlayer *player, GstClockTime max_time)
+{
+    g_object_set (G_OBJECT (player->cdda_readahead), "max-size-time", max_time, NULL);
+}
+
+static void
+bp_cdda_readahead_clear_skip (BansheePlayer *player)
+{
+    GST_OBJECT_LOCK (player->cdda_readahead);
+    player->cdda_skip_target = GST_CLOCK_TIME_NONE;
+    player->cdda_skip_base = GST_CLOCK_TIME_NONE;
+    GST_OBJECT_UNLOCK (player->cdda_readahead);
+}
+
+static void
+bp_cdda_readahead_configure (BansheePlayer *player)
+{
+    gboolean active;
+
+    if (player->cdda_readahead == NULL) {
+        return;
+    }
+
+    active = player->cdda_readahead_linked && player->cdda_device != NULL && player->cdda_readahead_seconds > 0;
+    g_atomic_int_set (&player->cdda_readahead_primed, FALSE);
+    g_atomic_int_set (&player->cdda_readahead_eos, FALSE);
+    g_atomic_int_set (&player->cdda_readahead_throttled, FALSE);
+    g_atomic_int_set (&player->cdda_rebuffering, FALSE);
+    g_atomic_int_set (&player->cdda_readahead_active, active);
+    bp_cdda_readahead_clear_skip (player);
+
+    if (active) {
+        bp_debug2 ("bp_cdda: caching up to %u seconds of PCM ahead of playback", player->cdda_readahead_seconds);
+        g_object_set (G_OBJECT (player->cdda_readahead),
+            "max-size-buffers", 0,
+            "max-size-bytes", 0,
+            NULL);
+        bp_cdda_readahead_set_window (player, player->cdda_readahead_seconds * GST_SECOND);
+    } else {
+        // Behave like a stock queue until the next disc is opened
+        g_object_set (G_OBJECT (player->cdda_readahead),
+            "max-size-buffers", 200,
+            "max-size-bytes", 10 * 1024 * 1024,
+            "max-size-time", GST_SECOND,
+            NULL);
+    }
+}
+
+static void
+bp_cdda_readahead_underrun (GstElement *queue, BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    // Ignore the queue running dry at the start of a stream or right after a
+    // seek, the pipeline is prerolling then; only a drained cache is a dropout
+    if (!g_atomic_int_get (&player->cdda_readahead_active) ||
+        !g_atomic_int_get (&player->cdda_readahead_primed) ||
+        g_atomic_int_get (&player->cdda_readahead_eos) ||
+        g_atomic_int_get (&player->cdda_rebuffering)) {
+        return;
+    }
+
+    bp_debug ("bp_cdda: read-ahead buffer ran dry, rebuffering");
+    banshee_trace (BANSHEE_TRACE_CDDA, BANSHEE_TRACE_EVENT_UNDERRUN, 0, 0);
+    g_atomic_int_set (&player->cdda_rebuffer_percent, 0);
+    g_atomic_int_set (&player->cdda_rebuffering, TRUE);
+    bp_cdda_readahead_post_buffering (player, 0);
+}
+
+// The cache is full and the queue is about to hold the source's streaming
+// thread. Shrinking the window to a quarter keeps it held until the sink
+// has drained three quarters, so the drive idles and can spin down instead
+// of reading in lock step with the sink. The queue's own wait is released
+// by flushes and state changes like any other.
+static void
+bp_cdda_readahead_overrun (GstElement *queue, BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    if (!g_atomic_int_get (&player->cdda_readahead_active) ||
+        g_atomic_int_get (&player->cdda_readahead_throttled)) {
+        return;
+    }
+
+    bp_debug ("bp_cdda: read-ahead buffer full, suspending drive reads");
+    g_atomic_int_set (&player->cdda_readahead_throttled, TRUE);
+    bp_cdda_readahead_set_window (player, player->cdda_readahead_seconds * GST_SECOND / 4);
+}
+
+static GstPadProbeReturn
+bp_cdda_readahead_sink_probe (GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+    BansheePlayer *player = (BansheePlayer *)data;
+    GstClockTime resume, level;
+    gint percent;
+
+    if (!g_atomic_int_get (&player->cdda_readahead_active)) {
+        return GST_PAD_PROBE_PASS;
+    }
+
+    if (info->type & (GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_EVENT_FLUSH)) {
+        switch (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info))) {
+            case GST_EVENT_FLUSH_STOP:
+                g_atomic_int_set (&player->cdda_readahead_primed, FALSE);
+                g_atomic_int_set (&player->cdda_readahead_eos, FALSE);
+                if (g_atomic_int_get (&player->cdda_readahead_throttled)) {
+                    g_atomic_int_set (&player->cdda_readahead_throttled, FALSE);
+                    bp_cdda_readahead_set_window (player, player->cdda_readahead_seconds * GST_SECOND);
+                }
+                break;
+            case GST_EVENT_EOS:
+                g_atomic_int_set (&player->cdda_readahead_eos, TRUE);
+                if (g_atomic_int_get (&player->cdda_rebuffering)) {
+                    g_atomic_int_set (&player->cdda_rebuffering, FALSE);
+                    bp_cdda_readahead_post_buffering (player, 100);
+                }
+                break;
+            default: break;
+        }
+        return GST_PAD_PROBE_PASS;
+    }
+
+    // The queue let the drive read again, so it drained below the shrunk
+    // window; give the cache its full size back
+    if (g_atomic_int_get (&player->cdda_readahead_throttled)) {
+        g_atomic_int_set (&player->cdda_readahead_throttled, FALSE);
+        bp_cdda_readahead_set_window (player, player->cdda_readahead_seconds * GST_SECOND);
+    }
+
+    resume = MIN (player->cdda_readahead_seconds * GST_SECOND, BP_CDDA_READAHEAD_RESUME_TIME);
+    level = bp_cdda_readahead_get_level (player);
+
+    if (level >= resume) {
+        g_atomic_int_set (&player->cdda_readahead_primed, TRUE);
+    }
+
+    if (g_atomic_int_get (&player->cdda_rebuffering)) {
+        percent = resume > 0 ? (gint)MIN (100, level * 100 / resume) : 100;
+        if (percent >= 100) {
+            g_atomic_int_set (&player->cdda_rebuffering, FALSE);
+        }
+        if (percent != g_atomic_int_get (&player->cdda_rebuffer_percent)) {
+            g_atomic_int_set (&player->cdda_rebuffer_percent, percent);
+            bp_cdda_readahead_post_buffering (player, percent);
+        }
+    }
+
+    return GST_PAD_PROBE_PASS;
+}
+
+// Serves a pending seek on the queue's output: drops the buffers before
+// the target, then restarts the segment at the first one it keeps, with the
+// running time of the first dropped buffer so the sinks carry on from there
+static GstPadProbeReturn
+bp_cdda_readahead_src_probe (GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+    BansheePlayer *player = (BansheePlayer *)data;
+    GstClockTime target, base;
+    GstBuffer *buffer;
+    GstEvent *event;
+    GstSegment segment;
+    const GstSegment *current;
+
+    if (info->type & GST_PAD_PROBE_TYPE_EVENT_FLUSH) {
+        if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_FLUSH_STOP) {
+            bp_cdda_readahead_clear_skip (player);
+        }
+        return GST_PAD_PROBE_PASS;
+    }
+
+    GST_OBJECT_LOCK (player->cdda_readahead);
+    target = player->cdda_skip_target;
+    base = player->cdda_skip_base;
+    GST_OBJECT_UNLOCK (player->cdda_readahead);
+
+    buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    if (!GST_CLOCK_TIME_IS_VALID (target) || !GST_BUFFER_PTS_IS_VALID (buffer)) {
+        return GST_PAD_PROBE_PASS;
+    }
+
+    if ((event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0)) == NULL) {
+        bp_cdda_readahead_clear_skip (player);
+        return GST_PAD_PROBE_PASS;
+    }
+
+    gst_event_parse_segment (event, &current);
+    gst_segment_copy_into (current, &segment);
+    gst_event_unref (event);
+
+    if (segment.format != GST_FORMAT_TIME) {
+        bp_cdda_readahead_clear_skip (player);
+        return GST_PAD_PROBE_PASS;
+    }
+
+    if (!GST_CLOCK_TIME_IS_VALID (base)) {
+        base = gst_segment_to_running_time (&segment, GST_FORMAT_TIME, GST_BUFFER_PTS (buffer));
+        GST_OBJECT_LOCK (player->cdda_readahead);
+        player->cdda_skip_base = base;
+        GST_OBJECT_UNLOCK (player->cdda_readahead);
+    }
+
+    if (GST_BUFFER_DURATION_IS_VALID (buffer) &&
+        GST_BUFFER_PTS (buffer) + GST_BUFFER_DURATION (buffer) <= target) {
+        return GST_PAD_PROBE_DROP;
+    }
+
+    if (!GST_BUFFER_DURATION_IS_VALID (buffer) && GST_BUFFER_PTS (buffer) < target) {
+        return GST_PAD_PROBE_DROP;
+    }
+
+    bp_cdda_readahead_clear_skip (player);
+    bp_debug2 ("bp_cdda: seek served from the read-ahead at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
+
+    segment.time = gst_segment_to_stream_time (&segment, GST_FORMAT_TIME, GST_BUFFER_PTS (buffer));
+    segment.start = GST_BUFFER_PTS (buffer);
+    segment.position = GST_BUFFER_PTS (buffer);
+    segment.offset = 0;
+    segment.base = GST_CLOCK_TIME_IS_VALID (base) ? base : 0;
+    gst_pad_push_event (pad, gst_event_new_segment (&segment));
+
+    buffer = gst_buffer_make_writable (buffer);
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+    GST_PAD_PROBE_INFO_DATA (info) = buffer;
+
+    return GST_PAD_PROBE_PASS;
+}
+
 static void
 bp_cdda_on_notify_source (GstElement *playbin, gpointer unknown, BansheePlayer *player)
 {
@@ -84,6 +347,15 @@ bp_cdda_on_notify_source (GstElement *playbin, gpointer unknown, BansheePlayer *
     if (g_object_class_find_property (G_OBJECT_GET_CLASS (cdda_src), "paranoia-mode")) {
         g_object_set (cdda_src, "paranoia-mode", 0, NULL);
     }
+
+    // With the read-ahead cache in place there is no reason to throttle
+    // the drive; read at its full speed and let it idle afterwards
+    if (player->cdda_readahead_seconds > 0 &&
+        g_object_class_find_property (G_OBJECT_GET_CLASS (cdda_src), "read-speed")) {
+        g_object_set (cdda_src, "read-speed", -1, NULL);
+    }
+
+    bp_cdda_readahead_configure (player);
     
     g_object_unref (cdda_src);
 }
@@ -128,6 +400,118 @@ bp_cdda_source_seek_to_track (GstElement *playbin, guint track)
 // Internal Functions
 // ---------------------------------------------------------------------------
 
+GstElement *
+_bp_cdda_readahead_new (BansheePlayer *player)
+{
+    GstElement *queue;
+    GstPad *pad;
+
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), NULL);
+
+    // The read-ahead queue lives in the audio bin for the life of the
+    // pipeline, but _bp_cdda_readahead_link only puts it in the data path
+    // while a disc is played
+    queue = gst_element_factory_make ("queue", "cdda-readahead");
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    player->cdda_readahead = queue;
+    player->cdda_readahead_linked = FALSE;
+    player->cdda_skip_target = GST_CLOCK_TIME_NONE;
+    player->cdda_skip_base = GST_CLOCK_TIME_NONE;
+    g_signal_connect (queue, "underrun", G_CALLBACK (bp_cdda_readahead_underrun), player);
+    g_signal_connect (queue, "overrun", G_CALLBACK (bp_cdda_readahead_overrun), player);
+
+    pad = gst_element_get_static_pad (queue, "sink");
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+        GST_PAD_PROBE_TYPE_EVENT_FLUSH, bp_cdda_readahead_sink_probe, player, NULL);
+    gst_object_unref (pad);
+
+    pad = gst_element_get_static_pad (queue, "src");
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+        bp_cdda_readahead_src_probe, player, NULL);
+    gst_object_unref (pad);
+
+    bp_cdda_readahead_configure (player);
+
+    return queue;
+}
+
+// Moves the audio bin's sink ghost pad between the read-ahead queue and the
+// audiotee depending on whether a disc is being opened. Only done while
+// nothing streams, i.e. before the first open or after bp_open has brought
+// the pipeline back to READY; otherwise it waits for the next open.
+void
+_bp_cdda_readahead_link (BansheePlayer *player)
+{
+    GstPad *ghost, *target;
+    GstState state;
+    gboolean wanted;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    if (player->playbin == NULL || player->cdda_readahead == NULL) {
+        return;
+    }
+
+    wanted = player->cdda_device != NULL && player->cdda_readahead_seconds > 0;
+    gst_element_get_state (player->playbin, &state, NULL, 0);
+    if (wanted == player->cdda_readahead_linked || state > GST_STATE_READY) {
+        bp_cdda_readahead_configure (player);
+        return;
+    }
+
+    ghost = gst_element_get_static_pad (player->audiobin, "sink");
+    if (wanted) {
+        target = gst_element_get_static_pad (player->cdda_readahead, "sink");
+        gst_ghost_pad_set_target (GST_GHOST_PAD (ghost), target);
+        gst_element_link (player->cdda_readahead, player->audiotee);
+    } else {
+        gst_element_unlink (player->cdda_readahead, player->audiotee);
+        target = gst_element_get_static_pad (player->audiotee, "sink");
+        gst_ghost_pad_set_target (GST_GHOST_PAD (ghost), target);
+    }
+    gst_object_unref (target);
+    gst_object_unref (ghost);
+
+    bp_debug2 ("bp_cdda: read-ahead cache %s", wanted ? "linked" : "unlinked");
+    player->cdda_readahead_linked = wanted;
+    bp_cdda_readahead_configure (player);
+}
+
+// Takes over a seek when the target is ahead of playback and already in
+// the read-ahead queue; returns FALSE to let it go to the drive
+gboolean
+_bp_cdda_readahead_seek (BansheePlayer *player, GstClockTime target)
+{
+    gint64 position;
+    GstClockTime level;
+
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), FALSE);
+
+    if (player->cdda_readahead == NULL || !g_atomic_int_get (&player->cdda_readahead_active) ||
+        GST_STATE (player->playbin) != GST_STATE_PLAYING ||
+        !gst_element_query_position (player->playbin, GST_FORMAT_TIME, &position)) {
+        return FALSE;
+    }
+
+    // What the queue holds starts a little after the position, past what
+    // is queued downstream of it, so this errs on the side of the drive
+    level = bp_cdda_readahead_get_level (player);
+    if (target <= (GstClockTime)position || target + BP_CDDA_READAHEAD_SEEK_MARGIN >= position + level) {
+        return FALSE;
+    }
+
+    GST_OBJECT_LOCK (player->cdda_readahead);
+    player->cdda_skip_target = target;
+    player->cdda_skip_base = GST_CLOCK_TIME_NONE;
+    GST_OBJECT_UNLOCK (player->cdda_readahead);
+
+    bp_debug2 ("bp_cdda: serving the seek to %" GST_TIME_FORMAT " from the read-ahead", GST_TIME_ARGS (target));
+    return TRUE;
+}
+
 void
 _bp_cdda_pipeline_setup (BansheePlayer *player)
 {
@@ -155,6 +539,7 @@ _bp_cdda_handle_uri (BansheePlayer *player, const gchar *uri)
             bp_debug2 ("bp_cdda: finished using device (%s)", player->cdda_device);
             g_free (player->cdda_device);
             player->cdda_device = NULL;
+            bp_cdda_readahead_configure (player);
         }
         
         return FALSE;
@@ -166,6 +551,7 @@ _bp_cdda_handle_uri (BansheePlayer *player, const gchar *uri)
         // have its own valid device node
         g_free (player->cdda_device);
         player->cdda_device = NULL;
+        bp_cdda_readahead_configure (player);
         bp_debug2 ("bp_cdda: invalid device node in URI (%s)", uri);
         return FALSE;
     }
@@ -200,3 +586,23 @@ _bp_cdda_handle_uri (BansheePlayer *player, const gchar *uri)
     
     return FALSE;
 }
+
+// ---------------------------------------------------------------------------
+// Public Functions
+// ---------------------------------------------------------------------------
+
+P_INVOKE void
+bp_cdda_set_readahead (BansheePlayer *player, guint seconds)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    player->cdda_readahead_seconds = seconds;
+    _bp_cdda_readahead_link (player);
+}
+
+P_INVOKE guint
+bp_cdda_get_readahead (BansheePlayer *player)
+{
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), 0);
+    return player->cdda_readahead_seconds;
+}
@@ -31,6 +31,12 @@
 
 #include "banshee-player-private.h"
 
+// A few minutes of 44.1 kHz stereo PCM is roughly 10 MB per minute
+#define BP_CDDA_READAHEAD_DEFAULT_SECONDS 180
+
+GstElement *_bp_cdda_readahead_new   (BansheePlayer *player);
+void      _bp_cdda_readahead_link    (BansheePlayer *player);
+gboolean  _bp_cdda_readahead_seek    (BansheePlayer *player, GstClockTime target);
 void      _bp_cdda_pipeline_setup    (BansheePlayer *player);
 gboolean  _bp_cdda_handle_uri        (BansheePlayer *player, const gchar *uri);
 
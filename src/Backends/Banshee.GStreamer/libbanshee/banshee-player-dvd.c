@@ -56,6 +56,51 @@ bp_dvd_on_notify_source (GstElement *playbin, gpointer unknown, BansheePlayer *p
     g_object_unref (dvd_src);
 }
 
+// The navigation element is replaced from the video sink's streaming
+// thread, so it is only handed out with a reference taken under the lock
+static GstNavigation *
+bp_dvd_ref_navigation (BansheePlayer *player, gboolean find)
+{
+    GstNavigation *navigation;
+
+    g_mutex_lock (player->navigation_mutex);
+    navigation = player->navigation != NULL ? gst_object_ref (player->navigation) : NULL;
+    g_mutex_unlock (player->navigation_mutex);
+
+    if (navigation == NULL && find) {
+        _bp_dvd_find_navigation (player);
+        navigation = bp_dvd_ref_navigation (player, FALSE);
+    }
+
+    return navigation;
+}
+
+static void
+bp_dvd_send_command (BansheePlayer *player, GstNavigationCommand command)
+{
+    GstNavigation *navigation;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    if ((navigation = bp_dvd_ref_navigation (player, TRUE)) != NULL) {
+        gst_navigation_send_command (navigation, command);
+        gst_object_unref (navigation);
+    }
+}
+
+static void
+bp_dvd_send_mouse_event (BansheePlayer *player, const gchar *event, int button, double x, double y)
+{
+    GstNavigation *navigation;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    if ((navigation = bp_dvd_ref_navigation (player, TRUE)) != NULL) {
+        gst_navigation_send_mouse_event (navigation, event, button, x, y);
+        gst_object_unref (navigation);
+    }
+}
+
 // ---------------------------------------------------------------------------
 // Internal Functions
 // ---------------------------------------------------------------------------
@@ -71,20 +116,34 @@ _bp_dvd_pipeline_setup (BansheePlayer *player)
 void
 _bp_dvd_elements_process_message (BansheePlayer *player, GstMessage *message)
 {
+    GstNavigation *navigation;
+    GstQuery *query;
+    guint n_cmds, i;
+
     g_return_if_fail (IS_BANSHEE_PLAYER (player));
     g_return_if_fail (message != NULL);
 
+    // The menu state can only change when the DVD source announces a new set
+    // of navigation commands; every other element message (missing plugins,
+    // level, ...) is none of our business and must stay cheap
+    if (gst_navigation_message_get_type (message) != GST_NAVIGATION_MESSAGE_COMMANDS_CHANGED) {
+        return;
+    }
+
     player->is_menu = FALSE;
-    // Get available command to know if player is in menu
-    GstQuery *query = gst_navigation_query_new_commands();
 
-    guint n_cmds, i;
-    if (!player->navigation) {
-        _bp_dvd_find_navigation (player);
+    // The navigation element is cached when the video sink is set up
+    if ((navigation = bp_dvd_ref_navigation (player, FALSE)) == NULL) {
+        return;
     }
-    if (!(gst_element_query (GST_ELEMENT_CAST (player->navigation), query)
+
+    // Get available command to know if player is in menu
+    query = gst_navigation_query_new_commands ();
+
+    if (!(gst_element_query (GST_ELEMENT_CAST (navigation), query)
         && gst_navigation_query_parse_commands_length (query, &n_cmds))) {
         gst_query_unref (query);
+        gst_object_unref (navigation);
         return;
     }
 
@@ -105,7 +164,10 @@ _bp_dvd_elements_process_message (BansheePlayer *player, GstMessage *message)
         }
     }
 
+    bp_debug2 ("bp_dvd: navigation commands changed, in menu: %s", player->is_menu ? "YES" : "NO");
+
     gst_query_unref (query);
+    gst_object_unref (navigation);
 }
 
 gboolean
@@ -126,6 +188,7 @@ _bp_dvd_handle_uri (BansheePlayer *player, const gchar *uri)
             bp_debug2 ("bp_dvd: finished using device (%s)", player->dvd_device);
             g_free (player->dvd_device);
             player->dvd_device = NULL;
+            player->is_menu = FALSE;
         }
 
         return FALSE;
@@ -157,33 +220,39 @@ _bp_dvd_handle_uri (BansheePlayer *player, const gchar *uri)
     return FALSE;
 }
 
+// Called from the main loop and from the video sink's streaming thread
+// when autovideosink plugs its real sink
 void _bp_dvd_find_navigation (BansheePlayer *player)
 {
     GstElement *video_sink = NULL;
     GstElement *navigation = NULL;
     GstNavigation *previous_navigation;
 
-    previous_navigation = player->navigation;
-    g_object_get (player->playbin, "video-sink", &video_sink, NULL);
+    if (player->playbin != NULL) {
+        g_object_get (player->playbin, "video-sink", &video_sink, NULL);
+    }
 
-    if (video_sink == NULL) {
-        player->navigation = NULL;
-        if (previous_navigation != NULL) {
-            gst_object_unref (previous_navigation);
+    if (video_sink != NULL) {
+        navigation = GST_IS_BIN (video_sink)
+            ? gst_bin_get_by_interface (GST_BIN (video_sink), GST_TYPE_NAVIGATION)
+            : gst_object_ref (video_sink);
+
+        if (navigation != NULL && !GST_IS_NAVIGATION (navigation)) {
+            gst_object_unref (navigation);
+            navigation = NULL;
         }
-    }
 
-    navigation = GST_IS_BIN (video_sink)
-        ? gst_bin_get_by_interface (GST_BIN (video_sink), GST_TYPE_NAVIGATION)
-        : video_sink;
+        gst_object_unref (video_sink);
+    }
 
-    player->navigation = GST_IS_NAVIGATION (navigation) ? GST_NAVIGATION (navigation) : NULL;
+    g_mutex_lock (player->navigation_mutex);
+    previous_navigation = player->navigation;
+    player->navigation = navigation != NULL ? GST_NAVIGATION (navigation) : NULL;
+    g_mutex_unlock (player->navigation_mutex);
 
     if (previous_navigation != NULL) {
         gst_object_unref (previous_navigation);
     }
-
-    gst_object_unref (video_sink);
 }
 
 P_INVOKE gboolean
@@ -195,100 +264,55 @@ bp_dvd_is_menu (BansheePlayer *player)
 P_INVOKE void
 bp_dvd_mouse_move_notify (BansheePlayer *player, double x, double y)
 {
-    if (!player->navigation) {
-        _bp_dvd_find_navigation (player);
-    }
-    if (player->navigation) {
-        gst_navigation_send_mouse_event (player->navigation, "mouse-move", 0, x, y);
-    }
+    bp_dvd_send_mouse_event (player, "mouse-move", 0, x, y);
 }
 
 P_INVOKE void
 bp_dvd_mouse_button_pressed_notify (BansheePlayer *player, int button, double x, double y)
 {
-    if (!player->navigation) {
-        _bp_dvd_find_navigation (player);
-    }
-    if (player->navigation) {
-        gst_navigation_send_mouse_event (player->navigation, "mouse-button-press", button, x, y);
-    }
+    bp_dvd_send_mouse_event (player, "mouse-button-press", button, x, y);
 }
 
 P_INVOKE void
 bp_dvd_mouse_button_released_notify (BansheePlayer *player, int button, double x, double y)
 {
-    if (!player->navigation) {
-        _bp_dvd_find_navigation (player);
-    }
-    if (player->navigation) {
-        gst_navigation_send_mouse_event (player->navigation, "mouse-button-release", button, x, y);
-    }
+    bp_dvd_send_mouse_event (player, "mouse-button-release", button, x, y);
 }
 
 P_INVOKE void
 bp_dvd_left_notify (BansheePlayer *player)
 {
-    if (!player->navigation) {
-        _bp_dvd_find_navigation (player);
-    }
-    if (player->navigation) {
-        gst_navigation_send_command (player->navigation, GST_NAVIGATION_COMMAND_LEFT);
-    }
+    bp_dvd_send_command (player, GST_NAVIGATION_COMMAND_LEFT);
 }
 
 P_INVOKE void
 bp_dvd_right_notify (BansheePlayer *player)
 {
-    if (!player->navigation) {
-        _bp_dvd_find_navigation (player);
-    }
-    if (player->navigation) {
-        gst_navigation_send_command (player->navigation, GST_NAVIGATION_COMMAND_RIGHT);
-    }
+    bp_dvd_send_command (player, GST_NAVIGATION_COMMAND_RIGHT);
 }
 
 P_INVOKE void
 bp_dvd_up_notify (BansheePlayer *player)
 {
-    if (!player->navigation) {
-        _bp_dvd_find_navigation (player);
-    }
-    if (player->navigation) {
-        gst_navigation_send_command (player->navigation, GST_NAVIGATION_COMMAND_UP);
-    }
+    bp_dvd_send_command (player, GST_NAVIGATION_COMMAND_UP);
 }
 
 P_INVOKE void
 bp_dvd_down_notify (BansheePlayer *player)
 {
-    if (!player->navigation) {
-        _bp_dvd_find_navigation (player);
-    }
-    if (player->navigation) {
-        gst_navigation_send_command (player->navigation, GST_NAVIGATION_COMMAND_DOWN);
-    }
+    bp_dvd_send_command (player, GST_NAVIGATION_COMMAND_DOWN);
 }
 
 P_INVOKE void
 bp_dvd_activate_notify (BansheePlayer *player)
 {
-    if (!player->navigation) {
-        _bp_dvd_find_navigation (player);
-    }
-    if (player->navigation) {
-        gst_navigation_send_command (player->navigation, GST_NAVIGATION_COMMAND_ACTIVATE);
-    }
+    bp_dvd_send_command (player, GST_NAVIGATION_COMMAND_ACTIVATE);
 }
 
 P_INVOKE void
 bp_dvd_go_to_menu (BansheePlayer *player)
 {
-    if (!player->navigation) {
-        _bp_dvd_find_navigation (player);
-    }
-    if (player->navigation) {
-        gst_navigation_send_command (player->navigation, GST_NAVIGATION_COMMAND_DVD_MENU);
-    }
+    bp_dvd_send_command (player, GST_NAVIGATION_COMMAND_DVD_MENU);
 }
 
 P_INVOKE void
@@ -0,0 +1,134 @@
+//
+// banshee-player-latency.c
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "banshee-player-latency.h"
+
+// ---------------------------------------------------------------------------
+// Private Functions
+// ---------------------------------------------------------------------------
+
+static GstPadProbeReturn
+bp_latency_decoded_probe (GstPad *pad, GstPadProbeInfo *info, BansheePlayer *player)
+{
+    _bp_latency_mark (player, BP_OPEN_MILESTONE_FIRST_DECODED);
+    return GST_PAD_PROBE_OK;
+}
+
+// The sink prerolls on its first buffer in PAUSED, before anything is
+// heard, and blocks the next one until it is PLAYING and has rendered the
+// preroll buffer; that next buffer is what marks the track as audible
+static GstPadProbeReturn
+bp_latency_audible_probe (GstPad *pad, GstPadProbeInfo *info, BansheePlayer *player)
+{
+    GstElement *sink = GST_ELEMENT (GST_PAD_PARENT (pad));
+
+    if (sink != NULL && GST_STATE (sink) == GST_STATE_PLAYING) {
+        _bp_latency_mark (player, BP_OPEN_MILESTONE_FIRST_AUDIBLE);
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+static void
+bp_latency_on_notify_source (GstElement *playbin, GParamSpec *param, BansheePlayer *player)
+{
+    _bp_latency_mark (player, BP_OPEN_MILESTONE_SOURCE_SETUP);
+}
+
+static void
+bp_latency_add_probe (GstElement *element, GstPadProbeCallback callback, BansheePlayer *player)
+{
+    GstPad *pad;
+
+    if (element != NULL && (pad = gst_element_get_static_pad (element, "sink")) != NULL) {
+        gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+            callback, player, NULL);
+        gst_object_unref (pad);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Internal Functions
+// ---------------------------------------------------------------------------
+
+void
+_bp_latency_pipeline_setup (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    g_signal_connect (player->playbin, "notify::source", G_CALLBACK (bp_latency_on_notify_source), player);
+    bp_latency_add_probe (player->audiotee, (GstPadProbeCallback)bp_latency_decoded_probe, player);
+    _bp_latency_watch_sink (player, player->audiosink);
+}
+
+// Also called when the output device switch puts a new sink in place
+void
+_bp_latency_watch_sink (BansheePlayer *player, GstElement *sink)
+{
+    bp_latency_add_probe (sink, (GstPadProbeCallback)bp_latency_audible_probe, player);
+}
+
+void
+_bp_latency_reset (BansheePlayer *player)
+{
+    gint i;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    for (i = 0; i < BP_OPEN_MILESTONE_COUNT; i++) {
+        player->open_milestones[i] = -1;
+    }
+    player->open_started = gst_util_get_timestamp ();
+}
+
+// Called from streaming threads for every buffer, so a milestone that was
+// already reached costs a single compare
+void
+_bp_latency_mark (BansheePlayer *player, BpOpenMilestone milestone)
+{
+    if (G_LIKELY (player->open_milestones[milestone] >= 0)) {
+        return;
+    }
+
+    player->open_milestones[milestone] = (gint64)((gst_util_get_timestamp () - player->open_started) / GST_USECOND);
+    bp_debug3 ("[latency] milestone %d after %" G_GINT64_FORMAT " us", milestone, player->open_milestones[milestone]);
+}
+
+// ---------------------------------------------------------------------------
+// Public Functions
+// ---------------------------------------------------------------------------
+
+P_INVOKE void
+bp_get_last_open_timings (BansheePlayer *player, BpOpenTimings *timings)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+    g_return_if_fail (timings != NULL);
+
+    timings->uri_set_us = player->open_milestones[BP_OPEN_MILESTONE_URI_SET];
+    timings->source_setup_us = player->open_milestones[BP_OPEN_MILESTONE_SOURCE_SETUP];
+    timings->first_decoded_us = player->open_milestones[BP_OPEN_MILESTONE_FIRST_DECODED];
+    timings->async_done_us = player->open_milestones[BP_OPEN_MILESTONE_ASYNC_DONE];
+    timings->first_audible_us = player->open_milestones[BP_OPEN_MILESTONE_FIRST_AUDIBLE];
+}
@@ -0,0 +1,46 @@
+//
+// banshee-player-latency.h
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef _BANSHEE_PLAYER_LATENCY_H
+#define _BANSHEE_PLAYER_LATENCY_H
+
+#include "banshee-player-private.h"
+
+// Microseconds from bp_open to each milestone, -1 when it was not reached
+typedef struct {
+    gint64 uri_set_us;         // playbin was handed the URI
+    gint64 source_setup_us;    // the source element was created
+    gint64 first_decoded_us;   // first buffer at the audiotee
+    gint64 async_done_us;      // the pipeline prerolled
+    gint64 first_audible_us;   // first buffer at the audio sink once it is playing
+} BpOpenTimings;
+
+void      _bp_latency_pipeline_setup   (BansheePlayer *player);
+void      _bp_latency_watch_sink       (BansheePlayer *player, GstElement *sink);
+void      _bp_latency_reset            (BansheePlayer *player);
+void      _bp_latency_mark             (BansheePlayer *player, BpOpenMilestone milestone);
+
+#endif /* _BANSHEE_PLAYER_LATENCY_H */
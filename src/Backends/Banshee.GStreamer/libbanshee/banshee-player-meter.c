@@ -0,0 +1,682 @@
+//
+// banshee-player-meter.c
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <math.h>
+#include <gst/audio/audio.h>
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+#include "banshee-player-meter.h"
+
+// Level metering straight off the primary audio sink's sink pad: no queue,
+// converter or resampler, just a buffer probe that converts to float once
+// and does a few passes over the samples. Tapping in front of the sink
+// means the levels follow what is heard, after the equalizer, ReplayGain
+// and our own volume element, only ahead by the device buffer. It costs
+// nothing until a client enables it.
+
+#define BP_METER_FLOOR_DB -120.0
+
+// The momentary window is four 100 ms blocks
+#define BP_METER_BLOCKS 4
+
+// ITU-R BS.1770-4 Annex 2: 4x oversampling for true-peak, 12 taps per phase
+#define BP_METER_TP_PHASES 4
+#define BP_METER_TP_TAPS 12
+
+static const gfloat bp_meter_tp_coefficients[BP_METER_TP_PHASES][BP_METER_TP_TAPS] = {
+    {  0.0017089843750f,  0.0109863281250f, -0.0196533203125f,  0.0332031250000f,
+      -0.0594482421875f,  0.1373291015625f,  0.9721679687500f, -0.1022949218750f,
+       0.0476074218750f, -0.0266113281250f,  0.0148925781250f, -0.0083007812500f },
+    { -0.0291748046875f,  0.0292968750000f, -0.0517578125000f,  0.0891113281250f,
+      -0.1665039062500f,  0.4650878906250f,  0.7797851562500f, -0.2003173828125f,
+       0.1015625000000f, -0.0582275390625f,  0.0330810546875f, -0.0189208984375f },
+    { -0.0189208984375f,  0.0330810546875f, -0.0582275390625f,  0.1015625000000f,
+      -0.2003173828125f,  0.7797851562500f,  0.4650878906250f, -0.1665039062500f,
+       0.0891113281250f, -0.0517578125000f,  0.0292968750000f, -0.0291748046875f },
+    { -0.0083007812500f,  0.0148925781250f, -0.0266113281250f,  0.0476074218750f,
+      -0.1022949218750f,  0.9721679687500f,  0.1373291015625f, -0.0594482421875f,
+       0.0332031250000f, -0.0196533203125f,  0.0109863281250f,  0.0017089843750f }
+};
+
+struct BpMeter {
+    GMutex *mutex;
+    volatile gint enabled;
+
+    // Stream format, from the last caps event
+    GstAudioFormat format;
+    gint channels;
+    gint rate;
+    gint bpf;
+    gdouble weights[BP_METER_MAX_CHANNELS];
+
+    // Accumulated since the last snapshot
+    gdouble sum_squares[BP_METER_MAX_CHANNELS];
+    guint64 frames;
+    gfloat peak[BP_METER_MAX_CHANNELS];
+    gfloat true_peak[BP_METER_MAX_CHANNELS];
+
+    // K-weighting: a high shelf then a high pass, direct form II transposed
+    gdouble shelf_b[3], shelf_a[3], highpass_b[3], highpass_a[3];
+    gdouble shelf_z[BP_METER_MAX_CHANNELS][2];
+    gdouble highpass_z[BP_METER_MAX_CHANNELS][2];
+
+    // Mean square of K-weighted audio per 100 ms block
+    gdouble block_sum[BP_METER_MAX_CHANNELS];
+    guint block_frames;
+    guint block_size;
+    gdouble blocks[BP_METER_BLOCKS][BP_METER_MAX_CHANNELS];
+    guint blocks_filled;
+    guint block_next;
+
+    // Last input samples per channel for the oversampling filter
+    gfloat tp_history[BP_METER_MAX_CHANNELS][BP_METER_TP_TAPS - 1];
+
+    // Conversion buffer for formats other than F32
+    gfloat *scratch;
+    gsize scratch_size;
+
+    // One channel of the buffer behind its filter history, for true-peak
+    gfloat *tp_scratch;
+    gsize tp_scratch_size;
+};
+
+// ---------------------------------------------------------------------------
+// Private Functions
+// ---------------------------------------------------------------------------
+
+static gdouble
+bp_meter_to_db (gdouble amplitude)
+{
+    return amplitude > 0 ? MAX (20.0 * log10 (amplitude), BP_METER_FLOOR_DB) : BP_METER_FLOOR_DB;
+}
+
+static gdouble
+bp_meter_to_lufs (gdouble mean_square)
+{
+    return mean_square > 0 ? MAX (-0.691 + 10.0 * log10 (mean_square), BP_METER_FLOOR_DB) : BP_METER_FLOOR_DB;
+}
+
+// Called with the lock held
+static void
+bp_meter_reset_state (BpMeter *meter)
+{
+    memset (meter->sum_squares, 0, sizeof (meter->sum_squares));
+    memset (meter->peak, 0, sizeof (meter->peak));
+    memset (meter->true_peak, 0, sizeof (meter->true_peak));
+    memset (meter->shelf_z, 0, sizeof (meter->shelf_z));
+    memset (meter->highpass_z, 0, sizeof (meter->highpass_z));
+    memset (meter->block_sum, 0, sizeof (meter->block_sum));
+    memset (meter->blocks, 0, sizeof (meter->blocks));
+    memset (meter->tp_history, 0, sizeof (meter->tp_history));
+    meter->frames = 0;
+    meter->block_frames = 0;
+    meter->blocks_filled = 0;
+    meter->block_next = 0;
+}
+
+// K-weighting filters for any sample rate, from the BS.1770 analog
+// prototypes (the same derivation libebur128 uses)
+static void
+bp_meter_configure_filters (BpMeter *meter)
+{
+    gdouble f0, gain, q, k, vh, vb, a0;
+
+    f0 = 1681.974450955533;
+    gain = 3.999843853973347;
+    q = 0.7071752369554196;
+    k = tan (G_PI * f0 / meter->rate);
+    vh = pow (10.0, gain / 20.0);
+    vb = pow (vh, 0.4996667741545416);
+    a0 = 1.0 + k / q + k * k;
+    meter->shelf_b[0] = (vh + vb * k / q + k * k) / a0;
+    meter->shelf_b[1] = 2.0 * (k * k - vh) / a0;
+    meter->shelf_b[2] = (vh - vb * k / q + k * k) / a0;
+    meter->shelf_a[0] = 1.0;
+    meter->shelf_a[1] = 2.0 * (k * k - 1.0) / a0;
+    meter->shelf_a[2] = (1.0 - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan (G_PI * f0 / meter->rate);
+    a0 = 1.0 + k / q + k * k;
+    meter->highpass_b[0] = 1.0;
+    meter->highpass_b[1] = -2.0;
+    meter->highpass_b[2] = 1.0;
+    meter->highpass_a[0] = 1.0;
+    meter->highpass_a[1] = 2.0 * (k * k - 1.0) / a0;
+    meter->highpass_a[2] = (1.0 - k / q + k * k) / a0;
+}
+
+static void
+bp_meter_set_caps (BpMeter *meter, GstCaps *caps)
+{
+    GstAudioInfo info;
+    gint i;
+
+    g_mutex_lock (meter->mutex);
+
+    meter->format = GST_AUDIO_FORMAT_UNKNOWN;
+    if (gst_audio_info_from_caps (&info, caps) &&
+        GST_AUDIO_INFO_LAYOUT (&info) == GST_AUDIO_LAYOUT_INTERLEAVED &&
+        GST_AUDIO_INFO_CHANNELS (&info) <= BP_METER_MAX_CHANNELS &&
+        (GST_AUDIO_INFO_FORMAT (&info) == GST_AUDIO_FORMAT_F32 ||
+         GST_AUDIO_INFO_FORMAT (&info) == GST_AUDIO_FORMAT_F64 ||
+         GST_AUDIO_INFO_FORMAT (&info) == GST_AUDIO_FORMAT_S16 ||
+         GST_AUDIO_INFO_FORMAT (&info) == GST_AUDIO_FORMAT_S32)) {
+        meter->format = GST_AUDIO_INFO_FORMAT (&info);
+        meter->channels = GST_AUDIO_INFO_CHANNELS (&info);
+        meter->bpf = GST_AUDIO_INFO_BPF (&info);
+        meter->rate = GST_AUDIO_INFO_RATE (&info);
+        meter->block_size = MAX (meter->rate / 10, 1);
+
+        // BS.1770 channel weights: surround channels count more, LFE not at all
+        for (i = 0; i < meter->channels; i++) {
+            switch (info.position[i]) {
+                case GST_AUDIO_CHANNEL_POSITION_LFE1:
+                case GST_AUDIO_CHANNEL_POSITION_LFE2:
+                    meter->weights[i] = 0.0;
+                    break;
+                case GST_AUDIO_CHANNEL_POSITION_REAR_LEFT:
+                case GST_AUDIO_CHANNEL_POSITION_REAR_RIGHT:
+                case GST_AUDIO_CHANNEL_POSITION_SIDE_LEFT:
+                case GST_AUDIO_CHANNEL_POSITION_SIDE_RIGHT:
+                    meter->weights[i] = 1.41;
+                    break;
+                default:
+                    meter->weights[i] = 1.0;
+                    break;
+            }
+        }
+
+        bp_meter_configure_filters (meter);
+    }
+
+    bp_meter_reset_state (meter);
+    g_mutex_unlock (meter->mutex);
+}
+
+// Returns the buffer's samples as interleaved floats, converting into the
+// scratch buffer unless they already are
+static const gfloat *
+bp_meter_get_samples (BpMeter *meter, const guint8 *data, gsize samples)
+{
+    gfloat *out;
+    gsize i;
+
+    if (meter->format == GST_AUDIO_FORMAT_F32) {
+        return (const gfloat *)data;
+    }
+
+    if (meter->scratch_size < samples) {
+        meter->scratch = g_renew (gfloat, meter->scratch, samples);
+        meter->scratch_size = samples;
+    }
+    out = meter->scratch;
+
+    switch (meter->format) {
+        case GST_AUDIO_FORMAT_F64:
+            for (i = 0; i < samples; i++) {
+                out[i] = (gfloat)((const gdouble *)data)[i];
+            }
+            break;
+        case GST_AUDIO_FORMAT_S16:
+            for (i = 0; i < samples; i++) {
+                out[i] = ((const gint16 *)data)[i] * (1.0f / 32768.0f);
+            }
+            break;
+        case GST_AUDIO_FORMAT_S32:
+            for (i = 0; i < samples; i++) {
+                out[i] = ((const gint32 *)data)[i] * (1.0f / 2147483648.0f);
+            }
+            break;
+        default:
+            return NULL;
+    }
+
+    return out;
+}
+
+// Sample peak and sum of squares. With SSE2 and 1, 2 or 4 channels every
+// vector lane holds the same channel throughout, so four samples are done
+// at a time and the lanes folded into channels at the end.
+static void
+bp_meter_accumulate_levels (BpMeter *meter, const gfloat *samples, gsize count)
+{
+    gint channels = meter->channels;
+    gsize i = 0;
+
+#ifdef __SSE2__
+    if (4 % channels == 0 && count >= 4) {
+        const __m128 abs_mask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+        __m128 sum = _mm_setzero_ps ();
+        __m128 peak = _mm_setzero_ps ();
+        gfloat lane_sum[4], lane_peak[4];
+        gint lane;
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 v = _mm_loadu_ps (samples + i);
+            sum = _mm_add_ps (sum, _mm_mul_ps (v, v));
+            peak = _mm_max_ps (peak, _mm_and_ps (v, abs_mask));
+        }
+
+        _mm_storeu_ps (lane_sum, sum);
+        _mm_storeu_ps (lane_peak, peak);
+        for (lane = 0; lane < 4; lane++) {
+            meter->sum_squares[lane % channels] += lane_sum[lane];
+            meter->peak[lane % channels] = MAX (meter->peak[lane % channels], lane_peak[lane]);
+        }
+    }
+#endif
+
+    // i counts interleaved samples, so the channel is i % channels
+    for (; i < count; i++) {
+        gint channel = i % channels;
+        gfloat value = samples[i];
+        meter->sum_squares[channel] += value * value;
+        meter->peak[channel] = MAX (meter->peak[channel], fabsf (value));
+    }
+}
+
+// Runs frames [start, start + count) of the buffer through the K-weighting
+// filters, adding to the current block. The recursion is serial in time,
+// so with SSE2 two channels share a vector instead; the filters stay in
+// double precision since the 38 Hz high pass has its poles right next to
+// the unit circle.
+static void
+bp_meter_filter_frames (BpMeter *meter, const gfloat *samples, gsize start, gsize count)
+{
+    gint channels = meter->channels;
+    gint channel = 0;
+    gsize frame;
+
+#ifdef __SSE2__
+    const __m128d sb0 = _mm_set1_pd (meter->shelf_b[0]), sb1 = _mm_set1_pd (meter->shelf_b[1]);
+    const __m128d sb2 = _mm_set1_pd (meter->shelf_b[2]), sa1 = _mm_set1_pd (meter->shelf_a[1]);
+    const __m128d sa2 = _mm_set1_pd (meter->shelf_a[2]), hb0 = _mm_set1_pd (meter->highpass_b[0]);
+    const __m128d hb1 = _mm_set1_pd (meter->highpass_b[1]), hb2 = _mm_set1_pd (meter->highpass_b[2]);
+    const __m128d ha1 = _mm_set1_pd (meter->highpass_a[1]), ha2 = _mm_set1_pd (meter->highpass_a[2]);
+
+    for (; channel + 2 <= channels; channel += 2) {
+        __m128d sz0 = _mm_set_pd (meter->shelf_z[channel + 1][0], meter->shelf_z[channel][0]);
+        __m128d sz1 = _mm_set_pd (meter->shelf_z[channel + 1][1], meter->shelf_z[channel][1]);
+        __m128d hz0 = _mm_set_pd (meter->highpass_z[channel + 1][0], meter->highpass_z[channel][0]);
+        __m128d hz1 = _mm_set_pd (meter->highpass_z[channel + 1][1], meter->highpass_z[channel][1]);
+        __m128d sum = _mm_setzero_pd ();
+        gdouble lanes[2];
+
+        for (frame = start; frame < start + count; frame++) {
+            const gfloat *in = samples + frame * channels + channel;
+            __m128d x = _mm_set_pd (in[1], in[0]);
+            __m128d y = _mm_add_pd (_mm_mul_pd (sb0, x), sz0);
+            sz0 = _mm_add_pd (_mm_sub_pd (_mm_mul_pd (sb1, x), _mm_mul_pd (sa1, y)), sz1);
+            sz1 = _mm_sub_pd (_mm_mul_pd (sb2, x), _mm_mul_pd (sa2, y));
+
+            x = y;
+            y = _mm_add_pd (_mm_mul_pd (hb0, x), hz0);
+            hz0 = _mm_add_pd (_mm_sub_pd (_mm_mul_pd (hb1, x), _mm_mul_pd (ha1, y)), hz1);
+            hz1 = _mm_sub_pd (_mm_mul_pd (hb2, x), _mm_mul_pd (ha2, y));
+
+            sum = _mm_add_pd (sum, _mm_mul_pd (y, y));
+        }
+
+        _mm_storel_pd (&meter->shelf_z[channel][0], sz0);
+        _mm_storeh_pd (&meter->shelf_z[channel + 1][0], sz0);
+        _mm_storel_pd (&meter->shelf_z[channel][1], sz1);
+        _mm_storeh_pd (&meter->shelf_z[channel + 1][1], sz1);
+        _mm_storel_pd (&meter->highpass_z[channel][0], hz0);
+        _mm_storeh_pd (&meter->highpass_z[channel + 1][0], hz0);
+        _mm_storel_pd (&meter->highpass_z[channel][1], hz1);
+        _mm_storeh_pd (&meter->highpass_z[channel + 1][1], hz1);
+        _mm_storeu_pd (lanes, sum);
+        meter->block_sum[channel] += lanes[0];
+        meter->block_sum[channel + 1] += lanes[1];
+    }
+#endif
+
+    for (; channel < channels; channel++) {
+        gdouble sz0 = meter->shelf_z[channel][0], sz1 = meter->shelf_z[channel][1];
+        gdouble hz0 = meter->highpass_z[channel][0], hz1 = meter->highpass_z[channel][1];
+        gdouble sum = 0;
+
+        for (frame = start; frame < start + count; frame++) {
+            gdouble x = samples[frame * channels + channel];
+            gdouble y;
+
+            y = meter->shelf_b[0] * x + sz0;
+            sz0 = meter->shelf_b[1] * x - meter->shelf_a[1] * y + sz1;
+            sz1 = meter->shelf_b[2] * x - meter->shelf_a[2] * y;
+
+            x = y;
+            y = meter->highpass_b[0] * x + hz0;
+            hz0 = meter->highpass_b[1] * x - meter->highpass_a[1] * y + hz1;
+            hz1 = meter->highpass_b[2] * x - meter->highpass_a[2] * y;
+
+            sum += y * y;
+        }
+
+        meter->shelf_z[channel][0] = sz0;
+        meter->shelf_z[channel][1] = sz1;
+        meter->highpass_z[channel][0] = hz0;
+        meter->highpass_z[channel][1] = hz1;
+        meter->block_sum[channel] += sum;
+    }
+}
+
+static void
+bp_meter_accumulate_loudness (BpMeter *meter, const gfloat *samples, gsize frames)
+{
+    gint channels = meter->channels;
+    gsize frame = 0, count;
+    gint channel;
+
+    // Filter up to each 100 ms block boundary at a time
+    while (frame < frames) {
+        count = MIN (frames - frame, meter->block_size - meter->block_frames);
+        bp_meter_filter_frames (meter, samples, frame, count);
+        frame += count;
+        meter->block_frames += count;
+
+        if (meter->block_frames == meter->block_size) {
+            for (channel = 0; channel < channels; channel++) {
+                meter->blocks[meter->block_next][channel] = meter->block_sum[channel] / meter->block_size;
+                meter->block_sum[channel] = 0;
+            }
+            meter->block_next = (meter->block_next + 1) % BP_METER_BLOCKS;
+            meter->blocks_filled = MIN (meter->blocks_filled + 1, BP_METER_BLOCKS);
+            meter->block_frames = 0;
+        }
+    }
+}
+
+// Peak of the signal reconstructed between the samples, which is what a
+// DAC or a lossy encoder will actually have to produce. Each channel is
+// copied behind the last inputs of the previous buffer so the filter reads
+// straight from one array. With SSE2 the four phases are one vector, so a
+// frame costs 12 multiply-adds.
+static void
+bp_meter_accumulate_true_peak (BpMeter *meter, const gfloat *samples, gsize frames)
+{
+    const gsize history_size = BP_METER_TP_TAPS - 1;
+    gint channels = meter->channels;
+    gsize frame;
+    gint channel, phase, tap;
+    gfloat *x;
+
+#ifdef __SSE2__
+    const __m128 abs_mask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+    __m128 taps[BP_METER_TP_TAPS];
+
+    for (tap = 0; tap < BP_METER_TP_TAPS; tap++) {
+        taps[tap] = _mm_setr_ps (bp_meter_tp_coefficients[0][tap], bp_meter_tp_coefficients[1][tap],
+            bp_meter_tp_coefficients[2][tap], bp_meter_tp_coefficients[3][tap]);
+    }
+#endif
+
+    if (meter->tp_scratch_size < history_size + frames) {
+        meter->tp_scratch = g_renew (gfloat, meter->tp_scratch, history_size + frames);
+        meter->tp_scratch_size = history_size + frames;
+    }
+    x = meter->tp_scratch;
+
+    for (channel = 0; channel < channels; channel++) {
+        gfloat true_peak = meter->true_peak[channel];
+
+        memcpy (x, meter->tp_history[channel], history_size * sizeof (gfloat));
+        for (frame = 0; frame < frames; frame++) {
+            x[history_size + frame] = samples[frame * channels + channel];
+        }
+
+        // x[frame + history_size] is the newest input of the output frame
+#ifdef __SSE2__
+        {
+            __m128 peak = _mm_setzero_ps ();
+            gfloat lanes[BP_METER_TP_PHASES];
+
+            for (frame = 0; frame < frames; frame++) {
+                __m128 value = _mm_setzero_ps ();
+                for (tap = 0; tap < BP_METER_TP_TAPS; tap++) {
+                    value = _mm_add_ps (value, _mm_mul_ps (taps[tap], _mm_set1_ps (x[frame + history_size - tap])));
+                }
+                peak = _mm_max_ps (peak, _mm_and_ps (value, abs_mask));
+            }
+
+            _mm_storeu_ps (lanes, peak);
+            for (phase = 0; phase < BP_METER_TP_PHASES; phase++) {
+                true_peak = MAX (true_peak, lanes[phase]);
+            }
+        }
+#else
+        for (frame = 0; frame < frames; frame++) {
+            for (phase = 0; phase < BP_METER_TP_PHASES; phase++) {
+                gfloat value = 0;
+                for (tap = 0; tap < BP_METER_TP_TAPS; tap++) {
+                    value += bp_meter_tp_coefficients[phase][tap] * x[frame + history_size - tap];
+                }
+                true_peak = MAX (true_peak, fabsf (value));
+            }
+        }
+#endif
+
+        memcpy (meter->tp_history[channel], x + frames, history_size * sizeof (gfloat));
+        meter->true_peak[channel] = true_peak;
+    }
+}
+
+static void
+bp_meter_process (BpMeter *meter, GstBuffer *buffer)
+{
+    const gfloat *samples;
+    GstMapInfo map;
+    gsize frames, count;
+
+    if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+        return;
+    }
+
+    g_mutex_lock (meter->mutex);
+
+    if (meter->format != GST_AUDIO_FORMAT_UNKNOWN && meter->bpf > 0) {
+        frames = map.size / meter->bpf;
+        count = frames * meter->channels;
+        if (count > 0 && (samples = bp_meter_get_samples (meter, map.data, count)) != NULL) {
+            bp_meter_accumulate_levels (meter, samples, count);
+            bp_meter_accumulate_loudness (meter, samples, frames);
+            bp_meter_accumulate_true_peak (meter, samples, frames);
+            meter->frames += frames;
+        }
+    }
+
+    g_mutex_unlock (meter->mutex);
+    gst_buffer_unmap (buffer, &map);
+}
+
+static GstPadProbeReturn
+bp_meter_probe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    BpMeter *meter = (BpMeter *)user_data;
+
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+        if (!g_atomic_int_get (&meter->enabled)) {
+            return GST_PAD_PROBE_OK;
+        }
+        bp_meter_process (meter, GST_PAD_PROBE_INFO_BUFFER (info));
+    } else if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+        if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+            GstCaps *caps;
+            gst_event_parse_caps (event, &caps);
+            bp_meter_set_caps (meter, caps);
+        } else if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
+            g_mutex_lock (meter->mutex);
+            bp_meter_reset_state (meter);
+            g_mutex_unlock (meter->mutex);
+        }
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+// ---------------------------------------------------------------------------
+// Internal Functions
+// ---------------------------------------------------------------------------
+
+void
+_bp_meter_init (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    player->meter = g_new0 (BpMeter, 1);
+    player->meter->mutex = g_mutex_new ();
+    player->meter->format = GST_AUDIO_FORMAT_UNKNOWN;
+}
+
+void
+_bp_meter_destroy (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    if (player->meter == NULL) {
+        return;
+    }
+
+    g_mutex_free (player->meter->mutex);
+    g_free (player->meter->scratch);
+    g_free (player->meter->tp_scratch);
+    g_free (player->meter);
+    player->meter = NULL;
+}
+
+void
+_bp_meter_pipeline_setup (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    _bp_meter_watch_sink (player, player->audiosink);
+}
+
+// Also called when the output device switch puts a new sink in place; the
+// probe goes away with the old sink and the sticky caps event reaches the
+// new one before any buffer
+void
+_bp_meter_watch_sink (BansheePlayer *player, GstElement *sink)
+{
+    GstPad *pad;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    // Events are watched even while the meter is off, so it knows the
+    // format of the current stream when it is turned on
+    if (sink != NULL && (pad = gst_element_get_static_pad (sink, "sink")) != NULL) {
+        gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+            bp_meter_probe, player->meter, NULL);
+        gst_object_unref (pad);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public Functions
+// ---------------------------------------------------------------------------
+
+P_INVOKE void
+bp_set_meter_enabled (BansheePlayer *player, gboolean enabled)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    // Filter state from before it was turned off would be stale
+    g_mutex_lock (player->meter->mutex);
+    bp_meter_reset_state (player->meter);
+    g_mutex_unlock (player->meter->mutex);
+
+    g_atomic_int_set (&player->meter->enabled, enabled ? 1 : 0);
+}
+
+P_INVOKE void
+bp_get_meter_snapshot (BansheePlayer *player, BpMeterSnapshot *snapshot)
+{
+    BpMeter *meter;
+    gdouble total = 0, gain = 1.0;
+    gint channel;
+    guint block;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+    g_return_if_fail (snapshot != NULL);
+
+    meter = player->meter;
+    memset (snapshot, 0, sizeof (BpMeterSnapshot));
+    for (channel = 0; channel < BP_METER_MAX_CHANNELS; channel++) {
+        snapshot->rms_db[channel] = BP_METER_FLOOR_DB;
+        snapshot->peak_db[channel] = BP_METER_FLOOR_DB;
+        snapshot->true_peak_db[channel] = BP_METER_FLOOR_DB;
+        snapshot->momentary_lufs[channel] = BP_METER_FLOOR_DB;
+    }
+    snapshot->momentary_lufs_total = BP_METER_FLOOR_DB;
+
+    g_mutex_lock (meter->mutex);
+
+    if (meter->format == GST_AUDIO_FORMAT_UNKNOWN) {
+        g_mutex_unlock (meter->mutex);
+        return;
+    }
+
+    // A sink with its own volume control applies the user volume after the
+    // tap, so it is applied here instead
+    if (player->audiosink_has_volume) {
+        gain = player->current_volume;
+    }
+
+    snapshot->channels = meter->channels;
+    for (channel = 0; channel < meter->channels; channel++) {
+        gdouble mean_square = 0;
+
+        if (meter->frames > 0) {
+            snapshot->rms_db[channel] = bp_meter_to_db (gain * sqrt (meter->sum_squares[channel] / meter->frames));
+            snapshot->peak_db[channel] = bp_meter_to_db (gain * meter->peak[channel]);
+            snapshot->true_peak_db[channel] = bp_meter_to_db (gain * MAX (meter->true_peak[channel], meter->peak[channel]));
+        }
+
+        if (meter->blocks_filled > 0) {
+            for (block = 0; block < meter->blocks_filled; block++) {
+                mean_square += meter->blocks[block][channel];
+            }
+            mean_square *= gain * gain / meter->blocks_filled;
+            snapshot->momentary_lufs[channel] = bp_meter_to_lufs (mean_square);
+            total += meter->weights[channel] * mean_square;
+        }
+    }
+
+    if (meter->blocks_filled > 0) {
+        snapshot->momentary_lufs_total = bp_meter_to_lufs (total);
+    }
+
+    // The next snapshot starts a new RMS and peak interval
+    memset (meter->sum_squares, 0, sizeof (meter->sum_squares));
+    memset (meter->peak, 0, sizeof (meter->peak));
+    memset (meter->true_peak, 0, sizeof (meter->true_peak));
+    meter->frames = 0;
+
+    g_mutex_unlock (meter->mutex);
+}
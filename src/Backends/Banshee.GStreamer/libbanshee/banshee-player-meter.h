@@ -0,0 +1,50 @@
+//
+// banshee-player-meter.h
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef _BANSHEE_PLAYER_METER_H
+#define _BANSHEE_PLAYER_METER_H
+
+#include "banshee-player-private.h"
+
+#define BP_METER_MAX_CHANNELS 8
+
+// Levels in dBFS (LUFS for loudness), BP_METER_FLOOR_DB for silence or
+// channels that are not there. RMS and the peaks cover the audio since the
+// previous snapshot; momentary loudness the last 400 ms (ITU-R BS.1770).
+typedef struct {
+    gint channels;
+    gdouble rms_db[BP_METER_MAX_CHANNELS];
+    gdouble peak_db[BP_METER_MAX_CHANNELS];
+    gdouble true_peak_db[BP_METER_MAX_CHANNELS];
+    gdouble momentary_lufs[BP_METER_MAX_CHANNELS];
+    gdouble momentary_lufs_total;
+} BpMeterSnapshot;
+
+void      _bp_meter_init            (BansheePlayer *player);
+void      _bp_meter_destroy         (BansheePlayer *player);
+void      _bp_meter_pipeline_setup  (BansheePlayer *player);
+void      _bp_meter_watch_sink      (BansheePlayer *player, GstElement *sink);
+
+#endif /* _BANSHEE_PLAYER_METER_H */
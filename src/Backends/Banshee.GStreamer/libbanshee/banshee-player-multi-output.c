@@ -0,0 +1,401 @@
+//
+// banshee-player-multi-output.c
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include "banshee-player-multi-output.h"
+#include "banshee-player-output.h"
+#include "banshee-output-manager.h"
+
+// Additional outputs each hang off the output tee, after the equalizer,
+// the volume and ReplayGain, as
+//
+//   queue (leaky) ! audioconvert ! audioresample ! volume ! sink
+//
+// The tee feeds the primary sink straight away, which blocks it once the
+// sink's ring buffer is full, so the extra queues must hold more than
+// that to only leak when their own sink really falls behind. The extra
+// sinks do not take part in preroll: the tee is stuck on the prerolled
+// primary sink until playback starts, so they would never get a buffer.
+#define BP_MULTI_OUTPUT_QUEUE_TIME (3 * GST_SECOND)
+
+typedef struct {
+    gint id;
+    gchar *device_id;
+    gdouble volume;
+    gint64 delay_us;           // device delay the sink does not report itself
+    gint64 compensation_us;    // ts-offset currently applied to the sink
+
+    // NULL while there is no pipeline
+    GstElement *bin;
+    GstElement *volume_element;
+    GstElement *sink;
+    GstPad *tee_pad;
+} BpOutputBranch;
+
+// ---------------------------------------------------------------------------
+// Private Functions
+// ---------------------------------------------------------------------------
+
+static BpOutputBranch *
+bp_multi_output_find (BansheePlayer *player, gint output_id)
+{
+    GSList *node;
+
+    for (node = player->output_branches; node != NULL; node = node->next) {
+        if (((BpOutputBranch *)node->data)->id == output_id) {
+            return (BpOutputBranch *)node->data;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+bp_multi_output_branch_free (BpOutputBranch *branch)
+{
+    g_free (branch->device_id);
+    g_free (branch);
+}
+
+// When the primary sink controls the device volume itself the master
+// volume never reaches the tee, so the branches apply it on their own
+static void
+bp_multi_output_apply_volume (BansheePlayer *player, BpOutputBranch *branch)
+{
+    gdouble volume = branch->volume;
+
+    if (branch->volume_element == NULL) {
+        return;
+    }
+
+    if (player->audiosink_has_volume) {
+        volume *= player->current_volume;
+    }
+
+    g_object_set (G_OBJECT (branch->volume_element), "volume", volume, NULL);
+}
+
+static gboolean
+bp_multi_output_build (BansheePlayer *player, BpOutputBranch *branch)
+{
+    GstElement *queue, *convert, *resample;
+    GstPad *pad;
+
+    if ((branch->sink = bom_create_sink (branch->device_id, NULL)) == NULL) {
+        bp_debug2 ("Output device %s is not available", branch->device_id);
+        return FALSE;
+    }
+
+    queue = gst_element_factory_make ("queue", NULL);
+    convert = gst_element_factory_make ("audioconvert", NULL);
+    resample = gst_element_factory_make ("audioresample", NULL);
+    branch->volume_element = gst_element_factory_make ("volume", NULL);
+
+    if (queue == NULL || convert == NULL || resample == NULL || branch->volume_element == NULL) {
+        bp_debug ("Could not create the elements of an output branch");
+        if (queue != NULL) gst_object_unref (queue);
+        if (convert != NULL) gst_object_unref (convert);
+        if (resample != NULL) gst_object_unref (resample);
+        if (branch->volume_element != NULL) gst_object_unref (branch->volume_element);
+        gst_object_unref (branch->sink);
+        branch->volume_element = branch->sink = NULL;
+        return FALSE;
+    }
+
+    g_object_set (G_OBJECT (queue),
+        "leaky", 2 /* downstream */,
+        "max-size-time", (guint64)BP_MULTI_OUTPUT_QUEUE_TIME,
+        "max-size-buffers", 0,
+        "max-size-bytes", 0,
+        NULL);
+    bp_multi_output_apply_volume (player, branch);
+
+    if (g_object_class_find_property (G_OBJECT_GET_CLASS (branch->sink), "async") != NULL) {
+        g_object_set (G_OBJECT (branch->sink), "async", FALSE, NULL);
+    }
+
+    branch->bin = gst_bin_new (NULL);
+    gst_bin_add_many (GST_BIN (branch->bin), queue, convert, resample, branch->volume_element, branch->sink, NULL);
+    gst_element_link_many (queue, convert, resample, branch->volume_element, branch->sink, NULL);
+
+    pad = gst_element_get_static_pad (queue, "sink");
+    gst_element_add_pad (branch->bin, gst_ghost_pad_new ("sink", pad));
+    gst_object_unref (pad);
+
+    // Bring the branch up before data can reach it
+    gst_bin_add (GST_BIN (player->audiobin), branch->bin);
+    gst_element_sync_state_with_parent (branch->bin);
+
+    branch->tee_pad = gst_element_get_request_pad (player->output_tee, "src_%u");
+    pad = gst_element_get_static_pad (branch->bin, "sink");
+    gst_pad_link (branch->tee_pad, pad);
+    gst_object_unref (pad);
+
+    return TRUE;
+}
+
+// Runs once the tee pad is not pushing, possibly on a streaming thread;
+// owns the branch elements from here on
+static GstPadProbeReturn
+bp_multi_output_unlink_cb (GstPad *tee_pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    GstElement *bin = GST_ELEMENT (user_data);
+    GstElement *tee = gst_pad_get_parent_element (tee_pad);
+    GstObject *audiobin = gst_object_get_parent (GST_OBJECT (bin));
+    GstPad *pad;
+
+    pad = gst_element_get_static_pad (bin, "sink");
+    gst_pad_unlink (tee_pad, pad);
+    gst_object_unref (pad);
+
+    if (tee != NULL) {
+        gst_element_release_request_pad (tee, tee_pad);
+        gst_object_unref (tee);
+    }
+
+    gst_element_set_state (bin, GST_STATE_NULL);
+    if (audiobin != NULL) {
+        gst_bin_remove (GST_BIN (audiobin), bin);
+        gst_object_unref (audiobin);
+    }
+
+    return GST_PAD_PROBE_REMOVE;
+}
+
+static void
+bp_multi_output_teardown (BpOutputBranch *branch)
+{
+    if (branch->bin == NULL) {
+        return;
+    }
+
+    gst_pad_add_probe (branch->tee_pad, GST_PAD_PROBE_TYPE_IDLE,
+        bp_multi_output_unlink_cb, gst_object_ref (branch->bin), gst_object_unref);
+
+    // The tee holds the request pad until the probe releases it
+    gst_object_unref (branch->tee_pad);
+    branch->bin = branch->volume_element = branch->sink = NULL;
+    branch->tee_pad = NULL;
+}
+
+// ts-offset lives on GstBaseSink, which may be inside an autodetect bin
+static GstElement *
+bp_multi_output_get_base_sink (GstElement *sink)
+{
+    return GST_IS_BASE_SINK (sink) ? sink : _bp_output_find_audio_base_sink (sink);
+}
+
+static void
+bp_multi_output_set_offset (GstElement *sink, gint64 offset_us)
+{
+    if (sink != NULL && (sink = bp_multi_output_get_base_sink (sink)) != NULL) {
+        g_object_set (G_OBJECT (sink), "ts-offset", offset_us * GST_USECOND, NULL);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Internal Functions
+// ---------------------------------------------------------------------------
+
+void
+_bp_multi_output_pipeline_setup (BansheePlayer *player)
+{
+    GSList *node;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    for (node = player->output_branches; node != NULL; node = node->next) {
+        bp_multi_output_build (player, (BpOutputBranch *)node->data);
+    }
+}
+
+// The elements go away with the playbin; the outputs are rebuilt with the
+// next pipeline
+void
+_bp_multi_output_pipeline_destroy (BansheePlayer *player)
+{
+    GSList *node;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    for (node = player->output_branches; node != NULL; node = node->next) {
+        BpOutputBranch *branch = (BpOutputBranch *)node->data;
+        if (branch->tee_pad != NULL) {
+            gst_object_unref (branch->tee_pad);
+        }
+        branch->bin = branch->volume_element = branch->sink = NULL;
+        branch->tee_pad = NULL;
+        branch->compensation_us = 0;
+    }
+}
+
+// Called whenever the master volume or where it is applied changes
+void
+_bp_multi_output_volume_changed (BansheePlayer *player)
+{
+    GSList *node;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    for (node = player->output_branches; node != NULL; node = node->next) {
+        bp_multi_output_apply_volume (player, (BpOutputBranch *)node->data);
+    }
+}
+
+void
+_bp_multi_output_destroy (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    _bp_multi_output_pipeline_destroy (player);
+    g_slist_foreach (player->output_branches, (GFunc)bp_multi_output_branch_free, NULL);
+    g_slist_free (player->output_branches);
+    player->output_branches = NULL;
+}
+
+// The pipeline already renders every sink at the same running time plus
+// the largest latency any of them reports, so the latency they report
+// needs no compensation. What is left are the device delays declared with
+// bp_set_output_delay: each sink, the primary one with no delay included,
+// is held back by how much less delay it has than the slowest device.
+void
+_bp_multi_output_align (BansheePlayer *player)
+{
+    GSList *node;
+    gint64 max_delay = 0;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    if (player->playbin == NULL) {
+        return;
+    }
+
+    for (node = player->output_branches; node != NULL; node = node->next) {
+        max_delay = MAX (max_delay, ((BpOutputBranch *)node->data)->delay_us);
+    }
+
+    bp_multi_output_set_offset (player->audiosink, max_delay);
+
+    for (node = player->output_branches; node != NULL; node = node->next) {
+        BpOutputBranch *branch = (BpOutputBranch *)node->data;
+        branch->compensation_us = max_delay - branch->delay_us;
+        bp_multi_output_set_offset (branch->sink, branch->compensation_us);
+    }
+
+    bp_debug2 ("Aligned outputs to %" G_GINT64_FORMAT "us", max_delay);
+}
+
+// ---------------------------------------------------------------------------
+// Public Functions
+// ---------------------------------------------------------------------------
+
+// Plays to another device alongside the primary output; returns an id for
+// the output or -1 if its sink could not be built
+P_INVOKE gint
+bp_add_output (BansheePlayer *player, const gchar *device_id, gdouble volume)
+{
+    BpOutputBranch *branch;
+
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), -1);
+    g_return_val_if_fail (device_id != NULL, -1);
+
+    branch = g_new0 (BpOutputBranch, 1);
+    branch->id = ++player->output_branch_last_id;
+    branch->device_id = g_strdup (device_id);
+    branch->volume = CLAMP (volume, 0.0, 1.0);
+
+    if (player->playbin != NULL && !bp_multi_output_build (player, branch)) {
+        bp_multi_output_branch_free (branch);
+        return -1;
+    }
+
+    player->output_branches = g_slist_append (player->output_branches, branch);
+    _bp_multi_output_align (player);
+
+    return branch->id;
+}
+
+P_INVOKE gboolean
+bp_remove_output (BansheePlayer *player, gint output_id)
+{
+    BpOutputBranch *branch;
+
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), FALSE);
+
+    if ((branch = bp_multi_output_find (player, output_id)) == NULL) {
+        return FALSE;
+    }
+
+    player->output_branches = g_slist_remove (player->output_branches, branch);
+    bp_multi_output_teardown (branch);
+    bp_multi_output_branch_free (branch);
+    _bp_multi_output_align (player);
+
+    return TRUE;
+}
+
+P_INVOKE void
+bp_set_output_volume (BansheePlayer *player, gint output_id, gdouble volume)
+{
+    BpOutputBranch *branch;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    if ((branch = bp_multi_output_find (player, output_id)) == NULL) {
+        return;
+    }
+
+    branch->volume = CLAMP (volume, 0.0, 1.0);
+    bp_multi_output_apply_volume (player, branch);
+}
+
+// Declares latency a device adds beyond what its sink reports, e.g. the
+// buffer of a network speaker
+P_INVOKE void
+bp_set_output_delay (BansheePlayer *player, gint output_id, gint64 delay_us)
+{
+    BpOutputBranch *branch;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    if ((branch = bp_multi_output_find (player, output_id)) == NULL) {
+        return;
+    }
+
+    branch->delay_us = MAX (delay_us, 0);
+    _bp_multi_output_align (player);
+}
+
+// How long the output is held back to line up with the others, -1 for an
+// unknown output
+P_INVOKE gint64
+bp_get_output_compensation (BansheePlayer *player, gint output_id)
+{
+    BpOutputBranch *branch;
+
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), -1);
+
+    branch = bp_multi_output_find (player, output_id);
+    return branch != NULL ? branch->compensation_us : -1;
+}
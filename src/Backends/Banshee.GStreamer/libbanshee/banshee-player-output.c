@@ -0,0 +1,521 @@
+//
+// banshee-player-output.c
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <gst/audio/audio.h>
+#include "banshee-player-output.h"
+#include "banshee-output-manager.h"
+#include "banshee-player-latency.h"
+#include "banshee-player-meter.h"
+#include "banshee-player-multi-output.h"
+#include "banshee-player-telemetry.h"
+
+// Ring buffer and audiosinkqueue sizes per BpOutputLatencyMode, in
+// microseconds; zero keeps the element's default. The queue behind the tee
+// has to stay so the visualization branch cannot stall the sink, but in
+// the low latency modes it only needs to cover a few device periods.
+static const struct {
+    guint64 buffer_time;
+    guint64 latency_time;
+    guint64 queue_time;
+} bp_output_latency_modes[] = {
+    { 0, 0, 0 },                    // BP_OUTPUT_LATENCY_STANDARD
+    { 40000, 10000, 100000 },       // BP_OUTPUT_LATENCY_LOW
+    { 20000, 5000, 40000 }          // BP_OUTPUT_LATENCY_ULTRA_LOW
+};
+
+// ---------------------------------------------------------------------------
+// Private Functions
+// ---------------------------------------------------------------------------
+
+static void
+bp_output_set_property (GstElement *element, const gchar *name, guint64 value)
+{
+    GParamSpec *pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (element), name);
+    GValue gvalue = { 0, };
+
+    if (pspec == NULL) {
+        return;
+    }
+
+    g_value_init (&gvalue, G_PARAM_SPEC_VALUE_TYPE (pspec));
+    if (value == 0) {
+        g_param_value_set_default (pspec, &gvalue);
+    } else if (G_VALUE_HOLDS_INT64 (&gvalue)) {
+        g_value_set_int64 (&gvalue, value);
+    } else if (G_VALUE_HOLDS_UINT64 (&gvalue)) {
+        g_value_set_uint64 (&gvalue, value);
+    } else if (G_VALUE_HOLDS_UINT (&gvalue)) {
+        g_value_set_uint (&gvalue, value);
+    }
+
+    g_object_set_property (G_OBJECT (element), name, &gvalue);
+    g_value_unset (&gvalue);
+}
+
+// The ring buffer is sized when the sink goes to PAUSED, so a change made
+// while playing is picked up by the next bp_open, which passes through READY
+static void
+bp_output_apply_latency_mode (BansheePlayer *player)
+{
+    GstElement *sink, *queue;
+    BpOutputLatencyMode mode = player->output_latency_mode;
+
+    if (player->playbin == NULL) {
+        return;
+    }
+
+    if ((sink = _bp_output_find_audio_base_sink (player->audiosink)) != NULL) {
+        bp_output_set_property (sink, "buffer-time", bp_output_latency_modes[mode].buffer_time);
+        bp_output_set_property (sink, "latency-time", bp_output_latency_modes[mode].latency_time);
+    }
+
+    if ((queue = gst_bin_get_by_name (GST_BIN (player->audiobin), "audiosinkqueue")) != NULL) {
+        bp_output_set_property (queue, "max-size-time", bp_output_latency_modes[mode].queue_time * GST_USECOND);
+        if (mode == BP_OUTPUT_LATENCY_STANDARD) {
+            // Zero restores the defaults here
+            bp_output_set_property (queue, "max-size-buffers", 0);
+            bp_output_set_property (queue, "max-size-bytes", 0);
+        } else {
+            // Bound the queue by time only; small buffers would hit the
+            // default buffer count limit long before
+            g_object_set (queue, "max-size-buffers", 0, "max-size-bytes", 0, NULL);
+        }
+        gst_object_unref (queue);
+    }
+
+    bp_debug3 ("Output latency mode %d: buffer-time %" G_GUINT64_FORMAT "us",
+        mode, bp_output_latency_modes[mode].buffer_time);
+}
+
+// Used when no device provider is available; autoaudiosink has to be set
+// READY to pick its child before we can tell whether that has a volume
+static GstElement *
+bp_output_autodetect_sink (BansheePlayer *player)
+{
+    GstElement *audiosink;
+
+    audiosink = gst_element_factory_make ("directsoundsink", "audiosink");
+    if (audiosink == NULL) {
+        audiosink = gst_element_factory_make ("autoaudiosink", "audiosink");
+        if (audiosink == NULL) {
+            audiosink = gst_element_factory_make ("alsasink", "audiosink");
+        }
+    }
+
+    if (audiosink == NULL) {
+        return NULL;
+    }
+
+    gst_element_set_state (audiosink, GST_STATE_READY);
+
+    // See if the audiosink has a 'volume' property.  If it does, we assume it saves and restores
+    // its volume information - and that we shouldn't
+    player->audiosink_has_volume = FALSE;
+    if (!GST_IS_BIN (audiosink)) {
+        player->audiosink_has_volume = g_object_class_find_property (G_OBJECT_GET_CLASS (audiosink), "volume") != NULL;
+    } else {
+        GstIterator *elem_iter = gst_bin_iterate_recurse (GST_BIN (audiosink));
+        BANSHEE_GST_ITERATOR_ITERATE (elem_iter, GstElement *, element, TRUE, {
+            player->audiosink_has_volume |= g_object_class_find_property (G_OBJECT_GET_CLASS (element), "volume") != NULL;
+        });
+    }
+
+    return audiosink;
+}
+
+// The element inside a sink that has the volume property, if any
+static GstElement *
+bp_output_find_volume_element (GstElement *sink)
+{
+    GstElement *volume_element = NULL;
+
+    if (sink == NULL) {
+        return NULL;
+    }
+
+    if (g_object_class_find_property (G_OBJECT_GET_CLASS (sink), "volume") != NULL) {
+        return sink;
+    }
+
+    if (GST_IS_BIN (sink)) {
+        GstIterator *iter = gst_bin_iterate_recurse (GST_BIN (sink));
+        BANSHEE_GST_ITERATOR_ITERATE (iter, GstElement *, element, TRUE, {
+            if (volume_element == NULL &&
+                g_object_class_find_property (G_OBJECT_GET_CLASS (element), "volume") != NULL) {
+                volume_element = element;
+            }
+        });
+    }
+
+    return volume_element;
+}
+
+// Replaces the audio sink with one for player->output_device, leaving the
+// decoders, the rest of the audiobin and the position alone. Runs blocked
+// on audiosinkqueue's src pad while playing; holds the ReplayGain lock,
+// which also guards the pending sink, so the audiobin is relinked by one
+// thread at a time.
+static void
+bp_output_swap_sink (BansheePlayer *player)
+{
+    GstElement *sink;
+
+    g_mutex_lock (player->replaygain_mutex);
+    player->output_pad_block_id = 0;
+
+    // Built by bp_set_output_device, so the switch itself can not fail
+    sink = player->output_pending_sink;
+    player->output_pending_sink = NULL;
+    if (sink == NULL) {
+        g_mutex_unlock (player->replaygain_mutex);
+        return;
+    }
+
+    gst_element_unlink (player->output_tee, player->audiosink);
+    gst_element_set_state (player->audiosink, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (player->audiobin), player->audiosink);
+
+    _bp_telemetry_sink_changed (player);
+
+    if (g_object_class_find_property (G_OBJECT_GET_CLASS (sink), "profile")) {
+        g_object_set (G_OBJECT (sink), "profile", 1, NULL);
+    }
+
+    player->audiosink = sink;
+    player->audiosink_has_volume = player->output_pending_has_volume;
+    gst_bin_add (GST_BIN (player->audiobin), sink);
+    gst_object_unref (sink);
+    bp_output_apply_latency_mode (player);
+    _bp_latency_watch_sink (player, sink);
+    _bp_meter_watch_sink (player, sink);
+
+    // Sticky events (stream-start, caps, segment) are resent to the new
+    // sink with the next buffer
+    gst_element_link (player->output_tee, sink);
+    gst_element_sync_state_with_parent (sink);
+
+    // The new sink starts at its own default volume, and the volume may
+    // have to move between the sink and our volume element
+    _bp_output_apply_volume (player);
+
+    g_mutex_unlock (player->replaygain_mutex);
+
+    bp_debug2 ("Switched output to %s", player->output_device != NULL ? player->output_device : "(default)");
+}
+
+static GstPadProbeReturn
+bp_output_pad_block_cb (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    BansheePlayer *player = (BansheePlayer *)user_data;
+
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), GST_PAD_PROBE_REMOVE);
+
+    bp_output_swap_sink (player);
+    return GST_PAD_PROBE_REMOVE;
+}
+
+// ---------------------------------------------------------------------------
+// Internal Functions
+// ---------------------------------------------------------------------------
+
+// Builds the primary audio sink, straight from the output manager's cached
+// device list when it has one, and sets audiosink_has_volume
+GstElement *
+_bp_output_create_sink (BansheePlayer *player)
+{
+    GstElement *audiosink = NULL;
+
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), NULL);
+
+    if (player->audiosink_factory != NULL &&
+        (audiosink = gst_element_factory_make (player->audiosink_factory, "audiosink")) != NULL) {
+        player->audiosink_has_volume = g_object_class_find_property (G_OBJECT_GET_CLASS (audiosink), "volume") != NULL;
+    }
+
+    // Only a device the user chose is pinned; one that went away since
+    // plays on whatever the system default is
+    if (audiosink == NULL && player->output_device != NULL) {
+        audiosink = bom_create_sink (player->output_device, &player->audiosink_has_volume);
+    }
+
+    if (audiosink == NULL) {
+        audiosink = bom_create_sink (NULL, &player->audiosink_has_volume);
+    }
+
+    if (audiosink == NULL) {
+        audiosink = bp_output_autodetect_sink (player);
+    }
+
+    if (audiosink == NULL) {
+        return NULL;
+    }
+
+    if (strcmp (G_OBJECT_TYPE_NAME (audiosink), "GstDirectSoundSink") == 0) {
+        g_object_set (G_OBJECT (audiosink), "volume", 1.0, NULL);
+    }
+
+    // Set the profile to "music and movies" (gst-plugins-good 0.10.3)
+    if (g_object_class_find_property (G_OBJECT_GET_CLASS (audiosink), "profile")) {
+        g_object_set (G_OBJECT (audiosink), "profile", 1, NULL);
+    }
+
+    bp_debug3 ("Audiosink %s has volume: %s", GST_OBJECT_NAME (gst_element_get_factory (audiosink)),
+        player->audiosink_has_volume ? "YES" : "NO");
+
+    return audiosink;
+}
+
+// The audio sink may be a bin (autoaudiosink) whose real sink only exists
+// while it is out of NULL; returns the GstAudioBaseSink inside it, if any
+GstElement *
+_bp_output_find_audio_base_sink (GstElement *sink)
+{
+    GstElement *base_sink = NULL;
+
+    if (sink == NULL) {
+        return NULL;
+    }
+
+    if (GST_IS_AUDIO_BASE_SINK (sink)) {
+        return sink;
+    }
+
+    if (GST_IS_BIN (sink)) {
+        GstIterator *iter = gst_bin_iterate_recurse (GST_BIN (sink));
+        BANSHEE_GST_ITERATOR_ITERATE (iter, GstElement *, element, TRUE, {
+            if (base_sink == NULL && GST_IS_AUDIO_BASE_SINK (element)) {
+                base_sink = element;
+            }
+        });
+    }
+
+    return base_sink;
+}
+
+// Applies player->current_volume where it belongs: to the sink when it
+// controls the device volume itself, with our volume element left at
+// unity, otherwise to our volume element. playbin only learns about the
+// sink it was constructed with and keeps its own copy of the volume, so
+// the sink is set directly and playbin is kept in step. There is no mute
+// state of its own; muting is a volume of 0.
+void
+_bp_output_apply_volume (BansheePlayer *player)
+{
+    GstElement *volume_element = NULL;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    if (player->audiosink_has_volume) {
+        volume_element = bp_output_find_volume_element (player->audiosink);
+    }
+
+    if (volume_element != NULL) {
+        g_object_set (G_OBJECT (player->volume), "volume", 1.0, NULL);
+        g_object_set (G_OBJECT (volume_element), "volume", player->current_volume, NULL);
+        if (player->playbin != NULL) {
+            g_object_set (G_OBJECT (player->playbin), "volume", player->current_volume, NULL);
+        }
+    } else if (player->volume != NULL) {
+        g_object_set (G_OBJECT (player->volume), "volume", player->current_volume, NULL);
+    }
+
+    _bp_multi_output_volume_changed (player);
+}
+
+// The volume the sink or our volume element is actually set to, -1 if
+// neither exists
+gdouble
+_bp_output_get_applied_volume (BansheePlayer *player)
+{
+    GstElement *volume_element = NULL;
+    gdouble volume = -1;
+
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), -1);
+
+    if (player->audiosink_has_volume) {
+        volume_element = bp_output_find_volume_element (player->audiosink);
+    }
+
+    if (volume_element == NULL) {
+        volume_element = player->volume;
+    }
+
+    if (volume_element != NULL) {
+        g_object_get (G_OBJECT (volume_element), "volume", &volume, NULL);
+    }
+
+    return volume;
+}
+
+void
+_bp_output_pipeline_setup (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    bp_output_apply_latency_mode (player);
+}
+
+// ---------------------------------------------------------------------------
+// Public Functions
+// ---------------------------------------------------------------------------
+
+// Forces the primary sink to come from a factory, e.g. fakesink for
+// headless runs; takes effect with the next pipeline
+P_INVOKE void
+bp_set_audiosink_factory (BansheePlayer *player, const gchar *factory)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    g_free (player->audiosink_factory);
+    player->audiosink_factory = g_strdup (factory);
+}
+
+P_INVOKE void
+bp_set_output_latency_mode (BansheePlayer *player, BpOutputLatencyMode mode)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+    g_return_if_fail (mode >= BP_OUTPUT_LATENCY_STANDARD && mode <= BP_OUTPUT_LATENCY_ULTRA_LOW);
+
+    if (player->output_latency_mode == mode) {
+        return;
+    }
+
+    player->output_latency_mode = mode;
+    bp_output_apply_latency_mode (player);
+}
+
+P_INVOKE BpOutputLatencyMode
+bp_get_output_latency_mode (BansheePlayer *player)
+{
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), BP_OUTPUT_LATENCY_STANDARD);
+    return player->output_latency_mode;
+}
+
+// Moves playback to another output device, NULL for the default one. While
+// paused the sink holds on to its preroll buffer, so the switch happens as
+// soon as playback resumes. Returns FALSE, keeping the current output, if
+// no sink can be built for the device.
+P_INVOKE gboolean
+bp_set_output_device (BansheePlayer *player, const gchar *device_id)
+{
+    GstElement *queue, *sink;
+    GstPad *pad;
+    gboolean has_volume = FALSE;
+
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), FALSE);
+
+    if (g_strcmp0 (player->output_device, device_id) == 0) {
+        return TRUE;
+    }
+
+    // The sink is built up front so the caller learns about a device that
+    // is not available while the current sink is still playing
+    if ((sink = bom_create_sink (device_id, &has_volume)) == NULL) {
+        bp_debug2 ("Output device %s is not available, keeping the current sink",
+            device_id != NULL ? device_id : "(default)");
+        return FALSE;
+    }
+    gst_object_ref_sink (sink);
+
+    g_mutex_lock (player->replaygain_mutex);
+
+    g_free (player->output_device);
+    player->output_device = g_strdup (device_id);
+
+    if (player->playbin == NULL) {
+        // The pipeline will be built with this device
+        g_mutex_unlock (player->replaygain_mutex);
+        gst_object_unref (sink);
+        return TRUE;
+    }
+
+    if (player->output_pending_sink != NULL) {
+        gst_object_unref (player->output_pending_sink);
+    }
+    player->output_pending_sink = sink;
+    player->output_pending_has_volume = has_volume;
+
+    // A switch already waiting for the pad block picks up the new sink
+    if (player->output_pad_block_id != 0) {
+        g_mutex_unlock (player->replaygain_mutex);
+        return TRUE;
+    }
+
+    queue = gst_bin_get_by_name (GST_BIN (player->audiobin), "audiosinkqueue");
+    pad = queue != NULL ? gst_element_get_static_pad (queue, "src") : NULL;
+
+    // The probe fires on the streaming thread, which waits for the lock
+    // until the block id is recorded
+    if (pad != NULL && gst_pad_is_active (pad) && !gst_pad_is_blocked (pad)) {
+        player->output_pad_block_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
+            bp_output_pad_block_cb, player, NULL);
+        g_mutex_unlock (player->replaygain_mutex);
+    } else {
+        g_mutex_unlock (player->replaygain_mutex);
+        bp_output_swap_sink (player);
+    }
+
+    if (pad != NULL) {
+        gst_object_unref (pad);
+    }
+
+    if (queue != NULL) {
+        gst_object_unref (queue);
+    }
+
+    return TRUE;
+}
+
+// Returns the size of the ring buffer the device accepted, in microseconds,
+// which is how long a volume or equalizer change takes to be heard; -1
+// while no ring buffer is acquired
+P_INVOKE gint64
+bp_get_output_latency (BansheePlayer *player)
+{
+    GstAudioRingBuffer *ringbuffer;
+    GstElement *sink;
+    gint64 latency = -1;
+
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), -1);
+
+    if ((sink = _bp_output_find_audio_base_sink (player->audiosink)) == NULL) {
+        return -1;
+    }
+
+    GST_OBJECT_LOCK (sink);
+    ringbuffer = GST_AUDIO_BASE_SINK (sink)->ringbuffer;
+    if (ringbuffer != NULL && gst_audio_ring_buffer_is_acquired (ringbuffer)) {
+        GstAudioRingBufferSpec *spec = &ringbuffer->spec;
+        gint rate = GST_AUDIO_INFO_RATE (&spec->info);
+        gint bpf = GST_AUDIO_INFO_BPF (&spec->info);
+        if (rate > 0 && bpf > 0) {
+            latency = gst_util_uint64_scale_int ((guint64)spec->segtotal * spec->segsize / bpf,
+                GST_SECOND / GST_USECOND, rate);
+        }
+    }
+    GST_OBJECT_UNLOCK (sink);
+
+    return latency;
+}
@@ -35,6 +35,14 @@
 #include "banshee-player-equalizer.h"
 #include "banshee-player-missing-elements.h"
 #include "banshee-player-replaygain.h"
+#include "banshee-player-subtitle.h"
+#include "banshee-player-buffering.h"
+#include "banshee-player-cache.h"
+#include "banshee-player-latency.h"
+#include "banshee-player-telemetry.h"
+#include "banshee-player-output.h"
+#include "banshee-player-multi-output.h"
+#include "banshee-player-meter.h"
 #include "banshee-player-vis.h"
 
 // ---------------------------------------------------------------------------
@@ -109,6 +117,7 @@ bp_next_track_starting (BansheePlayer *player)
         return FALSE;
     }
     player->in_gapless_transition = FALSE;
+    _bp_subtitle_next_track_starting (player);
 
     if (player->next_track_starting_cb != NULL) {
         bp_debug ("[gapless] Triggering track-change signal");
@@ -127,6 +136,8 @@ bp_pipeline_bus_callback (GstBus *bus, GstMessage *message, gpointer userdata)
     
     switch (GST_MESSAGE_TYPE (message)) {
         case GST_MESSAGE_EOS: {
+            bp_trace (BANSHEE_TRACE_EVENT_EOS, 0, 0);
+            _bp_cache_handle_eos (player);
             if (player->eos_cb != NULL) {
                 player->eos_cb (player);
             }
@@ -139,41 +150,20 @@ bp_pipeline_bus_callback (GstBus *bus, GstMessage *message, gpointer userdata)
             
             _bp_missing_elements_handle_state_changed (player, old, new);
             
-            if (player->state_changed_cb != NULL && GST_MESSAGE_SRC (message) == GST_OBJECT (player->playbin)) {
+            if (GST_MESSAGE_SRC (message) != GST_OBJECT (player->playbin)) {
+                break;
+            }
+
+            bp_trace (BANSHEE_TRACE_EVENT_STATE_CHANGED, old, new);
+            if (player->state_changed_cb != NULL) {
                 player->state_changed_cb (player, old, new, pending);
             }
             break;
         }
         
-        case GST_MESSAGE_BUFFERING: {
-            const GstStructure *buffering_struct;
-            gint buffering_progress = 0;
-            
-            buffering_struct = gst_message_get_structure (message);
-            if (!gst_structure_get_int (buffering_struct, "buffer-percent", &buffering_progress)) {
-                g_warning ("Could not get completion percentage from BUFFERING message");
-                break;
-            }
-            
-            if (buffering_progress >= 100) {
-                player->buffering = FALSE;
-                if (player->target_state == GST_STATE_PLAYING) {
-                    gst_element_set_state (player->playbin, GST_STATE_PLAYING);
-                }
-            } else if (!player->buffering && player->target_state == GST_STATE_PLAYING) {
-                GstState current_state;
-                gst_element_get_state (player->playbin, &current_state, NULL, 0);
-                if (current_state == GST_STATE_PLAYING) {
-                    gst_element_set_state (player->playbin, GST_STATE_PAUSED);
-                }
-                player->buffering = TRUE;
-            } 
-
-            if (player->buffering_cb != NULL) {
-                player->buffering_cb (player, buffering_progress);
-            }
+        case GST_MESSAGE_BUFFERING:
+            _bp_buffering_handle_message (player, message);
             break;
-        }
         
         case GST_MESSAGE_TAG: {
             GstTagList *tags;
@@ -195,14 +185,22 @@ bp_pipeline_bus_callback (GstBus *bus, GstMessage *message, gpointer userdata)
             GError *error;
             gchar *debug;
             
+            gst_message_parse_error (message, &error, &debug);
+
+            // Leave the events that led up to the error in the log
+            bp_trace (BANSHEE_TRACE_EVENT_ERROR, error->domain, error->code);
+            if (banshee_tracing) {
+                banshee_trace_dump ();
+            }
+
             _bp_pipeline_destroy (player);
             
             if (player->error_cb != NULL) {
-                gst_message_parse_error (message, &error, &debug);
                 player->error_cb (player, error->domain, error->code, error->message, debug);
-                g_error_free (error);
-                g_free (debug);
             }
+
+            g_error_free (error);
+            g_free (debug);
             
             break;
         } 
@@ -218,6 +216,24 @@ bp_pipeline_bus_callback (GstBus *bus, GstMessage *message, gpointer userdata)
             break;
         }
 
+        case GST_MESSAGE_ASYNC_DONE:
+            _bp_latency_mark (player, BP_OPEN_MILESTONE_ASYNC_DONE);
+            _bp_multi_output_align (player);
+            break;
+
+        case GST_MESSAGE_LATENCY:
+            gst_bin_recalculate_latency (GST_BIN (player->playbin));
+            break;
+
+        case GST_MESSAGE_CLOCK_LOST:
+            // The sink that provided the clock went away with an output
+            // device switch; passing through PAUSED selects a new one
+            if (player->target_state == GST_STATE_PLAYING) {
+                gst_element_set_state (player->playbin, GST_STATE_PAUSED);
+                gst_element_set_state (player->playbin, GST_STATE_PLAYING);
+            }
+            break;
+
         case GST_MESSAGE_APPLICATION: {
             const gchar * name;
             const GstStructure * s = gst_message_get_structure (message);
@@ -262,6 +278,7 @@ static void bp_volume_changed_callback (GstElement *playbin, GParamSpec *spec, B
     g_object_get (G_OBJECT (playbin), "volume", &volume, NULL);
 
     player->current_volume = volume;
+    _bp_multi_output_volume_changed (player);
 
     if (player->volume_changed_cb != NULL) {
         player->volume_changed_cb (player, volume);
@@ -298,43 +315,9 @@ _bp_pipeline_construct (BansheePlayer *player)
     g_signal_connect (player->playbin, "audio-changed", G_CALLBACK (playbin_stream_changed_cb), player);
     g_signal_connect (player->playbin, "text-changed", G_CALLBACK (playbin_stream_changed_cb), player);
 
-    audiosink = gst_element_factory_make ("directsoundsink", "audiosink");
-    if (audiosink != NULL) {
-        g_object_set (G_OBJECT (audiosink), "volume", 1.0, NULL);
-    } else {
-        audiosink = gst_element_factory_make ("autoaudiosink", "audiosink");
-        if (audiosink == NULL) {
-            audiosink = gst_element_factory_make ("alsasink", "audiosink");
-        }
-    }
-    
+    audiosink = _bp_output_create_sink (player);
     g_return_val_if_fail (audiosink != NULL, FALSE);
 
-    // Set the profile to "music and movies" (gst-plugins-good 0.10.3)
-    if (g_object_class_find_property (G_OBJECT_GET_CLASS (audiosink), "profile")) {
-        g_object_set (G_OBJECT (audiosink), "profile", 1, NULL);
-    }
-
-    /* Set the audio sink to READY so it can autodetect the right sink element
-     * if needed, as this allows us to correctly determine whether it has a
-     * volume */
-    gst_element_set_state (audiosink, GST_STATE_READY);
-
-    // See if the audiosink has a 'volume' property.  If it does, we assume it saves and restores
-    // its volume information - and that we shouldn't
-    player->audiosink_has_volume = FALSE;
-    if (!GST_IS_BIN (audiosink)) {
-        player->audiosink_has_volume = g_object_class_find_property (G_OBJECT_GET_CLASS (audiosink), "volume") != NULL;
-    } else {
-        GstIterator *elem_iter = gst_bin_iterate_recurse (GST_BIN (audiosink));
-        BANSHEE_GST_ITERATOR_ITERATE (elem_iter, GstElement *, element, TRUE, {
-            player->audiosink_has_volume |= g_object_class_find_property (G_OBJECT_GET_CLASS (element), "volume") != NULL;
-        });
-    }
-    bp_debug ("Audiosink has volume: %s",
-        player->audiosink_has_volume ? "YES" : "NO");
-        
-    
     // Create a custom audio sink bin that will hold the real primary sink
     player->audiobin = gst_bin_new ("audiobin");
     g_return_val_if_fail (player->audiobin != NULL, FALSE);
@@ -357,6 +340,16 @@ _bp_pipeline_construct (BansheePlayer *player)
     audiosinkqueue = gst_element_factory_make ("queue", "audiosinkqueue");
     g_return_val_if_fail (audiosinkqueue != NULL, FALSE);
 
+    // Extra outputs branch off right in front of the primary sink, so they
+    // get the equalizer, volume and ReplayGain too
+    player->output_tee = gst_element_factory_make ("tee", "outputtee");
+    g_return_val_if_fail (player->output_tee != NULL, FALSE);
+    g_object_set (G_OBJECT (player->output_tee), "allow-not-linked", TRUE, NULL);
+
+    // The CDDA read-ahead cache is linked in front of the tee for discs
+    _bp_cdda_readahead_new (player);
+    g_return_val_if_fail (player->cdda_readahead != NULL, FALSE);
+
     player->equalizer = _bp_equalizer_new (player);
     player->preamp = NULL;
     if (player->equalizer != NULL) {
@@ -366,13 +359,14 @@ _bp_pipeline_construct (BansheePlayer *player)
     }
     
     // Add elements to custom audio sink
-    gst_bin_add_many (GST_BIN (player->audiobin), player->audiotee, player->volume, audiosinkqueue, audiosink, NULL);
+    gst_bin_add_many (GST_BIN (player->audiobin), player->cdda_readahead, player->audiotee, player->volume,
+        audiosinkqueue, player->output_tee, audiosink, NULL);
     
     if (player->equalizer != NULL) {
         gst_bin_add_many (GST_BIN (player->audiobin), eq_audioconvert, eq_audioconvert2, player->equalizer, player->preamp, NULL);
     }
    
-    // Ghost pad the audio bin so audio is passed from the bin into the tee
+    // Ghost pad the audio bin so audio is passed from the bin to the tee
     teepad = gst_element_get_static_pad (player->audiotee, "sink");
     gst_element_add_pad (player->audiobin, gst_ghost_pad_new ("sink", teepad));
     gst_object_unref (teepad);
@@ -381,13 +375,15 @@ _bp_pipeline_construct (BansheePlayer *player)
     if (player->equalizer != NULL) {
         // link in equalizer, preamp and audioconvert.
         gst_element_link_many (audiosinkqueue, eq_audioconvert, player->preamp, 
-            player->equalizer, eq_audioconvert2, player->volume, audiosink, NULL);
+            player->equalizer, eq_audioconvert2, player->volume, player->output_tee, NULL);
     } else {
         // link the queue with the real audio sink
-        gst_element_link_many (audiosinkqueue, player->volume, audiosink, NULL);
+        gst_element_link_many (audiosinkqueue, player->volume, player->output_tee, NULL);
     }
+    gst_element_link (player->output_tee, audiosink);
     player->before_rgvolume = player->volume;
-    player->after_rgvolume = player->audiosink = audiosink;
+    player->after_rgvolume = player->output_tee;
+    player->audiosink = audiosink;
     player->rgvolume_in_pipeline = FALSE;
     _bp_replaygain_pipeline_rebuild (player);
 
@@ -410,6 +406,12 @@ _bp_pipeline_construct (BansheePlayer *player)
     // Now allow specialized pipeline setups
     _bp_cdda_pipeline_setup (player);
     _bp_dvd_pipeline_setup (player);
+    _bp_cache_pipeline_setup (player);
+    _bp_latency_pipeline_setup (player);
+    _bp_telemetry_pipeline_setup (player);
+    _bp_meter_pipeline_setup (player);
+    _bp_output_pipeline_setup (player);
+    _bp_multi_output_pipeline_setup (player);
     _bp_video_pipeline_setup (player, bus);
     _bp_dvd_find_navigation (player);
 
@@ -438,6 +440,13 @@ _bp_pipeline_destroy (BansheePlayer *player)
     }
     
     _bp_vis_pipeline_destroy (player);
+    _bp_multi_output_pipeline_destroy (player);
     
     player->playbin = NULL;
+    player->cdda_readahead = NULL;
+    player->output_pad_block_id = 0;
+    if (player->output_pending_sink != NULL) {
+        gst_object_unref (player->output_pending_sink);
+        player->output_pending_sink = NULL;
+    }
 }
@@ -72,19 +72,21 @@
             GST_VERSION_MICRO >= (micro)))
 
 #ifdef WIN32
-#define bp_debug(x) banshee_log_debug ("player", x)
-#define bp_debug2(x, a2) banshee_log_debug ("player", x, a2)
-#define bp_debug3(x, a2, a3) banshee_log_debug ("player", x, a2, a3)
-#define bp_debug4(x, a2, a3, a4) banshee_log_debug ("player", x, a2, a3, a4)
-#define bp_debug5(x, a2, a3, a4, a5) banshee_log_debug ("player", x, a2, a3, a4, a5)
+#define bp_debug(x) G_STMT_START { if (BANSHEE_DEBUG_ENABLED) banshee_log_debug ("player", x); } G_STMT_END
+#define bp_debug2(x, a2) G_STMT_START { if (BANSHEE_DEBUG_ENABLED) banshee_log_debug ("player", x, a2); } G_STMT_END
+#define bp_debug3(x, a2, a3) G_STMT_START { if (BANSHEE_DEBUG_ENABLED) banshee_log_debug ("player", x, a2, a3); } G_STMT_END
+#define bp_debug4(x, a2, a3, a4) G_STMT_START { if (BANSHEE_DEBUG_ENABLED) banshee_log_debug ("player", x, a2, a3, a4); } G_STMT_END
+#define bp_debug5(x, a2, a3, a4, a5) G_STMT_START { if (BANSHEE_DEBUG_ENABLED) banshee_log_debug ("player", x, a2, a3, a4, a5); } G_STMT_END
 #else
-#define bp_debug(x...) banshee_log_debug ("player", x)
-#define bp_debug2(x...) banshee_log_debug ("player", x)
-#define bp_debug3(x...) banshee_log_debug ("player", x)
-#define bp_debug4(x...) banshee_log_debug ("player", x)
-#define bp_debug5(x...) banshee_log_debug ("player", x)
+#define bp_debug(x...) G_STMT_START { if (BANSHEE_DEBUG_ENABLED) banshee_log_debug ("player", x); } G_STMT_END
+#define bp_debug2(x...) bp_debug (x)
+#define bp_debug3(x...) bp_debug (x)
+#define bp_debug4(x...) bp_debug (x)
+#define bp_debug5(x...) bp_debug (x)
 #endif
 
+#define bp_trace(event, a, b) banshee_trace (BANSHEE_TRACE_PLAYER, event, a, b)
+
 typedef struct BansheePlayer BansheePlayer;
 
 typedef void (* BansheePlayerEosCallback)          (BansheePlayer *player);
@@ -102,6 +104,33 @@ typedef GstElement * (* BansheePlayerVideoPipelineSetupCallback) (BansheePlayer
 typedef void (* BansheePlayerVideoPrepareWindowCallback) (BansheePlayer *player);
 typedef void (* BansheePlayerVolumeChangedCallback) (BansheePlayer *player, gdouble new_volume);
 typedef void (* BansheePlayerVideoGeometryNotifyCallback) (BansheePlayer *player, gint width, gint height, gint fps_n, gint fps_d, gint par_n, gint par_d);
+typedef void (* BansheePlayerStreamInfoCallback) (BansheePlayer *player, gint n_audio, gint n_video, gint n_text,
+                                                  gint width, gint height, gint fps_n, gint fps_d, gint par_n, gint par_d);
+
+typedef enum {
+    BP_OPEN_MILESTONE_URI_SET,
+    BP_OPEN_MILESTONE_SOURCE_SETUP,
+    BP_OPEN_MILESTONE_FIRST_DECODED,
+    BP_OPEN_MILESTONE_ASYNC_DONE,
+    BP_OPEN_MILESTONE_FIRST_AUDIBLE,
+    BP_OPEN_MILESTONE_COUNT
+} BpOpenMilestone;
+
+typedef enum {
+    BP_TELEMETRY_QUEUE_READAHEAD,
+    BP_TELEMETRY_QUEUE_SINK,
+    BP_TELEMETRY_QUEUE_VIS,
+    BP_TELEMETRY_QUEUE_COUNT
+} BpTelemetryQueue;
+
+typedef struct BpMeter BpMeter;
+typedef struct BpCacheDownload BpCacheDownload;
+
+typedef enum {
+    BP_OUTPUT_LATENCY_STANDARD,
+    BP_OUTPUT_LATENCY_LOW,
+    BP_OUTPUT_LATENCY_ULTRA_LOW
+} BpOutputLatencyMode;
 
 typedef enum {
     BP_VIDEO_DISPLAY_CONTEXT_UNSUPPORTED = 0,
@@ -124,6 +153,7 @@ struct BansheePlayer {
     BansheePlayerVideoPrepareWindowCallback video_prepare_window_cb;
     BansheePlayerVolumeChangedCallback volume_changed_cb;
     BansheePlayerVideoGeometryNotifyCallback video_geometry_notify_cb;
+    BansheePlayerStreamInfoCallback stream_info_cb;
 
     // Pipeline Elements
     GstElement *playbin;
@@ -134,6 +164,8 @@ struct BansheePlayer {
     GstElement *volume;
     GstElement *rgvolume;
     GstElement *audiosink;
+    GstElement *output_tee;    // in front of audiosink, feeds output_branches
+    GstElement *cdda_readahead;
 
     GstElement *before_rgvolume;
     GstElement *after_rgvolume;
@@ -151,6 +183,59 @@ struct BansheePlayer {
     gchar *dvd_device;
     gboolean in_gapless_transition;
     gboolean audiosink_has_volume;
+
+    // Network Buffering State
+    gint buffering_percent;
+    gint buffering_pause_below;
+    gint buffering_download_rate;
+    gint buffering_bitrate;
+    GstClockTime buffering_duration;
+    gint buffering_size;
+    guint buffering_rebuffers;
+    GstClockTime buffering_stable_since;
+
+    // Download Cache State
+    gchar *cache_dir;
+    guint64 cache_max_size;
+    BpCacheDownload *cache_download;   // remote stream being written to the cache
+
+    // Open Latency State; milestones are in microseconds after open_started,
+    // all zero (reached) until the first bp_open so nothing is measured
+    GstClockTime open_started;
+    gint64 open_milestones[BP_OPEN_MILESTONE_COUNT];
+
+    // Queue Telemetry State
+    GstElement *telemetry_queues[BP_TELEMETRY_QUEUE_COUNT];
+    volatile gint telemetry_overruns[BP_TELEMETRY_QUEUE_COUNT];
+    volatile gint telemetry_underruns[BP_TELEMETRY_QUEUE_COUNT];
+    GstElement *telemetry_audio_sink;
+    GstClockTimeDiff telemetry_clock_offset;
+    gboolean telemetry_clock_calibrated;
+
+    // Audio Output State; output_device is NULL for the default device
+    BpOutputLatencyMode output_latency_mode;
+    gchar *output_device;
+    gchar *audiosink_factory;  // overrides the device, see bp_set_audiosink_factory
+    gulong output_pad_block_id;
+    GstElement *output_pending_sink;    // built for output_device, waiting for the pad block
+    gboolean output_pending_has_volume;
+    GSList *output_branches;   // extra outputs on the output_tee, see bp_add_output
+    gint output_branch_last_id;
+
+    // Level Metering State
+    BpMeter *meter;
+
+    // CDDA Read-ahead State, the volatile fields are atomic
+    guint cdda_readahead_seconds;
+    gboolean cdda_readahead_linked;
+    volatile gint cdda_readahead_active;
+    volatile gint cdda_readahead_primed;
+    volatile gint cdda_readahead_eos;
+    volatile gint cdda_readahead_throttled;
+    volatile gint cdda_rebuffering;
+    volatile gint cdda_rebuffer_percent;
+    GstClockTime cdda_skip_target;     // seek served from the queue, under its object lock
+    GstClockTime cdda_skip_base;       // running time playback resumes at
     
     // Video State
     BpVideoDisplayContextType video_display_context_type;
@@ -170,6 +255,27 @@ struct BansheePlayer {
     gint fps_d;
     gint par_n;
     gint par_d;
+
+    // Stream info, as last reported to the callbacks
+    GstPad *video_pad;
+    gulong video_caps_notify_id;
+    gboolean stream_info_valid;
+    gint n_audio;
+    gint n_video;
+    gint n_text;
+
+    // Subtitle State
+    GThreadPool *subtitle_pool;
+    GMutex *subtitle_mutex;
+    guint subtitle_lookup_serial;
+    gchar *subtitle_found_uri;
+    gboolean subtitle_found_next;
+    guint subtitle_idle_id;
+    GstElement *subtitle_overlay;
+    GstElement *subtitle_source;
+    gchar *subtitle_uri;
+    gchar *subtitle_next_uri;
+    gboolean subtitle_next_pending;
        
     // Visualization State
     GstElement *vis_resampler;
@@ -201,9 +307,28 @@ struct BansheePlayer {
     gint history_size;
     gulong rg_pad_block_id;
 
-    //dvd navigation
+    //dvd navigation, navigation is guarded by navigation_mutex
+    GMutex *navigation_mutex;
     GstNavigation *navigation;
     gboolean is_menu;
 };
 
+// Entry points for the managed side that are also called from C (banshee-bench)
+P_INVOKE BansheePlayer *bp_new ();
+P_INVOKE void     bp_destroy (BansheePlayer *player);
+P_INVOKE gboolean bp_initialize_pipeline (BansheePlayer *player);
+P_INVOKE void     bp_set_audiosink_factory (BansheePlayer *player, const gchar *factory);
+P_INVOKE gboolean bp_open (BansheePlayer *player, const gchar *uri, gboolean maybe_video);
+P_INVOKE void     bp_stop (BansheePlayer *player, gboolean nullstate);
+P_INVOKE void     bp_play (BansheePlayer *player);
+P_INVOKE gboolean bp_set_next_track (BansheePlayer *player, const gchar *uri, gboolean maybe_video);
+P_INVOKE gboolean bp_set_position (BansheePlayer *player, guint64 time_ms, gboolean accurate_seek);
+P_INVOKE guint64  bp_get_duration (BansheePlayer *player);
+P_INVOKE void     bp_set_volume (BansheePlayer *player, gdouble volume);
+P_INVOKE gboolean bp_set_output_device (BansheePlayer *player, const gchar *device_id);
+P_INVOKE gboolean bp_get_pipeline_elements (BansheePlayer *player, GstElement **playbin,
+                                            GstElement **audiobin, GstElement **audiotee);
+P_INVOKE void     bp_set_about_to_finish_callback (BansheePlayer *player, BansheePlayerAboutToFinishCallback cb);
+P_INVOKE void     bp_set_vis_data_callback (BansheePlayer *player, BansheePlayerVisDataCallback cb);
+
 #endif /* _BANSHEE_PLAYER_PRIVATE_H */
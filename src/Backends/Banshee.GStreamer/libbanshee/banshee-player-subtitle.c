@@ -0,0 +1,670 @@
+//
+// banshee-player-subtitle.c
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <glib/gstdio.h>
+
+#include "banshee-player-subtitle.h"
+
+// Directory listings are cached so that consecutive videos from the same
+// folder (a TV series, ...) only cost one stat of the directory; the cache
+// is dropped as a whole once it holds this many directories
+#define BP_SUBTITLE_DIR_CACHE_SIZE 64
+
+typedef struct {
+    time_t mtime;
+    GPtrArray *names;
+} BpSubtitleDir;
+
+typedef struct {
+    gchar *uri;
+    guint serial;
+    gboolean next_track;
+} BpSubtitleLookup;
+
+static const gchar *subtitle_extensions[] = { ".srt", ".sub", ".smi", ".txt", ".mpl", ".dks", ".qtx" };
+
+G_LOCK_DEFINE_STATIC (subtitle_dir_cache);
+static GHashTable *subtitle_dir_cache = NULL;
+
+// ---------------------------------------------------------------------------
+// Private Functions
+// ---------------------------------------------------------------------------
+
+static void
+bp_subtitle_dir_free (BpSubtitleDir *dir)
+{
+    g_ptr_array_foreach (dir->names, (GFunc)g_free, NULL);
+    g_ptr_array_free (dir->names, TRUE);
+    g_free (dir);
+}
+
+static gint
+bp_subtitle_extension_index (const gchar *name)
+{
+    const gchar *dot = strrchr (name, '.');
+    gint i;
+
+    if (dot == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS (subtitle_extensions); i++) {
+        if (g_ascii_strcasecmp (dot, subtitle_extensions[i]) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static GPtrArray *
+bp_subtitle_dir_copy_names (BpSubtitleDir *dir)
+{
+    GPtrArray *names = g_ptr_array_new ();
+    guint i;
+
+    for (i = 0; i < dir->names->len; i++) {
+        g_ptr_array_add (names, g_strdup (g_ptr_array_index (dir->names, i)));
+    }
+
+    return names;
+}
+
+// Returns a copy of the subtitle file names found in dirname, reading the
+// directory only if it was modified since the last time we listed it
+static GPtrArray *
+bp_subtitle_list_dir (const gchar *dirname)
+{
+    struct stat st;
+    BpSubtitleDir *dir;
+    GPtrArray *names;
+    GDir *gdir;
+    const gchar *name;
+
+    if (g_stat (dirname, &st) != 0) {
+        return NULL;
+    }
+
+    G_LOCK (subtitle_dir_cache);
+    if (subtitle_dir_cache == NULL) {
+        subtitle_dir_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+            g_free, (GDestroyNotify)bp_subtitle_dir_free);
+    }
+
+    dir = g_hash_table_lookup (subtitle_dir_cache, dirname);
+    if (dir != NULL && dir->mtime == st.st_mtime) {
+        names = bp_subtitle_dir_copy_names (dir);
+        G_UNLOCK (subtitle_dir_cache);
+        return names;
+    }
+    G_UNLOCK (subtitle_dir_cache);
+
+    gdir = g_dir_open (dirname, 0, NULL);
+    if (gdir == NULL) {
+        return NULL;
+    }
+
+    dir = g_new0 (BpSubtitleDir, 1);
+    dir->mtime = st.st_mtime;
+    dir->names = g_ptr_array_new ();
+
+    while ((name = g_dir_read_name (gdir)) != NULL) {
+        if (bp_subtitle_extension_index (name) >= 0) {
+            g_ptr_array_add (dir->names, g_strdup (name));
+        }
+    }
+    g_dir_close (gdir);
+
+    G_LOCK (subtitle_dir_cache);
+    if (g_hash_table_size (subtitle_dir_cache) >= BP_SUBTITLE_DIR_CACHE_SIZE) {
+        g_hash_table_remove_all (subtitle_dir_cache);
+    }
+    names = bp_subtitle_dir_copy_names (dir);
+    g_hash_table_replace (subtitle_dir_cache, g_strdup (dirname), dir);
+    G_UNLOCK (subtitle_dir_cache);
+
+    return names;
+}
+
+// Ranks a subtitle file name against the video's name without extension:
+// 0 for movie.srt, 1 for movie.<lang>.srt in one of the user's languages,
+// 2 for any other movie.<tag>.srt, and -1 if it does not belong to the video
+static gint
+bp_subtitle_rank (const gchar *name, const gchar *stem)
+{
+    const gchar * const *languages;
+    const gchar *ext;
+    gsize stem_len = strlen (stem);
+    gchar *tag;
+    gint i, rank = 2;
+
+    if (strncmp (name, stem, stem_len) != 0 || name[stem_len] != '.') {
+        return -1;
+    }
+
+    ext = strrchr (name, '.');
+    if (ext == name + stem_len) {
+        return 0;
+    }
+
+    tag = g_strndup (name + stem_len + 1, ext - (name + stem_len + 1));
+    if (strchr (tag, '.') != NULL) {
+        g_free (tag);
+        return -1;
+    }
+
+    languages = g_get_language_names ();
+    for (i = 0; languages[i] != NULL; i++) {
+        if (g_ascii_strcasecmp (tag, languages[i]) == 0) {
+            rank = 1;
+            break;
+        }
+    }
+
+    g_free (tag);
+    return rank;
+}
+
+static gchar *
+bp_subtitle_find (const gchar *uri)
+{
+    gchar *filename, *dirname, *stem, *dot, *suburi = NULL;
+    const gchar *best = NULL;
+    gint best_rank = G_MAXINT, best_ext = G_MAXINT;
+    GPtrArray *names;
+    guint i;
+
+    filename = g_filename_from_uri (uri, NULL, NULL);
+    if (filename == NULL) {
+        return NULL;
+    }
+
+    dirname = g_path_get_dirname (filename);
+    stem = g_path_get_basename (filename);
+    dot = strrchr (stem, '.');
+
+    names = dot != NULL ? bp_subtitle_list_dir (dirname) : NULL;
+    if (names != NULL) {
+        *dot = '\0';
+
+        for (i = 0; i < names->len; i++) {
+            const gchar *name = g_ptr_array_index (names, i);
+            gint rank = bp_subtitle_rank (name, stem);
+            gint ext = bp_subtitle_extension_index (name);
+
+            if (rank >= 0 && (rank < best_rank || (rank == best_rank && ext < best_ext))) {
+                best = name;
+                best_rank = rank;
+                best_ext = ext;
+            }
+        }
+
+        if (best != NULL) {
+            gchar *subfile = g_build_filename (dirname, best, NULL);
+            suburi = g_filename_to_uri (subfile, NULL, NULL);
+            g_free (subfile);
+        }
+
+        g_ptr_array_foreach (names, (GFunc)g_free, NULL);
+        g_ptr_array_free (names, TRUE);
+    }
+
+    g_free (stem);
+    g_free (dirname);
+    g_free (filename);
+
+    return suburi;
+}
+
+// Fallback for video sinks we could not put a subtitleoverlay in front of:
+// playbin only reads suburi when it sets up a new source, so the whole
+// pipeline has to go through READY and seek back
+static void
+bp_subtitle_set_suburi (BansheePlayer *player, const gchar *uri)
+{
+    gint64 pos = -1;
+    GstState state;
+    gboolean paused = FALSE;
+
+    gst_element_get_state (player->playbin, &state, NULL, 0);
+    if (state < GST_STATE_PAUSED) {
+        g_object_set (G_OBJECT (player->playbin), "suburi", uri, NULL);
+        return;
+    }
+
+    paused = (state == GST_STATE_PAUSED);
+    gst_element_query_position (player->playbin, GST_FORMAT_BYTES, &pos);
+    gst_element_set_state (player->playbin, GST_STATE_READY);
+    // Force to wait asynch operation
+    gst_element_get_state (player->playbin, &state, NULL, -1);
+
+    g_object_set (G_OBJECT (player->playbin), "suburi", uri, NULL);
+    gst_element_set_state (player->playbin, paused ? GST_STATE_PAUSED : GST_STATE_PLAYING);
+
+    // Force to wait asynch operation
+    gst_element_get_state (player->playbin, &state, NULL, -1);
+
+    if (pos != -1) {
+        gst_element_seek_simple (player->playbin, GST_FORMAT_BYTES, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, pos);
+    }
+}
+
+static void
+bp_subtitle_detach_source (BansheePlayer *player)
+{
+    GstElement *source = player->subtitle_source;
+    GstObject *videobin;
+    GstPad *pad;
+
+    if (source == NULL) {
+        return;
+    }
+
+    player->subtitle_source = NULL;
+    pad = gst_element_get_static_pad (player->subtitle_overlay, "subtitle_sink");
+
+    // The overlay may be holding the subtitle streaming thread until the
+    // video catches up; flush it so the source can shut down
+    gst_pad_send_event (pad, gst_event_new_flush_start ());
+    gst_element_set_locked_state (source, TRUE);
+    gst_element_set_state (source, GST_STATE_NULL);
+
+    videobin = gst_object_get_parent (GST_OBJECT (source));
+    if (videobin != NULL) {
+        gst_bin_remove (GST_BIN (videobin), source);
+        gst_object_unref (videobin);
+    }
+
+    gst_pad_send_event (pad, gst_event_new_flush_stop (TRUE));
+    gst_object_unref (pad);
+}
+
+static gboolean
+bp_subtitle_attach_source (BansheePlayer *player, const gchar *uri)
+{
+    GstElement *source, *src, *parse;
+    GstObject *videobin;
+    GstPad *pad, *sinkpad;
+    GstPadLinkReturn link;
+
+    src = gst_element_make_from_uri (GST_URI_SRC, uri, NULL, NULL);
+    parse = gst_element_factory_make ("subparse", NULL);
+    if (src == NULL || parse == NULL) {
+        bp_debug ("[subtitle]: Could not create a source for %s", uri);
+        if (src != NULL) {
+            gst_object_unref (src);
+        }
+        if (parse != NULL) {
+            gst_object_unref (parse);
+        }
+        return FALSE;
+    }
+
+    source = gst_bin_new ("external-subtitle");
+    gst_bin_add_many (GST_BIN (source), src, parse, NULL);
+    gst_element_link (src, parse);
+
+    pad = gst_element_get_static_pad (parse, "src");
+    gst_element_add_pad (source, gst_ghost_pad_new ("src", pad));
+    gst_object_unref (pad);
+
+    videobin = gst_object_get_parent (GST_OBJECT (player->subtitle_overlay));
+    gst_bin_add (GST_BIN (videobin), source);
+    gst_object_unref (videobin);
+
+    pad = gst_element_get_static_pad (source, "src");
+    sinkpad = gst_element_get_static_pad (player->subtitle_overlay, "subtitle_sink");
+    link = gst_pad_link (pad, sinkpad);
+    gst_object_unref (sinkpad);
+    gst_object_unref (pad);
+
+    player->subtitle_source = source;
+
+    if (link != GST_PAD_LINK_OK) {
+        bp_debug ("[subtitle]: Could not link subtitle source for %s", uri);
+        bp_subtitle_detach_source (player);
+        return FALSE;
+    }
+
+    gst_element_sync_state_with_parent (source);
+    return TRUE;
+}
+
+static void
+bp_subtitle_set_external (BansheePlayer *player, const gchar *uri)
+{
+    gint64 pos = -1;
+    GstState state;
+
+    if (player->subtitle_overlay == NULL) {
+        bp_subtitle_set_suburi (player, uri);
+        return;
+    }
+
+    if (g_strcmp0 (uri, player->subtitle_uri) == 0) {
+        return;
+    }
+
+    bp_subtitle_detach_source (player);
+    g_free (player->subtitle_uri);
+    player->subtitle_uri = NULL;
+
+    if (uri == NULL || !bp_subtitle_attach_source (player, uri)) {
+        return;
+    }
+
+    player->subtitle_uri = g_strdup (uri);
+    banshee_trace (BANSHEE_TRACE_SUBTITLE, BANSHEE_TRACE_EVENT_ATTACH, 1, 0);
+
+    // The new subtitle stream starts with a segment at 0; a flushing seek
+    // to where we are gives it and the video matching segments again. This
+    // only flushes the decoders, unlike the READY round-trip suburi needs.
+    gst_element_get_state (player->playbin, &state, NULL, 0);
+    if (state >= GST_STATE_PAUSED &&
+        gst_element_query_position (player->playbin, GST_FORMAT_TIME, &pos) && pos >= 0) {
+        gst_element_seek_simple (player->playbin, GST_FORMAT_TIME,
+            GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, pos);
+    }
+}
+
+static gboolean
+bp_subtitle_apply (gpointer data)
+{
+    BansheePlayer *player = (BansheePlayer *)data;
+    gboolean next_track;
+    gchar *suburi;
+
+    g_mutex_lock (player->subtitle_mutex);
+    suburi = player->subtitle_found_uri;
+    next_track = player->subtitle_found_next;
+    player->subtitle_found_uri = NULL;
+    player->subtitle_idle_id = 0;
+    g_mutex_unlock (player->subtitle_mutex);
+
+    if (suburi == NULL || player->playbin == NULL) {
+        g_free (suburi);
+        return FALSE;
+    }
+
+    bp_debug2 ("[subtitle]: Found subtitle file: %s", suburi);
+
+    if (next_track && player->subtitle_next_pending) {
+        // Keep showing the current track's subtitle until the next one starts
+        g_free (player->subtitle_next_uri);
+        player->subtitle_next_uri = suburi;
+        return FALSE;
+    }
+
+    bp_subtitle_set_external (player, suburi);
+    g_free (suburi);
+    return FALSE;
+}
+
+static void
+bp_subtitle_lookup_func (BpSubtitleLookup *lookup, BansheePlayer *player)
+{
+    gchar *suburi = bp_subtitle_find (lookup->uri);
+
+    g_mutex_lock (player->subtitle_mutex);
+    // Drop the result if another track was opened in the meantime
+    if (suburi != NULL && lookup->serial == player->subtitle_lookup_serial) {
+        g_free (player->subtitle_found_uri);
+        player->subtitle_found_uri = suburi;
+        player->subtitle_found_next = lookup->next_track;
+        suburi = NULL;
+
+        if (player->subtitle_idle_id == 0) {
+            player->subtitle_idle_id = g_idle_add (bp_subtitle_apply, player);
+        }
+    }
+    g_mutex_unlock (player->subtitle_mutex);
+
+    g_free (suburi);
+    g_free (lookup->uri);
+    g_free (lookup);
+}
+
+// ---------------------------------------------------------------------------
+// Internal Functions
+// ---------------------------------------------------------------------------
+
+void
+_bp_subtitle_init (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    player->subtitle_mutex = g_mutex_new ();
+
+    // A single worker: lookups are cheap once the directory is cached, and
+    // only the one for the current track matters anyway
+    player->subtitle_pool = g_thread_pool_new ((GFunc)bp_subtitle_lookup_func, player, 1, FALSE, NULL);
+}
+
+void
+_bp_subtitle_destroy (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    if (player->subtitle_pool != NULL) {
+        // Drop queued lookups and wait for the running one to finish
+        _bp_subtitle_cancel_lookup (player);
+        g_thread_pool_free (player->subtitle_pool, TRUE, TRUE);
+        player->subtitle_pool = NULL;
+    }
+
+    if (player->subtitle_idle_id != 0) {
+        g_source_remove (player->subtitle_idle_id);
+        player->subtitle_idle_id = 0;
+    }
+
+    g_free (player->subtitle_found_uri);
+    player->subtitle_found_uri = NULL;
+    g_free (player->subtitle_next_uri);
+    player->subtitle_next_uri = NULL;
+    g_free (player->subtitle_uri);
+    player->subtitle_uri = NULL;
+
+    // The elements themselves go away with the pipeline
+    player->subtitle_source = NULL;
+    player->subtitle_overlay = NULL;
+
+    if (player->subtitle_mutex != NULL) {
+        g_mutex_free (player->subtitle_mutex);
+        player->subtitle_mutex = NULL;
+    }
+}
+
+GstElement *
+_bp_subtitle_wrap_video_sink (BansheePlayer *player, GstElement *videosink)
+{
+    GstElement *videobin, *overlay;
+    GstPad *pad;
+
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), videosink);
+
+    // subtitleoverlay passes video through untouched as long as nothing is
+    // linked to its subtitle pad, so it costs nothing until it's used
+    overlay = gst_element_factory_make ("subtitleoverlay", "subtitle-overlay");
+    if (overlay == NULL) {
+        bp_debug ("[subtitle]: subtitleoverlay is not available, external subtitles need a pipeline restart");
+        return videosink;
+    }
+
+    videobin = gst_bin_new ("videobin");
+    gst_bin_add_many (GST_BIN (videobin), overlay, videosink, NULL);
+    if (!gst_element_link (overlay, videosink)) {
+        // Hand the sink back untouched, floating as we got it
+        gst_object_ref (videosink);
+        gst_bin_remove (GST_BIN (videobin), videosink);
+        gst_object_unref (videobin);
+        g_object_force_floating (G_OBJECT (videosink));
+        return videosink;
+    }
+
+    pad = gst_element_get_static_pad (overlay, "video_sink");
+    gst_element_add_pad (videobin, gst_ghost_pad_new ("sink", pad));
+    gst_object_unref (pad);
+
+    player->subtitle_overlay = overlay;
+    return videobin;
+}
+
+void
+_bp_subtitle_reset (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    _bp_subtitle_cancel_lookup (player);
+
+    player->subtitle_next_pending = FALSE;
+    g_free (player->subtitle_next_uri);
+    player->subtitle_next_uri = NULL;
+
+    if (player->subtitle_overlay != NULL) {
+        bp_subtitle_detach_source (player);
+        g_free (player->subtitle_uri);
+        player->subtitle_uri = NULL;
+    } else if (player->playbin != NULL) {
+        g_object_set (G_OBJECT (player->playbin), "suburi", NULL, NULL);
+    }
+}
+
+void
+_bp_subtitle_cancel_lookup (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    g_mutex_lock (player->subtitle_mutex);
+    player->subtitle_lookup_serial++;
+    g_free (player->subtitle_found_uri);
+    player->subtitle_found_uri = NULL;
+    g_mutex_unlock (player->subtitle_mutex);
+}
+
+void
+_bp_subtitle_lookup (BansheePlayer *player, const gchar *uri, gboolean next_track)
+{
+    BpSubtitleLookup *lookup;
+    gchar *scheme;
+    gint flags;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    _bp_subtitle_cancel_lookup (player);
+
+    if (next_track) {
+        // Without a subtitle of its own, the next track starts with none
+        player->subtitle_next_pending = TRUE;
+        g_free (player->subtitle_next_uri);
+        player->subtitle_next_uri = NULL;
+    }
+
+    if (uri == NULL) {
+        return;
+    }
+
+    // Always enable rendering of subtitles
+    g_object_get (G_OBJECT (player->playbin), "flags", &flags, NULL);
+    flags |= (1 << 2);//GST_PLAY_FLAG_TEXT
+    g_object_set (G_OBJECT (player->playbin), "flags", flags, NULL);
+
+    scheme = g_uri_parse_scheme (uri);
+    if (scheme == NULL || strcmp (scheme, "file") != 0) {
+        g_free (scheme);
+        return;
+    }
+    g_free (scheme);
+
+    // Looking for the subtitle means stat'ing and listing the video's
+    // directory, which may be a network mount; never do it on the caller
+    bp_debug ("[subtitle]: lookup for subtitle for video file.");
+
+    lookup = g_new0 (BpSubtitleLookup, 1);
+    lookup->uri = g_strdup (uri);
+    lookup->next_track = next_track;
+    g_mutex_lock (player->subtitle_mutex);
+    lookup->serial = player->subtitle_lookup_serial;
+    g_mutex_unlock (player->subtitle_mutex);
+
+    g_thread_pool_push (player->subtitle_pool, lookup, NULL);
+}
+
+void
+_bp_subtitle_next_track_starting (BansheePlayer *player)
+{
+    gchar *uri;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    if (!player->subtitle_next_pending) {
+        return;
+    }
+
+    uri = player->subtitle_next_uri;
+    player->subtitle_next_uri = NULL;
+    player->subtitle_next_pending = FALSE;
+
+    if (uri != NULL || player->subtitle_overlay != NULL) {
+        bp_subtitle_set_external (player, uri);
+    }
+    g_free (uri);
+}
+
+void
+_bp_subtitle_set_silent (BansheePlayer *player, gboolean silent)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    if (player->subtitle_overlay != NULL) {
+        g_object_set (G_OBJECT (player->subtitle_overlay), "silent", silent, NULL);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public Functions
+// ---------------------------------------------------------------------------
+
+P_INVOKE void
+bp_set_subtitle_uri (BansheePlayer *player, const gchar *uri)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+    g_return_if_fail (player->playbin != NULL);
+
+    bp_subtitle_set_external (player, uri);
+}
+
+P_INVOKE gchar *
+bp_get_subtitle_uri (BansheePlayer *player)
+{
+    gchar *uri;
+    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), "");
+
+    if (player->subtitle_overlay != NULL) {
+        return g_strdup (player->subtitle_uri);
+    }
+
+    g_object_get (G_OBJECT (player->playbin), "suburi", &uri, NULL);
+    return uri;
+}
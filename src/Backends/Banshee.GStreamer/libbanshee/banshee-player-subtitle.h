@@ -0,0 +1,40 @@
+//
+// banshee-player-subtitle.h
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef _BANSHEE_PLAYER_SUBTITLE_H
+#define _BANSHEE_PLAYER_SUBTITLE_H
+
+#include "banshee-player-private.h"
+
+void        _bp_subtitle_init                (BansheePlayer *player);
+void        _bp_subtitle_destroy             (BansheePlayer *player);
+GstElement *_bp_subtitle_wrap_video_sink     (BansheePlayer *player, GstElement *videosink);
+void        _bp_subtitle_reset               (BansheePlayer *player);
+void        _bp_subtitle_lookup              (BansheePlayer *player, const gchar *uri, gboolean next_track);
+void        _bp_subtitle_cancel_lookup       (BansheePlayer *player);
+void        _bp_subtitle_next_track_starting (BansheePlayer *player);
+void        _bp_subtitle_set_silent          (BansheePlayer *player, gboolean silent);
+
+#endif /* _BANSHEE_PLAYER_SUBTITLE_H */
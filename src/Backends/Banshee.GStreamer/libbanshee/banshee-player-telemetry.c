@@ -0,0 +1,198 @@
+//
+// banshee-player-telemetry.c
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <gst/audio/audio.h>
+
+#include "banshee-player-telemetry.h"
+#include "banshee-player-output.h"
+
+static const gchar *bp_telemetry_queue_names[BP_TELEMETRY_QUEUE_COUNT] = {
+    "cdda-readahead",
+    "audiosinkqueue",
+    "vis-queue"
+};
+
+// ---------------------------------------------------------------------------
+// Private Functions
+// ---------------------------------------------------------------------------
+
+static void
+bp_telemetry_count (GstElement *queue, volatile gint *counter)
+{
+    g_atomic_int_inc (counter);
+}
+
+static void
+bp_telemetry_sample_queue (BansheePlayer *player, BpTelemetryQueue index, BpQueueHealth *health)
+{
+    guint64 level_time = 0;
+
+    memset (health, 0, sizeof (BpQueueHealth));
+
+    if (player->telemetry_queues[index] == NULL) {
+        return;
+    }
+
+    g_object_get (player->telemetry_queues[index],
+        "current-level-time", &level_time,
+        "current-level-bytes", &health->level_bytes,
+        "current-level-buffers", &health->level_buffers,
+        NULL);
+
+    health->level_time_ms = (gint64)(level_time / GST_MSECOND);
+    health->overruns = g_atomic_int_get (&player->telemetry_overruns[index]);
+    health->underruns = g_atomic_int_get (&player->telemetry_underruns[index]);
+}
+
+// The real sink inside an autoaudiosink only exists while it is out of NULL;
+// the lookup is kept until the child goes away
+static GstElement *
+bp_telemetry_get_audio_sink (BansheePlayer *player)
+{
+    if (player->telemetry_audio_sink != NULL) {
+        return player->telemetry_audio_sink;
+    }
+
+    player->telemetry_audio_sink = _bp_output_find_audio_base_sink (player->audiosink);
+    if (player->telemetry_audio_sink != NULL) {
+        g_object_add_weak_pointer (G_OBJECT (player->telemetry_audio_sink),
+            (gpointer *)&player->telemetry_audio_sink);
+    }
+
+    return player->telemetry_audio_sink;
+}
+
+// How far the audio device's clock moved away from the pipeline clock since
+// the first sample after the open; zero when the device drives the pipeline
+static gint64
+bp_telemetry_sample_drift (BansheePlayer *player, GstElement *sink)
+{
+    GstClock *audio_clock, *pipeline_clock;
+    GstClockTimeDiff offset;
+    gint64 drift = 0;
+
+    audio_clock = GST_AUDIO_BASE_SINK (sink)->provided_clock;
+    pipeline_clock = gst_element_get_clock (player->playbin);
+
+    if (audio_clock != NULL && pipeline_clock != NULL && audio_clock != pipeline_clock) {
+        offset = GST_CLOCK_DIFF (gst_clock_get_time (pipeline_clock), gst_clock_get_time (audio_clock));
+        if (!player->telemetry_clock_calibrated) {
+            player->telemetry_clock_offset = offset;
+            player->telemetry_clock_calibrated = TRUE;
+        }
+        drift = (offset - player->telemetry_clock_offset) / GST_USECOND;
+    }
+
+    if (pipeline_clock != NULL) {
+        gst_object_unref (pipeline_clock);
+    }
+
+    return drift;
+}
+
+// ---------------------------------------------------------------------------
+// Internal Functions
+// ---------------------------------------------------------------------------
+
+void
+_bp_telemetry_pipeline_setup (BansheePlayer *player)
+{
+    gint i;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    for (i = 0; i < BP_TELEMETRY_QUEUE_COUNT; i++) {
+        // The audiobin keeps these alive for as long as the pipeline exists
+        GstElement *queue = gst_bin_get_by_name (GST_BIN (player->audiobin), bp_telemetry_queue_names[i]);
+        player->telemetry_queues[i] = queue;
+        if (queue == NULL) {
+            continue;
+        }
+
+        g_signal_connect (queue, "overrun", G_CALLBACK (bp_telemetry_count), &player->telemetry_overruns[i]);
+        g_signal_connect (queue, "underrun", G_CALLBACK (bp_telemetry_count), &player->telemetry_underruns[i]);
+        gst_object_unref (queue);
+    }
+}
+
+// The audio sink was replaced; look it up again and restart drift tracking
+// against the new device clock
+void
+_bp_telemetry_sink_changed (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    if (player->telemetry_audio_sink != NULL) {
+        g_object_remove_weak_pointer (G_OBJECT (player->telemetry_audio_sink),
+            (gpointer *)&player->telemetry_audio_sink);
+        player->telemetry_audio_sink = NULL;
+    }
+
+    player->telemetry_clock_calibrated = FALSE;
+}
+
+void
+_bp_telemetry_reset (BansheePlayer *player)
+{
+    gint i;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    for (i = 0; i < BP_TELEMETRY_QUEUE_COUNT; i++) {
+        g_atomic_int_set (&player->telemetry_overruns[i], 0);
+        g_atomic_int_set (&player->telemetry_underruns[i], 0);
+    }
+
+    player->telemetry_clock_calibrated = FALSE;
+}
+
+// ---------------------------------------------------------------------------
+// Public Functions
+// ---------------------------------------------------------------------------
+
+P_INVOKE void
+bp_get_telemetry (BansheePlayer *player, BpTelemetry *telemetry)
+{
+    GstElement *sink;
+
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+    g_return_if_fail (telemetry != NULL);
+
+    memset (telemetry, 0, sizeof (BpTelemetry));
+
+    if (player->playbin == NULL) {
+        return;
+    }
+
+    bp_telemetry_sample_queue (player, BP_TELEMETRY_QUEUE_READAHEAD, &telemetry->readahead);
+    bp_telemetry_sample_queue (player, BP_TELEMETRY_QUEUE_SINK, &telemetry->sink);
+    bp_telemetry_sample_queue (player, BP_TELEMETRY_QUEUE_VIS, &telemetry->vis);
+
+    if ((sink = bp_telemetry_get_audio_sink (player)) != NULL) {
+        telemetry->sink_latency_us = (gint64)(gst_base_sink_get_latency (GST_BASE_SINK (sink)) / GST_USECOND);
+        telemetry->sink_drift_us = bp_telemetry_sample_drift (player, sink);
+    }
+}
@@ -0,0 +1,52 @@
+//
+// banshee-player-telemetry.h
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef _BANSHEE_PLAYER_TELEMETRY_H
+#define _BANSHEE_PLAYER_TELEMETRY_H
+
+#include "banshee-player-private.h"
+
+typedef struct {
+    gint64 level_time_ms;      // current-level-time
+    guint level_bytes;         // current-level-bytes
+    guint level_buffers;       // current-level-buffers
+    guint overruns;            // times it filled up; drops on a leaky queue
+    guint underruns;           // times it ran empty
+} BpQueueHealth;
+
+typedef struct {
+    BpQueueHealth readahead;   // cdda-readahead, in front of the audiotee
+    BpQueueHealth sink;        // audiosinkqueue, in front of the audio sink
+    BpQueueHealth vis;         // vis-queue, the leaky visualization branch
+    gint64 sink_latency_us;    // latency the audio sink is configured with
+    gint64 sink_drift_us;      // audio clock against the pipeline clock since the open
+} BpTelemetry;
+
+void      _bp_telemetry_pipeline_setup (BansheePlayer *player);
+void      _bp_telemetry_sink_changed   (BansheePlayer *player);
+void      _bp_telemetry_reset          (BansheePlayer *player);
+
+#endif /* _BANSHEE_PLAYER_TELEMETRY_H */
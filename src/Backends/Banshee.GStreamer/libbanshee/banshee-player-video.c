@@ -29,6 +29,8 @@
 //
 
 #include "banshee-player-video.h"
+#include "banshee-player-dvd.h"
+#include "banshee-player-subtitle.h"
 
 // ---------------------------------------------------------------------------
 // Private Functions
@@ -114,6 +116,9 @@ bp_set_subtitle (BansheePlayer *player, int index)
     gint flags;
     g_object_get (G_OBJECT (player->playbin), "flags", &flags, NULL);
 
+    // External subtitles don't go through playbin, hide them as well
+    _bp_subtitle_set_silent (player, index == -1);
+
     if (index == -1) {
         flags &= ~(1 << 2);//GST_PLAY_FLAG_TEXT
         g_object_set (G_OBJECT (player->playbin), "flags", flags, NULL);
@@ -132,6 +137,10 @@ bp_video_sink_element_added (GstBin *videosink, GstElement *element, BansheePlay
     #if defined(GDK_WINDOWING_X11) || defined(GDK_WINDOWING_WIN32)
     bp_video_find_video_overlay (player);
     #endif
+
+    // autovideosink only plugs its real sink later, cache its navigation
+    // interface now rather than looking it up for every bus message
+    _bp_dvd_find_navigation (player);
 }
 
 static void
@@ -163,42 +172,84 @@ bp_video_bus_element_sync_message (GstBus *bus, GstMessage *message, BansheePlay
 static void
 cb_caps_set (GObject *obj, GParamSpec *pspec, BansheePlayer *p)
 {
-    GstStructure * s = NULL;
-    GstCaps * caps = gst_pad_get_current_caps (GST_PAD (obj));
+    // Called from the streaming thread; have the geometry read along with
+    // the stream counts on the main loop, like for the playbin signals
+    gst_element_post_message (p->playbin, gst_message_new_application (GST_OBJECT (p->playbin),
+        gst_structure_new_empty ("stream-changed")));
+}
 
-    if (G_UNLIKELY (!caps)) {
-        return;
+// Reads the geometry from the current caps of the video pad, returns
+// whether it differs from the last one read
+static gboolean
+bp_video_read_geometry (BansheePlayer *p)
+{
+    GstStructure *s;
+    GstCaps *caps;
+    const GValue *par;
+    gint width, height, fps_n, fps_d, par_n = 1, par_d = 1;
+    gboolean changed;
+
+    if (p->video_pad == NULL || (caps = gst_pad_get_current_caps (p->video_pad)) == NULL) {
+        return FALSE;
     }
 
     /* Get video decoder caps */
     s = gst_caps_get_structure (caps, 0);
-    if (s) {
-        const GValue *par;
 
-        /* We need at least width/height and framerate */
-        if (!(gst_structure_get_fraction (s, "framerate", &p->fps_n, &p->fps_d) &&
-            gst_structure_get_int (s, "width", &p->width) && gst_structure_get_int (s, "height", &p->height))) {
-            return;
-        }
+    /* We need at least width/height and framerate */
+    if (s == NULL || !(gst_structure_get_fraction (s, "framerate", &fps_n, &fps_d) &&
+        gst_structure_get_int (s, "width", &width) && gst_structure_get_int (s, "height", &height))) {
+        gst_caps_unref (caps);
+        return FALSE;
+    }
 
-        /* Get the PAR if available */
-        par = gst_structure_get_value (s, "pixel-aspect-ratio");
-        if (par) {
-            p->par_n = gst_value_get_fraction_numerator (par);
-            p->par_d = gst_value_get_fraction_denominator (par);
-        }
-        else { /* Square pixels */
-            p->par_n = 1;
-            p->par_d = 1;
-        }
+    /* Get the PAR if available, square pixels otherwise */
+    par = gst_structure_get_value (s, "pixel-aspect-ratio");
+    if (par) {
+        par_n = gst_value_get_fraction_numerator (par);
+        par_d = gst_value_get_fraction_denominator (par);
+    }
+
+    gst_caps_unref (caps);
 
-        /* Notify PlayerEngine if a callback was set */
-        if (p->video_geometry_notify_cb != NULL) {
-            p->video_geometry_notify_cb (p, p->width, p->height, p->fps_n, p->fps_d, p->par_n, p->par_d);
+    changed = width != p->width || height != p->height || fps_n != p->fps_n ||
+        fps_d != p->fps_d || par_n != p->par_n || par_d != p->par_d;
+
+    p->width = width;
+    p->height = height;
+    p->fps_n = fps_n;
+    p->fps_d = fps_d;
+    p->par_n = par_n;
+    p->par_d = par_d;
+
+    return changed;
+}
+
+// Keeps notify::caps connected to exactly one pad: the first video pad
+// of playbin, which may be replaced when the streams change
+static void
+bp_video_track_pad (BansheePlayer *player, GstPad *vpad)
+{
+    if (vpad == player->video_pad) {
+        if (vpad != NULL) {
+            gst_object_unref (vpad);
         }
+        return;
     }
 
-    gst_caps_unref (caps);
+    if (player->video_pad != NULL) {
+        g_signal_handler_disconnect (player->video_pad, player->video_caps_notify_id);
+        gst_object_unref (player->video_pad);
+        player->video_caps_notify_id = 0;
+    }
+
+    // Keeps the reference get-video-pad gave us
+    player->video_pad = vpad;
+
+    if (vpad != NULL) {
+        player->video_caps_notify_id = g_signal_connect (vpad, "notify::caps",
+            G_CALLBACK (cb_caps_set), player);
+    }
 }
 
 void
@@ -206,6 +257,7 @@ _bp_parse_stream_info (BansheePlayer *player)
 {
     gint audios_streams, video_streams, text_streams;
     GstPad *vpad = NULL;
+    gboolean geometry_changed, counts_changed;
 
     g_object_get (G_OBJECT (player->playbin), "n-audio", &audios_streams,
         "n-video", &video_streams, "n-text", &text_streams, NULL);
@@ -218,15 +270,48 @@ _bp_parse_stream_info (BansheePlayer *player)
         }
     }
 
-    if (G_LIKELY (vpad)) {
-        GstCaps *caps = gst_pad_get_current_caps (vpad);
-        if (G_LIKELY (caps)) {
-            cb_caps_set (G_OBJECT (vpad), NULL, player);
-            gst_caps_unref (caps);
-        }
-        g_signal_connect (vpad, "notify::caps", G_CALLBACK (cb_caps_set), player);
-        gst_object_unref (vpad);
+    bp_video_track_pad (player, vpad);
+    geometry_changed = bp_video_read_geometry (player);
+
+    counts_changed = !player->stream_info_valid || audios_streams != player->n_audio ||
+        video_streams != player->n_video || text_streams != player->n_text;
+
+    player->stream_info_valid = TRUE;
+    player->n_audio = audios_streams;
+    player->n_video = video_streams;
+    player->n_text = text_streams;
+
+    // Only call into managed code when something actually changed
+    if (geometry_changed && player->video_geometry_notify_cb != NULL) {
+        player->video_geometry_notify_cb (player, player->width, player->height,
+            player->fps_n, player->fps_d, player->par_n, player->par_d);
     }
+
+    if ((geometry_changed || counts_changed) && player->stream_info_cb != NULL) {
+        player->stream_info_cb (player, audios_streams, video_streams, text_streams,
+            player->width, player->height, player->fps_n, player->fps_d, player->par_n, player->par_d);
+    }
+}
+
+// Called when opening a new stream so its info is reported even if it
+// matches the previous stream's
+void
+_bp_video_reset_stream_info (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    player->stream_info_valid = FALSE;
+    player->width = player->height = 0;
+    player->fps_n = player->fps_d = 0;
+    player->par_n = player->par_d = 0;
+}
+
+void
+_bp_video_destroy (BansheePlayer *player)
+{
+    g_return_if_fail (IS_BANSHEE_PLAYER (player));
+
+    bp_video_track_pad (player, NULL);
 }
 
 void
@@ -239,7 +324,8 @@ _bp_video_pipeline_setup (BansheePlayer *player, GstBus *bus)
     if (player->video_pipeline_setup_cb != NULL) {
         videosink = player->video_pipeline_setup_cb (player, bus);
         if (videosink != NULL && GST_IS_ELEMENT (videosink)) {
-            g_object_set (G_OBJECT (player->playbin), "video-sink", videosink, NULL);
+            g_object_set (G_OBJECT (player->playbin), "video-sink",
+                _bp_subtitle_wrap_video_sink (player, videosink), NULL);
             player->video_display_context_type = BP_VIDEO_DISPLAY_CONTEXT_CUSTOM;
             return;
         }
@@ -258,7 +344,8 @@ _bp_video_pipeline_setup (BansheePlayer *player, GstBus *bus)
         }
     }
     
-    g_object_set (G_OBJECT (player->playbin), "video-sink", videosink, NULL);
+    g_object_set (G_OBJECT (player->playbin), "video-sink",
+        videosink != NULL ? _bp_subtitle_wrap_video_sink (player, videosink) : NULL, NULL);
     
     gst_bus_set_sync_handler (bus, gst_bus_sync_signal_handler, player, NULL);
     g_signal_connect (bus, "sync-message::element", G_CALLBACK (bp_video_bus_element_sync_message), player);
@@ -301,6 +388,12 @@ bp_set_video_geometry_notify_callback (BansheePlayer *player, BansheePlayerVideo
     SET_CALLBACK (video_geometry_notify_cb);
 }
 
+P_INVOKE void
+bp_set_stream_info_callback (BansheePlayer *player, BansheePlayerStreamInfoCallback cb)
+{
+    SET_CALLBACK (stream_info_cb);
+}
+
 P_INVOKE void
 bp_set_video_prepare_window_callback (BansheePlayer *player, BansheePlayerVideoPrepareWindowCallback cb)
 {
@@ -35,5 +35,7 @@
 
 void _bp_video_pipeline_setup  (BansheePlayer *player, GstBus *bus);
 void _bp_parse_stream_info (BansheePlayer *player);
+void _bp_video_reset_stream_info (BansheePlayer *player);
+void _bp_video_destroy (BansheePlayer *player);
 
 #endif /* _BANSHEE_PLAYER_VIDEO_H */
@@ -34,6 +34,15 @@
 #include "banshee-player-dvd.h"
 #include "banshee-player-missing-elements.h"
 #include "banshee-player-replaygain.h"
+#include "banshee-player-subtitle.h"
+#include "banshee-player-buffering.h"
+#include "banshee-player-cache.h"
+#include "banshee-player-latency.h"
+#include "banshee-player-telemetry.h"
+#include "banshee-player-multi-output.h"
+#include "banshee-player-meter.h"
+#include "banshee-player-output.h"
+#include "banshee-player-video.h"
 
 // ---------------------------------------------------------------------------
 // Private Functions
@@ -50,47 +59,6 @@ bp_pipeline_set_state (BansheePlayer *player, GstState state)
     }
 }
 
-static void
-bp_lookup_for_subtitle (BansheePlayer *player, const gchar *uri)
-{
-    gchar *scheme, *filename, *subfile, *dot, *suburi;
-    int j;
-    // Always enable rendering of subtitles
-    gint flags;
-    g_object_get (G_OBJECT (player->playbin), "flags", &flags, NULL);
-    flags |= (1 << 2);//GST_PLAY_FLAG_TEXT
-    g_object_set (G_OBJECT (player->playbin), "flags", flags, NULL);
-
-    bp_debug ("[subtitle]: lookup for subtitle for video file.");
-    scheme = g_uri_parse_scheme (uri);
-    static gchar *subtitle_extensions[] = { ".srt", ".sub", ".smi", ".txt", ".mpl", ".dks", ".qtx" };
-    if (scheme == NULL || strcmp (scheme, "file") != 0) {
-        g_free (scheme);
-        return;
-    }
-    g_free (scheme);
-
-    dot = g_strrstr (uri, ".");
-    if (dot == NULL)
-        return;
-    filename = g_filename_from_uri (g_strndup (uri, dot - uri), NULL, NULL);
-
-    for (j = 0; j < G_N_ELEMENTS (subtitle_extensions); j++) {
-        subfile = g_strconcat (filename, subtitle_extensions[j], NULL);
-        if (g_file_test (subfile, G_FILE_TEST_EXISTS | G_FILE_TEST_IS_REGULAR)) {
-            bp_debug ("[subtitle]: Found srt file: %s", subfile);
-            suburi = g_filename_to_uri (subfile, NULL, NULL);
-            g_object_set (G_OBJECT (player->playbin), "suburi", suburi, NULL);
-            g_free (suburi);
-            g_free (subfile);
-            g_free (filename);
-            return;
-        }
-        g_free (subfile);
-    }
-    g_free (filename);
-}
-
 // ---------------------------------------------------------------------------
 // Public Functions
 // ---------------------------------------------------------------------------
@@ -115,8 +83,26 @@ bp_destroy (BansheePlayer *player)
     if (player->dvd_device != NULL) {
         g_free (player->dvd_device);
     }
+
+    g_free (player->output_device);
+    g_free (player->audiosink_factory);
     
+    _bp_subtitle_destroy (player);
+    _bp_video_destroy (player);
     _bp_pipeline_destroy (player);
+    _bp_multi_output_destroy (player);
+
+    // Only once the streaming threads are gone
+    if (player->navigation != NULL) {
+        gst_object_unref (player->navigation);
+    }
+
+    if (player->navigation_mutex != NULL) {
+        g_mutex_free (player->navigation_mutex);
+    }
+
+    _bp_meter_destroy (player);
+    _bp_cache_destroy (player);
     _bp_missing_elements_destroy (player);
     
     memset (player, 0, sizeof (BansheePlayer));
@@ -130,10 +116,18 @@ bp_destroy (BansheePlayer *player)
 P_INVOKE BansheePlayer *
 bp_new ()
 {
-    BansheePlayer *player = g_new0 (BansheePlayer, 1);
+    BansheePlayer *player;
+
+    banshee_gst_wait_initialized ();
+
+    player = g_new0 (BansheePlayer, 1);
     
     player->video_mutex = g_mutex_new ();
     player->replaygain_mutex = g_mutex_new ();
+    player->navigation_mutex = g_mutex_new ();
+    player->cdda_readahead_seconds = BP_CDDA_READAHEAD_DEFAULT_SECONDS;
+    _bp_subtitle_init (player);
+    _bp_meter_init (player);
 
     return player;
 }
@@ -148,8 +142,12 @@ P_INVOKE gboolean
 bp_open (BansheePlayer *player, const gchar *uri, gboolean maybe_video)
 {
     GstState state;
+    gchar *playback_uri;
     
     g_return_val_if_fail (IS_BANSHEE_PLAYER (player), FALSE);
+
+    bp_trace (BANSHEE_TRACE_EVENT_OPEN, maybe_video, 0);
+    _bp_latency_reset (player);
     
     // Build the pipeline if we need to
     if (player->playbin == NULL && !_bp_pipeline_construct (player)) {
@@ -172,13 +170,25 @@ bp_open (BansheePlayer *player, const gchar *uri, gboolean maybe_video)
         player->target_state = GST_STATE_READY;
         gst_element_set_state (player->playbin, GST_STATE_READY);
     }
+
+    // Nothing streams now, so the CDDA read-ahead cache can be put in or
+    // taken out of the audio path
+    _bp_cdda_readahead_link (player);
     
-    // Pass the request off to playbin
-    g_object_set (G_OBJECT (player->playbin), "uri", uri, NULL);
+    // Pass the request off to playbin, dropping the previous track's subtitle
+    _bp_subtitle_reset (player);
+    _bp_video_reset_stream_info (player);
+    _bp_buffering_reset (player);
+    _bp_cache_reset (player);
+    _bp_telemetry_reset (player);
+    playback_uri = _bp_cache_resolve_uri (player, uri);
+    g_object_set (G_OBJECT (player->playbin), "uri", playback_uri, NULL);
+    g_free (playback_uri);
+    _bp_latency_mark (player, BP_OPEN_MILESTONE_URI_SET);
     
     if (maybe_video) {
         // Lookup for subtitle files with same name/folder
-        bp_lookup_for_subtitle (player, uri);
+        _bp_subtitle_lookup (player, uri, FALSE);
     }
 
     player->in_gapless_transition = FALSE;
@@ -222,12 +232,14 @@ bp_play (BansheePlayer *player)
 P_INVOKE gboolean
 bp_set_next_track (BansheePlayer *player, const gchar *uri, gboolean maybe_video)
 {
+    gchar *playback_uri;
+
     g_return_val_if_fail (IS_BANSHEE_PLAYER (player), FALSE);
     g_return_val_if_fail (player->playbin != NULL, FALSE);
-    g_object_set (G_OBJECT (player->playbin), "uri", uri, NULL);
-    if (maybe_video) {
-        bp_lookup_for_subtitle (player, uri);
-    }
+    playback_uri = _bp_cache_resolve_uri (player, uri);
+    g_object_set (G_OBJECT (player->playbin), "uri", playback_uri, NULL);
+    g_free (playback_uri);
+    _bp_subtitle_lookup (player, maybe_video ? uri : NULL, TRUE);
     return TRUE;
 }
 
@@ -241,6 +253,12 @@ bp_set_position (BansheePlayer *player, guint64 time_ms, gboolean accurate_seek)
         seek_flag |= GST_SEEK_FLAG_ACCURATE;
     }
 
+    bp_trace (BANSHEE_TRACE_EVENT_SEEK, time_ms, accurate_seek);
+
+    if (_bp_cdda_readahead_seek (player, time_ms * GST_MSECOND)) {
+        return TRUE;
+    }
+
     if (player->playbin == NULL || !gst_element_seek (player->playbin, 1.0, 
         GST_FORMAT_TIME, seek_flag,
         GST_SEEK_TYPE_SET, time_ms * GST_MSECOND, 
@@ -317,10 +335,6 @@ bp_audiosink_has_volume (BansheePlayer *player)
 P_INVOKE void
 bp_set_volume (BansheePlayer *player, gdouble volume)
 {
-    GParamSpec *volume_spec;
-    GValue value = { 0, };
-    GstElement *v;
-
     g_return_if_fail (IS_BANSHEE_PLAYER (player));
 
     // playbin will either control the volume property of the audiosinks real
@@ -329,25 +343,13 @@ bp_set_volume (BansheePlayer *player, gdouble volume)
     // Unfortunately if playbin creates a volume element it will be before our
     // audiosink and thus before our equalizer and replaygain, which is
     // undesirable because of latency issues (Most likely they insert too many
-    // queues). So only use the playbin volume support when we know our sink
-    // supports volume control
-
-    if (player->audiosink_has_volume) {
-      v = player->playbin;
-    } else {
-      v = player->volume;
-    }
+    // queues). So only use the sink's volume when we know our sink supports
+    // volume control, see _bp_output_apply_volume
 
-    g_return_if_fail (GST_IS_ELEMENT(v));
+    g_return_if_fail (GST_IS_ELEMENT (player->volume));
 
     player->current_volume = CLAMP (volume, 0.0, 1.0);
-    volume_spec = g_object_class_find_property (G_OBJECT_GET_CLASS (v), "volume");
-    g_value_init (&value, G_TYPE_DOUBLE);
-    g_value_set_double (&value, player->current_volume);
-    g_param_value_validate (volume_spec, &value);
-
-    g_object_set_property (G_OBJECT (v), "volume", &value);
-    g_value_unset (&value);
+    _bp_output_apply_volume (player);
     _bp_rgvolume_print_volume(player);
 }
 
@@ -433,45 +435,6 @@ bp_set_about_to_finish_callback (BansheePlayer *player, BansheePlayerAboutToFini
     SET_CALLBACK (about_to_finish_cb);
 }
 
-P_INVOKE void
-bp_set_subtitle_uri (BansheePlayer *player, const gchar *uri)
-{
-    g_return_if_fail (IS_BANSHEE_PLAYER (player));
-    gint64 pos = -1;
-    GstState state;
-    gboolean paused = FALSE;
-
-    // Gstreamer playbin do not support to set suburi during playback
-    // so have to stop/play and seek
-    gst_element_get_state (player->playbin, &state, NULL, 0);
-    paused = (state == GST_STATE_PAUSED);
-    if (state >= GST_STATE_PAUSED) {
-        gst_element_query_position (player->playbin, GST_FORMAT_BYTES, &pos);
-        gst_element_set_state (player->playbin, GST_STATE_READY);
-        // Force to wait asynch operation
-        gst_element_get_state (player->playbin, &state, NULL, -1);
-    }
-
-    g_object_set (G_OBJECT (player->playbin), "suburi", uri, NULL);
-    gst_element_set_state (player->playbin, paused ? GST_STATE_PAUSED : GST_STATE_PLAYING);
-
-    // Force to wait asynch operation
-    gst_element_get_state (player->playbin, &state, NULL, -1);
-
-    if (pos != -1) {
-        gst_element_seek_simple (player->playbin, GST_FORMAT_BYTES, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, pos);
-    }
-}
-
-P_INVOKE gchar *
-bp_get_subtitle_uri (BansheePlayer *player)
-{
-    gchar *uri;
-    g_return_val_if_fail (IS_BANSHEE_PLAYER (player), "");
-    g_object_get (G_OBJECT (player->playbin), "suburi", &uri, NULL);
-    return uri;
-}
-
 P_INVOKE gchar *
 bp_get_subtitle_description (BansheePlayer *player, int i)
 {
@@ -37,13 +37,7 @@
 
 #include "banshee-gst.h"
 #include "banshee-tagger.h"
-
-typedef struct BansheeRipper BansheeRipper;
-
-typedef void (* BansheeRipperFinishedCallback) (BansheeRipper *ripper);
-typedef void (* BansheeRipperMimeTypeCallback) (BansheeRipper *ripper, const gchar *mimetype);
-typedef void (* BansheeRipperProgressCallback) (BansheeRipper *ripper, gint msec, gpointer user_info);
-typedef void (* BansheeRipperErrorCallback)    (BansheeRipper *ripper, const gchar *error, const gchar *debug);
+#include "banshee-services.h"
 
 struct BansheeRipper {
     gboolean is_ripping;
@@ -56,6 +50,7 @@ struct BansheeRipper {
     
     GstElement *pipeline;
     GstElement *cddasrc;
+    GstElement *queue;
     GstElement *encoder;
     GstElement *filesink;
     
@@ -295,6 +290,7 @@ br_pipeline_construct (BansheeRipper *ripper)
     }
     
     g_object_set (G_OBJECT (queue), "max-size-time", 120 * GST_SECOND, NULL);
+    ripper->queue = queue;
     
     ripper->filesink = gst_element_factory_make ("filesink", "filesink");
     if (ripper->filesink == NULL) {
@@ -344,6 +340,7 @@ br_cancel (BansheeRipper *ripper)
         gst_element_set_state (GST_ELEMENT (ripper->pipeline), GST_STATE_NULL);
         gst_object_unref (GST_OBJECT (ripper->pipeline));
         ripper->pipeline = NULL;
+        ripper->queue = NULL;
     }
 }
 
@@ -374,6 +371,8 @@ br_rip_track (BansheeRipper *ripper, gint track_number, gchar *output_path,
 
     g_return_val_if_fail (ripper != NULL, FALSE);
 
+    banshee_gst_wait_initialized ();
+
     if (!br_pipeline_construct (ripper)) {
         return FALSE;
     }
@@ -447,3 +446,24 @@ br_get_is_ripping (BansheeRipper *ripper)
     g_return_val_if_fail (ripper != NULL, FALSE);
     return ripper->is_ripping;
 }
+
+// How far the encoder lags behind the drive
+void
+br_get_queue_level (BansheeRipper *ripper, gint64 *level_time_ms, guint *level_bytes)
+{
+    guint64 level_time = 0;
+    guint bytes = 0;
+
+    g_return_if_fail (ripper != NULL);
+
+    if (ripper->pipeline != NULL && ripper->queue != NULL) {
+        g_object_get (ripper->queue, "current-level-time", &level_time, "current-level-bytes", &bytes, NULL);
+    }
+
+    if (level_time_ms != NULL) {
+        *level_time_ms = (gint64)(level_time / GST_MSECOND);
+    }
+    if (level_bytes != NULL) {
+        *level_bytes = bytes;
+    }
+}
@@ -0,0 +1,107 @@
+//
+// banshee-services.h
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef _BANSHEE_SERVICES_H
+#define _BANSHEE_SERVICES_H
+
+#include <gst/gst.h>
+
+// The standalone services exported to the managed side; shared with
+// banshee-bench so its calls are checked against the definitions
+
+// Output device manager (banshee-output-manager.c)
+
+typedef struct {
+    gchar *id;                 // stable across runs where the provider allows
+    gchar *display_name;
+    gchar *caps;               // formats the device accepts
+    gint64 latency_us;         // default buffer-time of its sink, -1 if unknown
+    gboolean has_volume;       // the sink controls the device volume itself
+    gboolean is_default;
+} BansheeOutputDeviceInfo;
+
+typedef void (* BansheeOutputDevicesChangedCallback) (void);
+
+BansheeOutputDeviceInfo *bom_get_devices (gint *count);
+void      bom_free_devices (BansheeOutputDeviceInfo *infos, gint count);
+void      bom_set_devices_changed_callback (BansheeOutputDevicesChangedCallback cb);
+
+// BPM detector (banshee-bpmdetector.c)
+
+typedef struct BansheeBpmDetector BansheeBpmDetector;
+
+typedef void (* BansheeBpmDetectorFinishedCallback) ();
+typedef void (* BansheeBpmDetectorProgressCallback) (double bpm);
+typedef void (* BansheeBpmDetectorErrorCallback)    (const gchar *error, const gchar *debug);
+
+BansheeBpmDetector *bbd_new ();
+void      bbd_cancel (BansheeBpmDetector *detector);
+void      bbd_destroy (BansheeBpmDetector *detector);
+gboolean  bbd_process_file (BansheeBpmDetector *detector, const gchar *path);
+void      bbd_set_progress_callback (BansheeBpmDetector *detector, BansheeBpmDetectorProgressCallback cb);
+void      bbd_set_finished_callback (BansheeBpmDetector *detector, BansheeBpmDetectorFinishedCallback cb);
+void      bbd_set_error_callback (BansheeBpmDetector *detector, BansheeBpmDetectorErrorCallback cb);
+gboolean  bbd_get_is_detecting (BansheeBpmDetector *detector);
+
+// Transcoder (banshee-transcoder.c)
+
+typedef struct GstTranscoder GstTranscoder;
+
+typedef void (* GstTranscoderProgressCallback) (GstTranscoder *transcoder, gdouble progress);
+typedef void (* GstTranscoderFinishedCallback) (GstTranscoder *transcoder);
+typedef void (* GstTranscoderErrorCallback) (GstTranscoder *transcoder, const gchar *error, const gchar *debug);
+
+GstTranscoder *gst_transcoder_new ();
+void      gst_transcoder_free (GstTranscoder *transcoder);
+void      gst_transcoder_transcode (GstTranscoder *transcoder, const gchar *input_uri,
+                                    const gchar *output_uri, const gchar *encoder_pipeline);
+void      gst_transcoder_cancel (GstTranscoder *transcoder);
+void      gst_transcoder_set_progress_callback (GstTranscoder *transcoder, GstTranscoderProgressCallback cb);
+void      gst_transcoder_set_finished_callback (GstTranscoder *transcoder, GstTranscoderFinishedCallback cb);
+void      gst_transcoder_set_error_callback (GstTranscoder *transcoder, GstTranscoderErrorCallback cb);
+gboolean  gst_transcoder_get_is_transcoding (GstTranscoder *transcoder);
+
+// CD ripper (banshee-ripper.c)
+
+typedef struct BansheeRipper BansheeRipper;
+
+typedef void (* BansheeRipperFinishedCallback) (BansheeRipper *ripper);
+typedef void (* BansheeRipperMimeTypeCallback) (BansheeRipper *ripper, const gchar *mimetype);
+typedef void (* BansheeRipperProgressCallback) (BansheeRipper *ripper, gint msec, gpointer user_info);
+typedef void (* BansheeRipperErrorCallback)    (BansheeRipper *ripper, const gchar *error, const gchar *debug);
+
+BansheeRipper *br_new (gchar *device, gint paranoia_mode, gchar *encoder_pipeline);
+void      br_cancel (BansheeRipper *ripper);
+void      br_destroy (BansheeRipper *ripper);
+gboolean  br_rip_track (BansheeRipper *ripper, gint track_number, gchar *output_path,
+                        GstTagList *tags, gboolean *tagging_supported);
+void      br_set_progress_callback (BansheeRipper *ripper, BansheeRipperProgressCallback cb);
+void      br_set_mimetype_callback (BansheeRipper *ripper, BansheeRipperMimeTypeCallback cb);
+void      br_set_finished_callback (BansheeRipper *ripper, BansheeRipperFinishedCallback cb);
+void      br_set_error_callback (BansheeRipper *ripper, BansheeRipperErrorCallback cb);
+gboolean  br_get_is_ripping (BansheeRipper *ripper);
+void      br_get_queue_level (BansheeRipper *ripper, gint64 *level_time_ms, guint *level_bytes);
+
+#endif /* _BANSHEE_SERVICES_H */
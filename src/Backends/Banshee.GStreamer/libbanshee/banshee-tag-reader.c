@@ -0,0 +1,314 @@
+//
+// banshee-tag-reader.c
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+#include <gst/pbutils/pbutils.h>
+
+#include "banshee-gst.h"
+
+// Reads the stream properties and core tags of a batch of files with
+// GstDiscoverer, on a pool of worker threads, for library import
+
+// How long a single file may take before it is given up on
+#define BTR_DISCOVER_TIMEOUT (5 * GST_SECOND)
+
+typedef struct {
+    gint64 duration_ms;
+    gint bitrate;              // bits per second
+    gint channels;
+    gint sample_rate;
+    gint track_number;
+    gint track_count;
+    gint disc_number;
+    gint disc_count;
+    gint year;
+    gchar *codec;
+    gchar *title;
+    gchar *artist;
+    gchar *album;
+    gchar *album_artist;
+    gchar *composer;
+    gchar *genre;
+    gchar *error;              // NULL when the file could be read
+} BansheeTagReaderResult;
+
+typedef struct {
+    const gchar **paths;
+    BansheeTagReaderResult *results;
+    GMutex *mutex;
+    GSList *idle_discoverers;  // not in use by a worker right now
+} BtrBatch;
+
+// ---------------------------------------------------------------------------
+// Private Functions
+// ---------------------------------------------------------------------------
+
+static void
+btr_get_string (const GstTagList *tags, const gchar *tag, gchar **value)
+{
+    if (!gst_tag_list_get_string (tags, tag, value)) {
+        *value = NULL;
+    }
+}
+
+static gint
+btr_get_uint (const GstTagList *tags, const gchar *tag)
+{
+    guint value = 0;
+    return gst_tag_list_get_uint (tags, tag, &value) ? (gint)value : 0;
+}
+
+static gint
+btr_get_year (const GstTagList *tags)
+{
+    GstDateTime *date_time = NULL;
+    GDate *date = NULL;
+    gint year = 0;
+
+    if (gst_tag_list_get_date_time (tags, GST_TAG_DATE_TIME, &date_time)) {
+        if (gst_date_time_has_year (date_time)) {
+            year = gst_date_time_get_year (date_time);
+        }
+        gst_date_time_unref (date_time);
+    } else if (gst_tag_list_get_date (tags, GST_TAG_DATE, &date)) {
+        if (g_date_valid (date)) {
+            year = g_date_get_year (date);
+        }
+        g_date_free (date);
+    }
+
+    return year;
+}
+
+static void
+btr_read_audio_info (GstDiscovererInfo *info, BansheeTagReaderResult *result)
+{
+    GList *streams;
+    GstDiscovererAudioInfo *audio;
+    GstCaps *caps;
+
+    if ((streams = gst_discoverer_info_get_audio_streams (info)) == NULL) {
+        return;
+    }
+
+    audio = (GstDiscovererAudioInfo *)streams->data;
+    result->channels = gst_discoverer_audio_info_get_channels (audio);
+    result->sample_rate = gst_discoverer_audio_info_get_sample_rate (audio);
+    result->bitrate = gst_discoverer_audio_info_get_bitrate (audio);
+    if (result->bitrate == 0) {
+        result->bitrate = gst_discoverer_audio_info_get_max_bitrate (audio);
+    }
+
+    if (result->codec == NULL && (caps = gst_discoverer_stream_info_get_caps ((GstDiscovererStreamInfo *)audio)) != NULL) {
+        result->codec = gst_pb_utils_get_codec_description (caps);
+        gst_caps_unref (caps);
+    }
+
+    gst_discoverer_stream_info_list_free (streams);
+}
+
+static void
+btr_read_file (GstDiscoverer *discoverer, const gchar *path, BansheeTagReaderResult *result)
+{
+    GstDiscovererInfo *info;
+    const GstTagList *tags;
+    GError *error = NULL;
+    gchar *uri;
+    struct stat file_info;
+
+    if ((uri = g_filename_to_uri (path, NULL, &error)) == NULL) {
+        result->error = g_strdup (error->message);
+        g_error_free (error);
+        return;
+    }
+
+    info = gst_discoverer_discover_uri (discoverer, uri, &error);
+    g_free (uri);
+
+    if (info == NULL || gst_discoverer_info_get_result (info) != GST_DISCOVERER_OK) {
+        result->error = g_strdup (error != NULL ? error->message : "Could not read the file");
+        if (error != NULL) {
+            g_error_free (error);
+        }
+        if (info != NULL) {
+            gst_discoverer_info_unref (info);
+        }
+        return;
+    }
+
+    result->duration_ms = (gint64)(gst_discoverer_info_get_duration (info) / GST_MSECOND);
+
+    if ((tags = gst_discoverer_info_get_tags (info)) != NULL) {
+        btr_get_string (tags, GST_TAG_AUDIO_CODEC, &result->codec);
+        btr_get_string (tags, GST_TAG_TITLE, &result->title);
+        btr_get_string (tags, GST_TAG_ARTIST, &result->artist);
+        btr_get_string (tags, GST_TAG_ALBUM, &result->album);
+        btr_get_string (tags, GST_TAG_ALBUM_ARTIST, &result->album_artist);
+        btr_get_string (tags, GST_TAG_COMPOSER, &result->composer);
+        btr_get_string (tags, GST_TAG_GENRE, &result->genre);
+        result->track_number = btr_get_uint (tags, GST_TAG_TRACK_NUMBER);
+        result->track_count = btr_get_uint (tags, GST_TAG_TRACK_COUNT);
+        result->disc_number = btr_get_uint (tags, GST_TAG_ALBUM_VOLUME_NUMBER);
+        result->disc_count = btr_get_uint (tags, GST_TAG_ALBUM_VOLUME_COUNT);
+        result->year = btr_get_year (tags);
+    }
+
+    btr_read_audio_info (info, result);
+
+    // Neither the container nor the tags told, estimate it from the file size
+    if (result->bitrate == 0 && result->duration_ms > 0 && g_stat (path, &file_info) == 0) {
+        result->bitrate = (gint)((gint64)file_info.st_size * 8 * 1000 / result->duration_ms);
+    }
+
+    gst_discoverer_info_unref (info);
+}
+
+// Each worker takes an idle discoverer and hands it back when the file is
+// read, so a discoverer is only created when all of them are busy; that is
+// one per pool thread, each used by a single thread at a time, for the
+// whole batch
+static GstDiscoverer *
+btr_take_discoverer (BtrBatch *batch, GError **error)
+{
+    GstDiscoverer *discoverer = NULL;
+
+    g_mutex_lock (batch->mutex);
+    if (batch->idle_discoverers != NULL) {
+        discoverer = (GstDiscoverer *)batch->idle_discoverers->data;
+        batch->idle_discoverers = g_slist_delete_link (batch->idle_discoverers, batch->idle_discoverers);
+    }
+    g_mutex_unlock (batch->mutex);
+
+    return discoverer != NULL ? discoverer : gst_discoverer_new (BTR_DISCOVER_TIMEOUT, error);
+}
+
+static void
+btr_return_discoverer (BtrBatch *batch, GstDiscoverer *discoverer)
+{
+    g_mutex_lock (batch->mutex);
+    batch->idle_discoverers = g_slist_prepend (batch->idle_discoverers, discoverer);
+    g_mutex_unlock (batch->mutex);
+}
+
+static void
+btr_worker (gpointer data, gpointer user_data)
+{
+    BtrBatch *batch = (BtrBatch *)user_data;
+    gint index = GPOINTER_TO_INT (data) - 1;
+    GstDiscoverer *discoverer;
+    GError *error = NULL;
+
+    discoverer = btr_take_discoverer (batch, &error);
+    if (discoverer == NULL) {
+        batch->results[index].error = g_strdup (error != NULL ? error->message : "Could not create a discoverer");
+        if (error != NULL) {
+            g_error_free (error);
+        }
+        return;
+    }
+
+    btr_read_file (discoverer, batch->paths[index], &batch->results[index]);
+    btr_return_discoverer (batch, discoverer);
+}
+
+static void
+btr_finish_batch (BtrBatch *batch)
+{
+    g_slist_foreach (batch->idle_discoverers, (GFunc)g_object_unref, NULL);
+    g_slist_free (batch->idle_discoverers);
+    g_mutex_free (batch->mutex);
+}
+
+// ---------------------------------------------------------------------------
+// Public Functions
+// ---------------------------------------------------------------------------
+
+// Reads all of the paths before returning; the results are in the same
+// order and must be released with btr_free_batch
+BansheeTagReaderResult *
+btr_read_batch (const gchar **paths, gint count, gint max_threads)
+{
+    BtrBatch batch;
+    GThreadPool *pool;
+    gint i;
+
+    g_return_val_if_fail (paths != NULL || count == 0, NULL);
+
+    banshee_gst_wait_initialized ();
+
+    batch.paths = paths;
+    batch.results = g_new0 (BansheeTagReaderResult, MAX (count, 1));
+    batch.mutex = g_mutex_new ();
+    batch.idle_discoverers = NULL;
+
+    pool = g_thread_pool_new (btr_worker, &batch, MAX (max_threads, 1), FALSE, NULL);
+    if (pool == NULL) {
+        for (i = 0; i < count; i++) {
+            btr_worker (GINT_TO_POINTER (i + 1), &batch);
+        }
+        btr_finish_batch (&batch);
+        return batch.results;
+    }
+
+    for (i = 0; i < count; i++) {
+        g_thread_pool_push (pool, GINT_TO_POINTER (i + 1), NULL);
+    }
+
+    // Waits for every queued file to be read
+    g_thread_pool_free (pool, FALSE, TRUE);
+    btr_finish_batch (&batch);
+
+    return batch.results;
+}
+
+void
+btr_free_batch (BansheeTagReaderResult *results, gint count)
+{
+    gint i;
+
+    if (results == NULL) {
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        g_free (results[i].codec);
+        g_free (results[i].title);
+        g_free (results[i].artist);
+        g_free (results[i].album);
+        g_free (results[i].album_artist);
+        g_free (results[i].composer);
+        g_free (results[i].genre);
+        g_free (results[i].error);
+    }
+
+    g_free (results);
+}
@@ -30,8 +30,10 @@
 #  include "config.h"
 #endif
 
+#include <string.h>
 #include <glib/gstdio.h>
 
+#include "banshee-gst.h"
 #include "banshee-tagger.h"
 
 // ---------------------------------------------------------------------------
@@ -62,6 +64,336 @@ bt_tag_list_foreach (const GstTagList *list, const gchar *tag, gpointer userdata
     }
 }
 
+// Binary tag list format, all integers little endian:
+//
+//   "BTL1" guint32:entry-count
+//   entry: guint16:key-length key-bytes guint8:type payload
+//
+// Strings are a guint32 byte length followed by UTF-8 without a NUL. Image
+// samples are not copied; the entry refers to the value index in the source
+// list so the caller can fetch the data with bt_tag_list_get_image.
+
+#define BT_BLOB_MAGIC "BTL1"
+
+typedef enum {
+    BT_TAG_VALUE_STRING = 1,
+    BT_TAG_VALUE_UINT,
+    BT_TAG_VALUE_INT,
+    BT_TAG_VALUE_UINT64,
+    BT_TAG_VALUE_INT64,
+    BT_TAG_VALUE_DOUBLE,
+    BT_TAG_VALUE_BOOLEAN,
+    BT_TAG_VALUE_DATE,
+    BT_TAG_VALUE_DATE_TIME,
+    BT_TAG_VALUE_IMAGE_REFERENCE
+} BtTagValueType;
+
+typedef struct {
+    GByteArray *bytes;
+    guint32 count;
+} BtBlobWriter;
+
+typedef struct {
+    const guint8 *data;
+    gsize size;
+    gsize offset;
+} BtBlobReader;
+
+static void
+bt_blob_write_uint16 (GByteArray *bytes, guint16 value)
+{
+    value = GUINT16_TO_LE (value);
+    g_byte_array_append (bytes, (const guint8 *)&value, sizeof (value));
+}
+
+static void
+bt_blob_write_uint32 (GByteArray *bytes, guint32 value)
+{
+    value = GUINT32_TO_LE (value);
+    g_byte_array_append (bytes, (const guint8 *)&value, sizeof (value));
+}
+
+static void
+bt_blob_write_uint64 (GByteArray *bytes, guint64 value)
+{
+    value = GUINT64_TO_LE (value);
+    g_byte_array_append (bytes, (const guint8 *)&value, sizeof (value));
+}
+
+static void
+bt_blob_write_string (GByteArray *bytes, const gchar *value)
+{
+    guint32 length = value == NULL ? 0 : strlen (value);
+    bt_blob_write_uint32 (bytes, length);
+    g_byte_array_append (bytes, (const guint8 *)value, length);
+}
+
+static gboolean
+bt_blob_write_value (GByteArray *bytes, const GValue *value, guint index)
+{
+    GType type = G_VALUE_TYPE (value);
+    guint8 code;
+
+    if (type == G_TYPE_STRING) {
+        code = BT_TAG_VALUE_STRING;
+        g_byte_array_append (bytes, &code, 1);
+        bt_blob_write_string (bytes, g_value_get_string (value));
+    } else if (type == G_TYPE_UINT) {
+        code = BT_TAG_VALUE_UINT;
+        g_byte_array_append (bytes, &code, 1);
+        bt_blob_write_uint32 (bytes, g_value_get_uint (value));
+    } else if (type == G_TYPE_INT) {
+        code = BT_TAG_VALUE_INT;
+        g_byte_array_append (bytes, &code, 1);
+        bt_blob_write_uint32 (bytes, (guint32)g_value_get_int (value));
+    } else if (type == G_TYPE_UINT64) {
+        code = BT_TAG_VALUE_UINT64;
+        g_byte_array_append (bytes, &code, 1);
+        bt_blob_write_uint64 (bytes, g_value_get_uint64 (value));
+    } else if (type == G_TYPE_INT64) {
+        code = BT_TAG_VALUE_INT64;
+        g_byte_array_append (bytes, &code, 1);
+        bt_blob_write_uint64 (bytes, (guint64)g_value_get_int64 (value));
+    } else if (type == G_TYPE_DOUBLE) {
+        union { gdouble d; guint64 u; } bits;
+        bits.d = g_value_get_double (value);
+        code = BT_TAG_VALUE_DOUBLE;
+        g_byte_array_append (bytes, &code, 1);
+        bt_blob_write_uint64 (bytes, bits.u);
+    } else if (type == G_TYPE_BOOLEAN) {
+        guint8 flag = g_value_get_boolean (value) ? 1 : 0;
+        code = BT_TAG_VALUE_BOOLEAN;
+        g_byte_array_append (bytes, &code, 1);
+        g_byte_array_append (bytes, &flag, 1);
+    } else if (type == G_TYPE_DATE) {
+        const GDate *date = g_value_get_boxed (value);
+        guint8 month, day;
+
+        if (date == NULL || !g_date_valid (date)) {
+            return FALSE;
+        }
+
+        month = g_date_get_month (date);
+        day = g_date_get_day (date);
+        code = BT_TAG_VALUE_DATE;
+        g_byte_array_append (bytes, &code, 1);
+        bt_blob_write_uint16 (bytes, g_date_get_year (date));
+        g_byte_array_append (bytes, &month, 1);
+        g_byte_array_append (bytes, &day, 1);
+    } else if (type == GST_TYPE_DATE_TIME) {
+        GstDateTime *date_time = g_value_get_boxed (value);
+        gchar *iso;
+
+        if (date_time == NULL || (iso = gst_date_time_to_iso8601_string (date_time)) == NULL) {
+            return FALSE;
+        }
+
+        code = BT_TAG_VALUE_DATE_TIME;
+        g_byte_array_append (bytes, &code, 1);
+        bt_blob_write_string (bytes, iso);
+        g_free (iso);
+    } else if (type == GST_TYPE_SAMPLE) {
+        GstSample *sample = gst_value_get_sample (value);
+        GstBuffer *buffer = sample == NULL ? NULL : gst_sample_get_buffer (sample);
+        GstCaps *caps = sample == NULL ? NULL : gst_sample_get_caps (sample);
+
+        if (buffer == NULL) {
+            return FALSE;
+        }
+
+        code = BT_TAG_VALUE_IMAGE_REFERENCE;
+        g_byte_array_append (bytes, &code, 1);
+        bt_blob_write_uint32 (bytes, index);
+        bt_blob_write_uint32 (bytes, gst_buffer_get_size (buffer));
+        bt_blob_write_string (bytes, caps != NULL && gst_caps_get_size (caps) > 0
+            ? gst_structure_get_name (gst_caps_get_structure (caps, 0))
+            : NULL);
+    } else {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+bt_tag_list_serialize_foreach (const GstTagList *list, const gchar *tag, gpointer userdata)
+{
+    BtBlobWriter *writer = (BtBlobWriter *)userdata;
+    guint16 key_length = MIN (strlen (tag), G_MAXUINT16);
+    guint i, tag_count;
+
+    tag_count = gst_tag_list_get_tag_size (list, tag);
+    for (i = 0; i < tag_count; i++) {
+        const GValue *value = gst_tag_list_get_value_index (list, tag, i);
+        guint entry_start = writer->bytes->len;
+
+        if (value == NULL) {
+            continue;
+        }
+
+        bt_blob_write_uint16 (writer->bytes, key_length);
+        g_byte_array_append (writer->bytes, (const guint8 *)tag, key_length);
+
+        if (bt_blob_write_value (writer->bytes, value, i)) {
+            writer->count++;
+        } else {
+            // Unsupported value type, drop the key we already wrote
+            g_byte_array_set_size (writer->bytes, entry_start);
+        }
+    }
+}
+
+static gboolean
+bt_blob_read_bytes (BtBlobReader *reader, gpointer dest, gsize length)
+{
+    if (length > reader->size - reader->offset) {
+        return FALSE;
+    }
+
+    if (dest != NULL) {
+        memcpy (dest, reader->data + reader->offset, length);
+    }
+
+    reader->offset += length;
+    return TRUE;
+}
+
+static gboolean
+bt_blob_read_uint16 (BtBlobReader *reader, guint16 *value)
+{
+    if (!bt_blob_read_bytes (reader, value, sizeof (*value))) {
+        return FALSE;
+    }
+
+    *value = GUINT16_FROM_LE (*value);
+    return TRUE;
+}
+
+static gboolean
+bt_blob_read_uint32 (BtBlobReader *reader, guint32 *value)
+{
+    if (!bt_blob_read_bytes (reader, value, sizeof (*value))) {
+        return FALSE;
+    }
+
+    *value = GUINT32_FROM_LE (*value);
+    return TRUE;
+}
+
+static gboolean
+bt_blob_read_uint64 (BtBlobReader *reader, guint64 *value)
+{
+    if (!bt_blob_read_bytes (reader, value, sizeof (*value))) {
+        return FALSE;
+    }
+
+    *value = GUINT64_FROM_LE (*value);
+    return TRUE;
+}
+
+static gchar *
+bt_blob_read_string (BtBlobReader *reader, guint32 length)
+{
+    const gchar *start = (const gchar *)reader->data + reader->offset;
+
+    if (!bt_blob_read_bytes (reader, NULL, length) || !g_utf8_validate (start, length, NULL)) {
+        return NULL;
+    }
+
+    return g_strndup (start, length);
+}
+
+// Reads one value into an unset GValue; returns FALSE on a malformed blob.
+// Values that are well formed but cannot be restored (image references)
+// leave the GValue unset.
+static gboolean
+bt_blob_read_value (BtBlobReader *reader, guint8 code, GValue *value)
+{
+    guint16 u16;
+    guint32 u32;
+    guint64 u64;
+    guint8 u8[2];
+    gchar *str;
+
+    switch (code) {
+        case BT_TAG_VALUE_STRING:
+            if (!bt_blob_read_uint32 (reader, &u32) || (str = bt_blob_read_string (reader, u32)) == NULL) {
+                return FALSE;
+            }
+            g_value_init (value, G_TYPE_STRING);
+            g_value_take_string (value, str);
+            return TRUE;
+        case BT_TAG_VALUE_UINT:
+        case BT_TAG_VALUE_INT:
+            if (!bt_blob_read_uint32 (reader, &u32)) {
+                return FALSE;
+            }
+            if (code == BT_TAG_VALUE_UINT) {
+                g_value_init (value, G_TYPE_UINT);
+                g_value_set_uint (value, u32);
+            } else {
+                g_value_init (value, G_TYPE_INT);
+                g_value_set_int (value, (gint32)u32);
+            }
+            return TRUE;
+        case BT_TAG_VALUE_UINT64:
+        case BT_TAG_VALUE_INT64:
+        case BT_TAG_VALUE_DOUBLE:
+            if (!bt_blob_read_uint64 (reader, &u64)) {
+                return FALSE;
+            }
+            if (code == BT_TAG_VALUE_UINT64) {
+                g_value_init (value, G_TYPE_UINT64);
+                g_value_set_uint64 (value, u64);
+            } else if (code == BT_TAG_VALUE_INT64) {
+                g_value_init (value, G_TYPE_INT64);
+                g_value_set_int64 (value, (gint64)u64);
+            } else {
+                union { gdouble d; guint64 u; } bits;
+                bits.u = u64;
+                g_value_init (value, G_TYPE_DOUBLE);
+                g_value_set_double (value, bits.d);
+            }
+            return TRUE;
+        case BT_TAG_VALUE_BOOLEAN:
+            if (!bt_blob_read_bytes (reader, u8, 1)) {
+                return FALSE;
+            }
+            g_value_init (value, G_TYPE_BOOLEAN);
+            g_value_set_boolean (value, u8[0] != 0);
+            return TRUE;
+        case BT_TAG_VALUE_DATE:
+            if (!bt_blob_read_uint16 (reader, &u16) || !bt_blob_read_bytes (reader, u8, 2)) {
+                return FALSE;
+            }
+            if (g_date_valid_dmy (u8[1], u8[0], u16)) {
+                GDate *date = g_date_new_dmy (u8[1], u8[0], u16);
+                g_value_init (value, G_TYPE_DATE);
+                g_value_take_boxed (value, date);
+            }
+            return TRUE;
+        case BT_TAG_VALUE_DATE_TIME:
+            if (!bt_blob_read_uint32 (reader, &u32) || (str = bt_blob_read_string (reader, u32)) == NULL) {
+                return FALSE;
+            } else {
+                GstDateTime *date_time = gst_date_time_new_from_iso8601_string (str);
+                g_free (str);
+                if (date_time != NULL) {
+                    g_value_init (value, GST_TYPE_DATE_TIME);
+                    g_value_take_boxed (value, date_time);
+                }
+            }
+            return TRUE;
+        case BT_TAG_VALUE_IMAGE_REFERENCE:
+            return bt_blob_read_uint32 (reader, &u32)
+                && bt_blob_read_uint32 (reader, &u32)
+                && bt_blob_read_uint32 (reader, &u32)
+                && bt_blob_read_bytes (reader, NULL, u32);
+        default:
+            return FALSE;
+    }
+}
+
 // ---------------------------------------------------------------------------
 // Internal Functions
 // ---------------------------------------------------------------------------
@@ -69,6 +401,7 @@ bt_tag_list_foreach (const GstTagList *list, const gchar *tag, gpointer userdata
 GstTagList *
 bt_tag_list_new ()
 {
+    banshee_gst_wait_initialized ();
     return gst_tag_list_new_empty ();
 }
 
@@ -100,6 +433,155 @@ bt_tag_list_add_date (GstTagList *list, gint year, gint month, gint day)
     gst_tag_list_add (list, GST_TAG_MERGE_REPLACE, GST_TAG_DATE, date, NULL);
 }
 
+void
+bt_tag_list_add_date_time (GstTagList *list, gint year, gint month, gint day,
+    gint hour, gint minute, gint second)
+{
+    GstDateTime *date_time;
+
+    if (!g_date_valid_dmy (day, month, year)) {
+        return;
+    }
+
+    date_time = gst_date_time_new (0.0, year, month, day, hour, minute, second);
+    if (date_time == NULL) {
+        return;
+    }
+
+    gst_tag_list_add (list, GST_TAG_MERGE_REPLACE, GST_TAG_DATE_TIME, date_time, NULL);
+    gst_date_time_unref (date_time);
+}
+
+// Appends encoded image data (e.g. a PNG) as a front cover image; the
+// mime type is typefound from the data
+gboolean
+bt_tag_list_add_image (GstTagList *list, const guint8 *data, guint size)
+{
+    GstSample *sample;
+
+    sample = gst_tag_image_data_to_image_sample (data, size, GST_TAG_IMAGE_TYPE_FRONT_COVER);
+    if (sample == NULL) {
+        return FALSE;
+    }
+
+    gst_tag_list_add (list, GST_TAG_MERGE_APPEND, GST_TAG_IMAGE, sample, NULL);
+    gst_sample_unref (sample);
+    return TRUE;
+}
+
+// Returns a newly allocated blob (free with g_free) in the format described
+// above; values of types the format does not know are skipped
+guint8 *
+bt_tag_list_serialize (const GstTagList *list, guint *size)
+{
+    BtBlobWriter writer;
+    guint32 count;
+
+    writer.bytes = g_byte_array_new ();
+    writer.count = 0;
+
+    g_byte_array_append (writer.bytes, (const guint8 *)BT_BLOB_MAGIC, 4);
+    bt_blob_write_uint32 (writer.bytes, 0);
+
+    if (list != NULL) {
+        gst_tag_list_foreach (list, bt_tag_list_serialize_foreach, &writer);
+    }
+
+    count = GUINT32_TO_LE (writer.count);
+    memcpy (writer.bytes->data + 4, &count, sizeof (count));
+
+    *size = writer.bytes->len;
+    return g_byte_array_free (writer.bytes, FALSE);
+}
+
+// Returns NULL if the blob is malformed. Keys that are not registered tags,
+// values that cannot be converted to the tag's type and image references
+// are skipped.
+GstTagList *
+bt_tag_list_deserialize (const guint8 *data, guint size)
+{
+    BtBlobReader reader = { data, size, 0 };
+    GstTagList *list;
+    gchar magic[4];
+    guint32 i, count;
+
+    if (data == NULL || !bt_blob_read_bytes (&reader, magic, 4) ||
+        memcmp (magic, BT_BLOB_MAGIC, 4) != 0 || !bt_blob_read_uint32 (&reader, &count)) {
+        return NULL;
+    }
+
+    list = bt_tag_list_new ();
+
+    for (i = 0; i < count; i++) {
+        GValue value = { 0, };
+        guint16 key_length;
+        guint8 code;
+        gchar *key;
+        GType tag_type;
+
+        if (!bt_blob_read_uint16 (&reader, &key_length) ||
+            (key = bt_blob_read_string (&reader, key_length)) == NULL) {
+            gst_tag_list_free (list);
+            return NULL;
+        }
+
+        if (!bt_blob_read_bytes (&reader, &code, 1) || !bt_blob_read_value (&reader, code, &value)) {
+            g_free (key);
+            gst_tag_list_free (list);
+            return NULL;
+        }
+
+        if (G_IS_VALUE (&value) && gst_tag_exists (key)) {
+            tag_type = gst_tag_get_type (key);
+            if (tag_type == G_VALUE_TYPE (&value)) {
+                gst_tag_list_add_value (list, GST_TAG_MERGE_APPEND, key, &value);
+            } else if (g_value_type_transformable (G_VALUE_TYPE (&value), tag_type)) {
+                GValue converted = { 0, };
+                g_value_init (&converted, tag_type);
+                if (g_value_transform (&value, &converted)) {
+                    gst_tag_list_add_value (list, GST_TAG_MERGE_APPEND, key, &converted);
+                }
+                g_value_unset (&converted);
+            }
+        }
+
+        if (G_IS_VALUE (&value)) {
+            g_value_unset (&value);
+        }
+
+        g_free (key);
+    }
+
+    return list;
+}
+
+// Resolves an image reference from a serialized blob against the list it
+// was serialized from; returns a copy of the image data to free with g_free
+guint8 *
+bt_tag_list_get_image (const GstTagList *list, const gchar *tag_name, guint index, guint *size)
+{
+    GstSample *sample = NULL;
+    GstBuffer *buffer;
+    gpointer data = NULL;
+    gsize data_size = 0;
+
+    *size = 0;
+
+    if (!gst_tag_list_get_sample_index (list, tag_name, index, &sample)) {
+        return NULL;
+    }
+
+    buffer = gst_sample_get_buffer (sample);
+    if (buffer != NULL) {
+        gst_buffer_extract_dup (buffer, 0, gst_buffer_get_size (buffer), &data, &data_size);
+    }
+
+    gst_sample_unref (sample);
+
+    *size = data_size;
+    return data;
+}
+
 void
 bt_tag_list_dump (const GstTagList *list)
 {
@@ -0,0 +1,579 @@
+//
+// banshee-thumbnailer.c
+//
+// Copyright (C) 2026 The Banshee Project
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <gst/video/video.h>
+
+#include "banshee-gst.h"
+
+typedef struct BansheeThumbnailer BansheeThumbnailer;
+
+typedef void (* BansheeThumbnailerFinishedCallback) (gint id, const gchar *uri,
+    const gchar *path, const gchar *sprite_path, const gchar *error);
+
+// How long to wait for the pipeline to preroll or a seek to complete
+#define BVT_STATE_TIMEOUT (10 * GST_SECOND)
+
+struct BansheeThumbnailer {
+    volatile gint ref_count;
+
+    /*
+     * Every job runs the equivalent of:
+     * gst-launch uridecodebin uri=... ! videoconvert ! videoscale ! \
+     *     video/x-raw,format=RGB,width=160,pixel-aspect-ratio=1/1 ! appsink
+     * in PAUSED, seeks to key frames only and pulls the preroll sample
+     */
+
+    gchar *cache_dir;
+    gint width;
+    gint sprite_tiles;
+
+    GThreadPool *pool;
+    volatile gint next_id;
+
+    // Bumped by bvt_cancel; jobs queued before are skipped
+    volatile gint generation;
+
+    BansheeThumbnailerFinishedCallback finished_cb;
+};
+
+typedef struct {
+    BansheeThumbnailer *thumbnailer;
+    gint id;
+    gint generation;
+    gchar *uri;
+    gint64 position_ms;
+    gint width;
+    gint sprite_tiles;
+
+    gchar *path;
+    gchar *sprite_path;
+    gchar *error;
+} BvtJob;
+
+// ---------------------------------------------------------------------------
+// Private Functions
+// ---------------------------------------------------------------------------
+
+static BansheeThumbnailer *
+bvt_ref (BansheeThumbnailer *thumbnailer)
+{
+    g_atomic_int_inc (&thumbnailer->ref_count);
+    return thumbnailer;
+}
+
+static void
+bvt_unref (BansheeThumbnailer *thumbnailer)
+{
+    if (!g_atomic_int_dec_and_test (&thumbnailer->ref_count)) {
+        return;
+    }
+
+    g_free (thumbnailer->cache_dir);
+    g_free (thumbnailer);
+}
+
+static void
+bvt_job_free (BvtJob *job)
+{
+    bvt_unref (job->thumbnailer);
+    g_free (job->uri);
+    g_free (job->path);
+    g_free (job->sprite_path);
+    g_free (job->error);
+    g_free (job);
+}
+
+static gboolean
+bvt_job_is_cancelled (BvtJob *job)
+{
+    return g_atomic_int_get (&job->thumbnailer->generation) != job->generation;
+}
+
+static void
+bvt_pad_added (GstElement *decodebin, GstPad *pad, gpointer data)
+{
+    GstElement *videoconvert = GST_ELEMENT (data);
+    GstElement *fakesink;
+    GstCaps *caps;
+    GstPad *sinkpad;
+    gboolean is_video;
+
+    caps = gst_pad_query_caps (pad, NULL);
+    is_video = g_str_has_prefix (gst_structure_get_name (gst_caps_get_structure (caps, 0)), "video/");
+    gst_caps_unref (caps);
+
+    sinkpad = gst_element_get_static_pad (videoconvert, "sink");
+    if (is_video && !GST_PAD_IS_LINKED (sinkpad)) {
+        gst_pad_link (pad, sinkpad);
+        gst_object_unref (sinkpad);
+        return;
+    }
+    gst_object_unref (sinkpad);
+
+    // Audio and any extra video streams go nowhere, but must be linked
+    // so they don't stop the pipeline with not-linked
+    fakesink = gst_element_factory_make ("fakesink", NULL);
+    if (fakesink == NULL) {
+        return;
+    }
+
+    g_object_set (fakesink, "sync", FALSE, "async", FALSE, NULL);
+    gst_bin_add (GST_BIN (GST_ELEMENT_PARENT (decodebin)), fakesink);
+    gst_element_sync_state_with_parent (fakesink);
+
+    sinkpad = gst_element_get_static_pad (fakesink, "sink");
+    gst_pad_link (pad, sinkpad);
+    gst_object_unref (sinkpad);
+}
+
+static GstElement *
+bvt_pipeline_construct (BvtJob *job, GstElement **appsink_out)
+{
+    GstElement *pipeline, *decodebin, *videoconvert, *videoscale, *appsink;
+    GstCaps *caps;
+
+    decodebin = gst_element_factory_make ("uridecodebin", NULL);
+    videoconvert = gst_element_factory_make ("videoconvert", NULL);
+    videoscale = gst_element_factory_make ("videoscale", NULL);
+    appsink = gst_element_factory_make ("appsink", NULL);
+
+    if (decodebin == NULL || videoconvert == NULL || videoscale == NULL || appsink == NULL) {
+        job->error = g_strdup (_("Could not create thumbnailer pipeline elements"));
+        if (decodebin != NULL) gst_object_unref (decodebin);
+        if (videoconvert != NULL) gst_object_unref (videoconvert);
+        if (videoscale != NULL) gst_object_unref (videoscale);
+        if (appsink != NULL) gst_object_unref (appsink);
+        return NULL;
+    }
+
+    pipeline = gst_pipeline_new ("thumbnailer");
+    gst_bin_add_many (GST_BIN (pipeline), decodebin, videoconvert, videoscale, appsink, NULL);
+
+    // Only the width is fixed, videoscale keeps the display aspect ratio
+    caps = gst_caps_new_simple ("video/x-raw",
+        "format", G_TYPE_STRING, "RGB",
+        "width", G_TYPE_INT, job->width,
+        "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+        NULL);
+    g_object_set (appsink, "caps", caps, "sync", FALSE, NULL);
+    gst_caps_unref (caps);
+
+    if (!gst_element_link_many (videoconvert, videoscale, appsink, NULL)) {
+        job->error = g_strdup (_("Could not link pipeline elements"));
+        gst_object_unref (pipeline);
+        return NULL;
+    }
+
+    g_object_set (decodebin, "uri", job->uri, NULL);
+    g_signal_connect (decodebin, "pad-added", G_CALLBACK (bvt_pad_added), videoconvert);
+
+    *appsink_out = appsink;
+    return pipeline;
+}
+
+// Waits for the pipeline to preroll, after the PAUSED state change or a
+// flushing seek, and reports the bus error if it didn't
+static gboolean
+bvt_pipeline_wait (BvtJob *job, GstElement *pipeline)
+{
+    GstStateChangeReturn ret;
+    GstMessage *message;
+    GstBus *bus;
+
+    ret = gst_element_get_state (pipeline, NULL, NULL, BVT_STATE_TIMEOUT);
+    if (ret == GST_STATE_CHANGE_SUCCESS) {
+        return TRUE;
+    }
+
+    if (ret == GST_STATE_CHANGE_NO_PREROLL) {
+        job->error = g_strdup (_("Live streams can not be thumbnailed"));
+        return FALSE;
+    }
+
+    bus = gst_element_get_bus (pipeline);
+    message = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+    gst_object_unref (bus);
+
+    if (message != NULL) {
+        GError *error;
+        gst_message_parse_error (message, &error, NULL);
+        job->error = g_strdup (error->message);
+        g_error_free (error);
+        gst_message_unref (message);
+    } else if (ret == GST_STATE_CHANGE_ASYNC) {
+        job->error = g_strdup (_("Timed out waiting for a video frame"));
+    } else {
+        job->error = g_strdup (_("Could not decode the video"));
+    }
+
+    return FALSE;
+}
+
+static GstSample *
+bvt_pipeline_pull_frame (BvtJob *job, GstElement *pipeline, GstElement *appsink, GstClockTime position)
+{
+    GstSample *sample = NULL;
+
+    // Key frames only: no need to decode from the previous key frame up to
+    // the exact position, a poster frame a few seconds off is as good
+    if (!gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+            GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, position)) {
+        banshee_log_debug ("thumbnailer", "Could not seek %s, using the first frame", job->uri);
+    } else if (!bvt_pipeline_wait (job, pipeline)) {
+        return NULL;
+    }
+
+    g_signal_emit_by_name (appsink, "pull-preroll", &sample);
+    if (sample == NULL) {
+        job->error = g_strdup (_("Could not get a video frame"));
+    }
+
+    return sample;
+}
+
+static gboolean
+bvt_save_sample (BvtJob *job, GstSample *sample, const gchar *path)
+{
+    GstSample *png;
+    GstCaps *caps;
+    GstMapInfo map;
+    GError *error = NULL;
+    gboolean saved;
+
+    caps = gst_caps_new_empty_simple ("image/png");
+    png = gst_video_convert_sample (sample, caps, BVT_STATE_TIMEOUT, &error);
+    gst_caps_unref (caps);
+
+    if (png == NULL) {
+        job->error = g_strdup (error != NULL ? error->message : _("Could not encode the thumbnail"));
+        if (error != NULL) {
+            g_error_free (error);
+        }
+        return FALSE;
+    }
+
+    gst_buffer_map (gst_sample_get_buffer (png), &map, GST_MAP_READ);
+    saved = g_file_set_contents (path, (const gchar *)map.data, map.size, &error);
+    gst_buffer_unmap (gst_sample_get_buffer (png), &map);
+    gst_sample_unref (png);
+
+    if (!saved) {
+        job->error = g_strdup (error->message);
+        g_error_free (error);
+    }
+
+    return saved;
+}
+
+// Seek bar preview: sprite_tiles frames spread evenly over the stream,
+// laid out left to right, top to bottom in a single image
+static gboolean
+bvt_make_sprite (BvtJob *job, GstElement *pipeline, GstElement *appsink, GstClockTime duration)
+{
+    GstVideoInfo tile_info, sprite_info;
+    GstVideoFrame sprite_frame, tile_frame;
+    GstBuffer *buffer = NULL;
+    GstSample *sample, *sprite;
+    GstCaps *caps;
+    gint columns, rows, tile, line, width = 0, height = 0;
+    gboolean saved;
+
+    for (columns = 1; columns * columns < job->sprite_tiles; columns++);
+    rows = (job->sprite_tiles + columns - 1) / columns;
+
+    for (tile = 0; tile < job->sprite_tiles; tile++) {
+        GstClockTime position = gst_util_uint64_scale_int (duration, 2 * tile + 1, 2 * job->sprite_tiles);
+
+        if (bvt_job_is_cancelled (job)) {
+            break;
+        }
+
+        sample = bvt_pipeline_pull_frame (job, pipeline, appsink, position);
+        if (sample == NULL) {
+            break;
+        }
+
+        if (!gst_video_info_from_caps (&tile_info, gst_sample_get_caps (sample))) {
+            gst_sample_unref (sample);
+            break;
+        }
+
+        if (buffer == NULL) {
+            width = GST_VIDEO_INFO_WIDTH (&tile_info);
+            height = GST_VIDEO_INFO_HEIGHT (&tile_info);
+            gst_video_info_set_format (&sprite_info, GST_VIDEO_FORMAT_RGB, width * columns, height * rows);
+            buffer = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&sprite_info), NULL);
+            gst_buffer_memset (buffer, 0, 0, GST_VIDEO_INFO_SIZE (&sprite_info));
+        }
+
+        if (gst_video_frame_map (&tile_frame, &tile_info, gst_sample_get_buffer (sample), GST_MAP_READ)) {
+            gst_video_frame_map (&sprite_frame, &sprite_info, buffer, GST_MAP_WRITE);
+
+            for (line = 0; line < MIN (height, GST_VIDEO_FRAME_HEIGHT (&tile_frame)); line++) {
+                guint8 *dest = (guint8 *)GST_VIDEO_FRAME_PLANE_DATA (&sprite_frame, 0)
+                    + ((tile / columns) * height + line) * GST_VIDEO_FRAME_PLANE_STRIDE (&sprite_frame, 0)
+                    + (tile % columns) * width * 3;
+                const guint8 *src = (const guint8 *)GST_VIDEO_FRAME_PLANE_DATA (&tile_frame, 0)
+                    + line * GST_VIDEO_FRAME_PLANE_STRIDE (&tile_frame, 0);
+
+                memcpy (dest, src, MIN (width, GST_VIDEO_FRAME_WIDTH (&tile_frame)) * 3);
+            }
+
+            gst_video_frame_unmap (&sprite_frame);
+            gst_video_frame_unmap (&tile_frame);
+        }
+
+        gst_sample_unref (sample);
+    }
+
+    if (buffer == NULL) {
+        return FALSE;
+    }
+
+    if (tile < job->sprite_tiles) {
+        gst_buffer_unref (buffer);
+        return FALSE;
+    }
+
+    caps = gst_video_info_to_caps (&sprite_info);
+    sprite = gst_sample_new (buffer, caps, NULL, NULL);
+    gst_caps_unref (caps);
+    gst_buffer_unref (buffer);
+
+    saved = bvt_save_sample (job, sprite, job->sprite_path);
+    gst_sample_unref (sprite);
+
+    return saved;
+}
+
+static void
+bvt_generate (BvtJob *job)
+{
+    GstElement *pipeline, *appsink = NULL;
+    GstSample *sample;
+    GstClockTime position;
+    gint64 duration = -1;
+
+    pipeline = bvt_pipeline_construct (job, &appsink);
+    if (pipeline == NULL) {
+        return;
+    }
+
+    gst_element_set_state (pipeline, GST_STATE_PAUSED);
+    if (!bvt_pipeline_wait (job, pipeline)) {
+        goto done;
+    }
+
+    if (!gst_element_query_duration (pipeline, GST_FORMAT_TIME, &duration)) {
+        duration = -1;
+    }
+
+    if (job->position_ms >= 0) {
+        position = job->position_ms * GST_MSECOND;
+    } else if (duration > 0) {
+        // Skip opening credits and fades from black
+        position = duration / 3;
+    } else {
+        position = 0;
+    }
+
+    if (!g_file_test (job->path, G_FILE_TEST_EXISTS)) {
+        sample = bvt_pipeline_pull_frame (job, pipeline, appsink, position);
+        if (sample == NULL || !bvt_save_sample (job, sample, job->path)) {
+            if (sample != NULL) {
+                gst_sample_unref (sample);
+            }
+            goto done;
+        }
+        gst_sample_unref (sample);
+    }
+
+    if (job->sprite_path != NULL && !g_file_test (job->sprite_path, G_FILE_TEST_EXISTS)) {
+        if (duration <= 0 || !bvt_make_sprite (job, pipeline, appsink, duration)) {
+            // The poster frame is still good, just don't offer a sprite
+            banshee_log_debug ("thumbnailer", "No sprite for %s: %s", job->uri,
+                job->error != NULL ? job->error : "unknown duration");
+            g_free (job->error);
+            job->error = NULL;
+            g_free (job->sprite_path);
+            job->sprite_path = NULL;
+        }
+    }
+
+done:
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+    gst_object_unref (pipeline);
+}
+
+static gboolean
+bvt_job_finished (gpointer data)
+{
+    BvtJob *job = (BvtJob *)data;
+    BansheeThumbnailer *thumbnailer = job->thumbnailer;
+
+    if (!bvt_job_is_cancelled (job) && thumbnailer->finished_cb != NULL) {
+        thumbnailer->finished_cb (job->id, job->uri,
+            job->error == NULL ? job->path : NULL,
+            job->error == NULL ? job->sprite_path : NULL,
+            job->error);
+    }
+
+    bvt_job_free (job);
+    return FALSE;
+}
+
+static void
+bvt_worker (gpointer data, gpointer user_data)
+{
+    BvtJob *job = (BvtJob *)data;
+
+    if (bvt_job_is_cancelled (job)) {
+        bvt_job_free (job);
+        return;
+    }
+
+    if (!g_file_test (job->path, G_FILE_TEST_EXISTS) ||
+        (job->sprite_path != NULL && !g_file_test (job->sprite_path, G_FILE_TEST_EXISTS))) {
+        bvt_generate (job);
+    }
+
+    // The callback goes out on the main loop, like the other libbanshee ones
+    g_idle_add (bvt_job_finished, job);
+}
+
+// ---------------------------------------------------------------------------
+// Internal Functions
+// ---------------------------------------------------------------------------
+
+BansheeThumbnailer *
+bvt_new (const gchar *cache_dir, gint width, gint max_threads)
+{
+    BansheeThumbnailer *thumbnailer;
+
+    g_return_val_if_fail (cache_dir != NULL, NULL);
+
+    banshee_gst_wait_initialized ();
+
+    if (g_mkdir_with_parents (cache_dir, 0700) != 0) {
+        banshee_log_debug ("thumbnailer", "Could not create the cache directory %s", cache_dir);
+        return NULL;
+    }
+
+    thumbnailer = g_new0 (BansheeThumbnailer, 1);
+    thumbnailer->ref_count = 1;
+    thumbnailer->cache_dir = g_strdup (cache_dir);
+    thumbnailer->width = width > 0 ? width : 160;
+    thumbnailer->pool = g_thread_pool_new (bvt_worker, NULL, MAX (max_threads, 1), FALSE, NULL);
+
+    return thumbnailer;
+}
+
+void
+bvt_cancel (BansheeThumbnailer *thumbnailer)
+{
+    g_return_if_fail (thumbnailer != NULL);
+    g_atomic_int_inc (&thumbnailer->generation);
+}
+
+void
+bvt_destroy (BansheeThumbnailer *thumbnailer)
+{
+    g_return_if_fail (thumbnailer != NULL);
+
+    thumbnailer->finished_cb = NULL;
+    bvt_cancel (thumbnailer);
+
+    // Queued jobs are skipped as cancelled, wait for the running ones
+    g_thread_pool_free (thumbnailer->pool, FALSE, TRUE);
+    thumbnailer->pool = NULL;
+
+    bvt_unref (thumbnailer);
+}
+
+// Returns the request id passed to the finished callback. Negative
+// positions pick a frame a third into the stream.
+gint
+bvt_request (BansheeThumbnailer *thumbnailer, const gchar *uri, gint64 position_ms)
+{
+    BvtJob *job;
+    gchar *checksum, *name;
+
+    g_return_val_if_fail (thumbnailer != NULL, -1);
+    g_return_val_if_fail (uri != NULL, -1);
+
+    job = g_new0 (BvtJob, 1);
+    job->thumbnailer = bvt_ref (thumbnailer);
+#if GLIB_CHECK_VERSION(2,30,0)
+    job->id = g_atomic_int_add (&thumbnailer->next_id, 1);
+#else
+    job->id = g_atomic_int_exchange_and_add (&thumbnailer->next_id, 1);
+#endif
+    job->generation = g_atomic_int_get (&thumbnailer->generation);
+    job->uri = g_strdup (uri);
+    job->position_ms = position_ms;
+    job->width = thumbnailer->width;
+    job->sprite_tiles = thumbnailer->sprite_tiles;
+
+    checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+
+    name = position_ms >= 0
+        ? g_strdup_printf ("%s-%d-%" G_GINT64_FORMAT ".png", checksum, job->width, position_ms)
+        : g_strdup_printf ("%s-%d.png", checksum, job->width);
+    job->path = g_build_filename (thumbnailer->cache_dir, name, NULL);
+    g_free (name);
+
+    if (job->sprite_tiles > 0) {
+        name = g_strdup_printf ("%s-%d-sprite%d.png", checksum, job->width, job->sprite_tiles);
+        job->sprite_path = g_build_filename (thumbnailer->cache_dir, name, NULL);
+        g_free (name);
+    }
+
+    g_free (checksum);
+
+    g_thread_pool_push (thumbnailer->pool, job, NULL);
+    return job->id;
+}
+
+void
+bvt_set_sprite_tiles (BansheeThumbnailer *thumbnailer, gint tiles)
+{
+    g_return_if_fail (thumbnailer != NULL);
+    thumbnailer->sprite_tiles = MAX (tiles, 0);
+}
+
+void
+bvt_set_finished_callback (BansheeThumbnailer *thumbnailer, BansheeThumbnailerFinishedCallback cb)
+{
+    g_return_if_fail (thumbnailer != NULL);
+    thumbnailer->finished_cb = cb;
+}
@@ -33,11 +33,8 @@
 #include <glib/gi18n.h>
 #include <glib/gstdio.h>
 
-typedef struct GstTranscoder GstTranscoder;
-
-typedef void (* GstTranscoderProgressCallback) (GstTranscoder *transcoder, gdouble progress);
-typedef void (* GstTranscoderFinishedCallback) (GstTranscoder *transcoder);
-typedef void (* GstTranscoderErrorCallback) (GstTranscoder *transcoder, const gchar *error, const gchar *debug);
+#include "banshee-gst.h"
+#include "banshee-services.h"
 
 struct GstTranscoder {
     gboolean is_transcoding;
@@ -339,6 +336,8 @@ gst_transcoder_transcode(GstTranscoder *transcoder, const gchar *input_uri,
     if(transcoder->is_transcoding) {
         return;
     }
+
+    banshee_gst_wait_initialized ();
     
     if(!gst_transcoder_create_pipeline(transcoder, input_uri, output_uri, encoder_pipeline)) {
         gst_transcoder_raise_error(transcoder, _("Could not construct pipeline"), NULL); 
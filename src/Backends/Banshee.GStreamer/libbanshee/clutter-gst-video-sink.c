@@ -50,7 +50,6 @@
 #include <gst/gst.h>
 #include <gst/gstvalue.h>
 #include <gst/video/video.h>
-#include <gst/riff/riff-ids.h>
 
 #include <glib.h>
 #include <string.h>
@@ -61,6 +60,7 @@ static gchar *ayuv_to_rgba_shader = \
      "void main () {"
      "  vec4 color = texture2D (tex, vec2(" TEX_COORD "));"
      "  float y = 1.1640625 * (color.g - 0.0625);"
+     "  float u = color.b - 0.5;"
      "  float v = color.a - 0.5;"
      "  color.a = color.r;"
      "  color.r = y + 1.59765625 * v;"
@@ -94,35 +94,47 @@ static gchar *yv12_to_rgba_shader = \
      FRAGMENT_SHADER_END
      "}";
 
+/* NV12: the interleaved chroma plane is a luminance + alpha texture, so U
+ * is in every color channel and V in alpha */
+static gchar *nv12_to_rgba_shader = \
+     FRAGMENT_SHADER_VARS
+     "uniform sampler2D ytex;"
+     "uniform sampler2D uvtex;"
+     "void main () {"
+     "  vec2 coord = vec2(" TEX_COORD ");"
+     "  vec4 uv = texture2D (uvtex, coord);"
+     "  float y = 1.1640625 * (texture2D (ytex, coord).g - 0.0625);"
+     "  float u = uv.r - 0.5;"
+     "  float v = uv.a - 0.5;"
+     "  vec4 color;"
+     "  color.r = y + 1.59765625 * v;"
+     "  color.g = y - 0.390625 * u - 0.8125 * v;"
+     "  color.b = y + 2.015625 * u;"
+     "  color.a = 1.0;"
+     "  gl_FragColor = color;"
+     FRAGMENT_SHADER_END
+     "}";
+
 static GstStaticPadTemplate sinktemplate_all 
  = GST_STATIC_PAD_TEMPLATE ("sink",
                             GST_PAD_SINK,
                             GST_PAD_ALWAYS,
-                            GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV("AYUV") ";" \
-                                             GST_VIDEO_CAPS_YUV("YV12") ";" \
-                                             GST_VIDEO_CAPS_YUV("I420") ";" \
-                                             GST_VIDEO_CAPS_RGBA        ";" \
-                                             GST_VIDEO_CAPS_BGRA        ";" \
-                                             GST_VIDEO_CAPS_RGB         ";" \
-                                             GST_VIDEO_CAPS_BGR));
+                            GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{ AYUV, YV12, I420, NV12, RGBA, BGRA, RGB, BGR }")));
 
 GST_DEBUG_CATEGORY_STATIC (clutter_gst_video_sink_debug);
 #define GST_CAT_DEFAULT clutter_gst_video_sink_debug
 
-static GstElementDetails clutter_gst_video_sink_details =
-  GST_ELEMENT_DETAILS ("Clutter video sink",
-      "Sink/Video",
-      "Sends video data from a GStreamer pipeline to a Clutter texture",
-      "Jonathan Matthew <jonathan@kaolin.wh9.net>, "
-      "Matthew Allum <mallum@o-hand.com, "
-      "Chris Lord <chris@o-hand.com>");
-
 enum
 {
   PROP_0,
   PROP_TEXTURE,
+  PROP_USE_PBO,
+  PROP_PACING,
 };
 
+/* frames held back by the pacing mode, see clutter_gst_video_sink_repaint */
+#define CLUTTER_GST_PACING_QUEUE_LENGTH 3
+
 typedef enum
 {
   CLUTTER_GST_NOFORMAT,
@@ -131,6 +143,7 @@ typedef enum
   CLUTTER_GST_AYUV,
   CLUTTER_GST_YV12,
   CLUTTER_GST_I420,
+  CLUTTER_GST_NV12,
 } ClutterGstVideoFormat;
 
 typedef void (APIENTRYP GLUNIFORM1IPROC)(GLint location, GLint value);
@@ -139,12 +152,39 @@ typedef void (APIENTRYP GLGENPROGRAMSPROC)(GLsizei n, GLuint *programs);
 typedef void (APIENTRYP GLBINDPROGRAMPROC)(GLenum target, GLint program);
 typedef void (APIENTRYP GLPROGRAMSTRINGPROC)(GLenum target, GLenum format,
                                              GLsizei len, const void *string);
+/* GL_ARB_pixel_buffer_object */
+typedef void (APIENTRYP GLGENBUFFERSPROC)(GLsizei n, GLuint *buffers);
+typedef void (APIENTRYP GLDELETEBUFFERSPROC)(GLsizei n, const GLuint *buffers);
+typedef void (APIENTRYP GLBINDBUFFERPROC)(GLenum target, GLuint buffer);
+typedef void (APIENTRYP GLBUFFERDATAPROC)(GLenum target, GLsizeiptr size,
+                                          const void *data, GLenum usage);
+typedef void * (APIENTRYP GLMAPBUFFERPROC)(GLenum target, GLenum access);
+typedef GLboolean (APIENTRYP GLUNMAPBUFFERPROC)(GLenum target);
+
+#ifndef GL_PIXEL_UNPACK_BUFFER_ARB
+#define GL_PIXEL_UNPACK_BUFFER_ARB 0x88EC
+#endif
+#ifndef GL_STREAM_DRAW_ARB
+#define GL_STREAM_DRAW_ARB 0x88E0
+#endif
+#ifndef GL_WRITE_ONLY_ARB
+#define GL_WRITE_ONLY_ARB 0x88B9
+#endif
+
 typedef struct _ClutterGstSymbols
 {
   /* GL_ARB_fragment_program */
   GLGENPROGRAMSPROC   glGenProgramsARB;
   GLBINDPROGRAMPROC   glBindProgramARB;
   GLPROGRAMSTRINGPROC glProgramStringARB;
+
+  /* GL_ARB_pixel_buffer_object, all NULL if not supported */
+  GLGENBUFFERSPROC    glGenBuffersARB;
+  GLDELETEBUFFERSPROC glDeleteBuffersARB;
+  GLBINDBUFFERPROC    glBindBufferARB;
+  GLBUFFERDATAPROC    glBufferDataARB;
+  GLMAPBUFFERPROC     glMapBufferARB;
+  GLUNMAPBUFFERPROC   glUnmapBufferARB;
 } ClutterGstSymbols;
 
 /*
@@ -164,6 +204,13 @@ typedef void (ClutterGstRendererPaint) (ClutterActor *, ClutterGstVideoSink *);
 typedef void (ClutterGstRendererPostPaint) (ClutterActor *,
                                             ClutterGstVideoSink *);
 
+typedef struct
+{
+  GstBuffer    *buffer;
+  GstClockTime  running_time;  /* when it is due, NONE to show it asap */
+  GstClockTime  received;      /* when the sink got it, for the stats */
+} ClutterGstQueuedFrame;
+
 typedef struct _ClutterGstRenderer
 {
  const char            *name;     /* user friendly name */
@@ -187,16 +234,39 @@ typedef enum _ClutterGstRendererState
 struct _ClutterGstVideoSinkPrivate
 {
   ClutterTexture          *texture;
-  CoglHandle               u_tex;
-  CoglHandle               v_tex;
+  CoglHandle               y_tex;         /* also the RGB / AYUV texture */
+  CoglHandle               u_tex;         /* 2nd chroma plane in memory, or NV12 UV */
+  CoglHandle               v_tex;         /* 1st chroma plane in memory */
+  GLuint                   uv_gl_tex;     /* GL texture behind the NV12 u_tex */
+  int                      tex_width;     /* what the textures were */
+  int                      tex_height;    /* allocated for */
+  CoglPixelFormat          tex_format;
+  ClutterGstVideoFormat    tex_video_format;
+
+  gboolean                 use_pbo;
+  GLuint                   pbos[3][2];    /* two per plane, alternating */
+  int                      pbo_index;
   CoglHandle               program;
   CoglHandle               shader;
   GLuint                   fp;
 
-  GMutex                  *buffer_lock;   /* mutex for the buffer and idle_id */
+  GMutex                  *buffer_lock;   /* mutex for the buffer, idle_id
+                                             and the stats */
   GstBuffer               *buffer;
+  GstClockTime             buffer_time;   /* when the sink received buffer */
   guint                    idle_id;
 
+  ClutterGstVideoSinkStats stats;
+  GstClockTime             unpainted_time; /* receive time of the uploaded
+                                              frame, until it gets painted */
+  gulong                   paint_handler_id;
+
+  gboolean                 pacing;
+  GQueue                  *frames;        /* ClutterGstQueuedFrame, protected
+                                             by buffer_lock */
+  guint                    repaint_id;
+
+  GstVideoInfo             info;
   ClutterGstVideoFormat    format;
   gboolean                 bgr;
   int                      width;
@@ -215,17 +285,18 @@ struct _ClutterGstVideoSinkPrivate
 };
 
 
-#define _do_init(bla) \
+#define _do_init \
   GST_DEBUG_CATEGORY_INIT (clutter_gst_video_sink_debug, \
                                  "cluttersink", \
                                  0, \
                                  "clutter video sink")
 
-GST_BOILERPLATE_FULL (ClutterGstVideoSink,
-                          clutter_gst_video_sink,
-                      GstBaseSink,
-                      GST_TYPE_BASE_SINK,
-                      _do_init);
+G_DEFINE_TYPE_WITH_CODE (ClutterGstVideoSink,
+                         clutter_gst_video_sink,
+                         GST_TYPE_BASE_SINK,
+                         _do_init);
+
+#define parent_class clutter_gst_video_sink_parent_class
 
 /*
  * Small helpers
@@ -340,6 +411,339 @@ clutter_gst_dummy_deinit (ClutterGstVideoSink *sink)
 {
 }
 
+/*
+ * Texture uploads
+ *
+ * The textures are allocated once for a given size and format and then
+ * updated in place for every frame. Creating new ones per frame used to be
+ * where most of the time went with HD content.
+ */
+
+static void
+clutter_gst_video_sink_free_textures (ClutterGstVideoSink *sink)
+{
+  ClutterGstVideoSinkPrivate *priv = sink->priv;
+
+  if (priv->y_tex)
+    {
+      cogl_texture_unref (priv->y_tex);
+      priv->y_tex = COGL_INVALID_HANDLE;
+    }
+
+  if (priv->u_tex)
+    {
+      cogl_texture_unref (priv->u_tex);
+      priv->u_tex = COGL_INVALID_HANDLE;
+    }
+
+  if (priv->v_tex)
+    {
+      cogl_texture_unref (priv->v_tex);
+      priv->v_tex = COGL_INVALID_HANDLE;
+    }
+
+  priv->tex_width = priv->tex_height = 0;
+
+#ifdef CLUTTER_COGL_HAS_GL
+  /* Cogl doesn't own foreign textures */
+  if (priv->uv_gl_tex)
+    {
+      glDeleteTextures (1, &priv->uv_gl_tex);
+      priv->uv_gl_tex = 0;
+    }
+
+  if (priv->syms.glDeleteBuffersARB)
+    {
+      priv->syms.glDeleteBuffersARB (G_N_ELEMENTS (priv->pbos) * 2,
+                                     &priv->pbos[0][0]);
+      memset (priv->pbos, 0, sizeof (priv->pbos));
+    }
+#endif
+}
+
+/* Makes sure the textures match the current video size and format,
+ * allocating the chroma planes too for the planar formats */
+static void
+clutter_gst_video_sink_ensure_textures (ClutterGstVideoSink *sink,
+                                        CoglPixelFormat      format)
+{
+  ClutterGstVideoSinkPrivate *priv = sink->priv;
+  int chroma_width, chroma_height;
+
+  if (priv->y_tex &&
+      priv->tex_width == priv->width &&
+      priv->tex_height == priv->height &&
+      priv->tex_format == format &&
+      priv->tex_video_format == priv->format)
+    return;
+
+  clutter_gst_video_sink_free_textures (sink);
+
+  priv->y_tex = cogl_texture_new_with_size (priv->width,
+                                            priv->height,
+                                            COGL_TEXTURE_NO_SLICING,
+                                            format);
+
+  chroma_width = GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 1);
+  chroma_height = GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 1);
+
+  if (priv->format == CLUTTER_GST_YV12 || priv->format == CLUTTER_GST_I420)
+    {
+      priv->u_tex = cogl_texture_new_with_size (chroma_width,
+                                                chroma_height,
+                                                COGL_TEXTURE_NO_SLICING,
+                                                COGL_PIXEL_FORMAT_G_8);
+      priv->v_tex = cogl_texture_new_with_size (chroma_width,
+                                                chroma_height,
+                                                COGL_TEXTURE_NO_SLICING,
+                                                COGL_PIXEL_FORMAT_G_8);
+    }
+#ifdef CLUTTER_COGL_HAS_GL
+  else if (priv->format == CLUTTER_GST_NV12)
+    {
+      /* Cogl has no two channel format, so create the texture ourselves */
+      glGenTextures (1, &priv->uv_gl_tex);
+      glBindTexture (GL_TEXTURE_2D, priv->uv_gl_tex);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glTexImage2D (GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA,
+                    chroma_width, chroma_height, 0,
+                    GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, NULL);
+      glBindTexture (GL_TEXTURE_2D, 0);
+
+      priv->u_tex = cogl_texture_new_from_foreign (priv->uv_gl_tex,
+                                                   GL_TEXTURE_2D,
+                                                   chroma_width,
+                                                   chroma_height,
+                                                   0, 0,
+                                                   COGL_PIXEL_FORMAT_RGBA_8888);
+    }
+#endif
+
+  priv->tex_width = priv->width;
+  priv->tex_height = priv->height;
+  priv->tex_format = format;
+  priv->tex_video_format = priv->format;
+
+  clutter_texture_set_cogl_texture (priv->texture, priv->y_tex);
+}
+
+#ifdef CLUTTER_COGL_HAS_GL
+/* Uploads a plane with plain GL calls. With use-pbo the plane is streamed
+ * through a pixel buffer object so the driver can DMA it into the texture
+ * asynchronously. Every plane has two PBOs used in turn, and their storage
+ * is orphaned before being mapped, so we never wait for the GPU to be done
+ * with the previous frame. */
+static gboolean
+clutter_gst_video_sink_upload_plane_gl (ClutterGstVideoSink *sink,
+                                        int                  plane,
+                                        GLuint               gl_tex,
+                                        GLenum               gl_target,
+                                        int                  width,
+                                        int                  height,
+                                        GLenum               gl_format,
+                                        int                  bpp,
+                                        int                  rowstride,
+                                        const guint8        *data)
+{
+  ClutterGstVideoSinkPrivate *priv = sink->priv;
+  const guint8 *pixels = data;
+  int row, row_size = width * bpp;
+  gboolean use_pbo = priv->use_pbo && priv->syms.glMapBufferARB;
+
+  /* We are about to change GL state behind Cogl's back */
+  cogl_flush ();
+
+  if (use_pbo)
+    {
+      GLuint *pbo = &priv->pbos[plane][priv->pbo_index];
+      guint8 *dest;
+
+      if (*pbo == 0)
+        priv->syms.glGenBuffersARB (1, pbo);
+
+      priv->syms.glBindBufferARB (GL_PIXEL_UNPACK_BUFFER_ARB, *pbo);
+      priv->syms.glBufferDataARB (GL_PIXEL_UNPACK_BUFFER_ARB, row_size * height,
+                                  NULL, GL_STREAM_DRAW_ARB);
+      dest = priv->syms.glMapBufferARB (GL_PIXEL_UNPACK_BUFFER_ARB,
+                                        GL_WRITE_ONLY_ARB);
+      if (dest == NULL)
+        {
+          priv->syms.glBindBufferARB (GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+          return FALSE;
+        }
+
+      if (rowstride == row_size)
+        memcpy (dest, data, row_size * height);
+      else
+        for (row = 0; row < height; row++)
+          memcpy (dest + row * row_size, data + row * rowstride, row_size);
+
+      priv->syms.glUnmapBufferARB (GL_PIXEL_UNPACK_BUFFER_ARB);
+      pixels = NULL;
+    }
+  else
+    {
+      glPixelStorei (GL_UNPACK_ROW_LENGTH, rowstride / bpp);
+    }
+
+  glBindTexture (gl_target, gl_tex);
+  glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D (gl_target, 0, 0, 0, width, height,
+                   gl_format, GL_UNSIGNED_BYTE, pixels);
+  glBindTexture (gl_target, 0);
+  glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+
+  if (use_pbo)
+    priv->syms.glBindBufferARB (GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+
+  return TRUE;
+}
+
+static gboolean
+clutter_gst_video_sink_upload_plane_pbo (ClutterGstVideoSink *sink,
+                                         int                  plane,
+                                         CoglHandle           tex,
+                                         int                  width,
+                                         int                  height,
+                                         CoglPixelFormat      format,
+                                         int                  bpp,
+                                         int                  rowstride,
+                                         const guint8        *data)
+{
+  GLuint gl_tex;
+  GLenum gl_target, gl_format;
+
+  switch (format)
+    {
+    case COGL_PIXEL_FORMAT_G_8:       gl_format = GL_LUMINANCE; break;
+    case COGL_PIXEL_FORMAT_RGB_888:   gl_format = GL_RGB; break;
+    case COGL_PIXEL_FORMAT_BGR_888:   gl_format = GL_BGR; break;
+    case COGL_PIXEL_FORMAT_RGBA_8888: gl_format = GL_RGBA; break;
+    case COGL_PIXEL_FORMAT_BGRA_8888: gl_format = GL_BGRA; break;
+    default:
+      return FALSE;
+    }
+
+  if (!cogl_texture_get_gl_texture (tex, &gl_tex, &gl_target))
+    return FALSE;
+
+  return clutter_gst_video_sink_upload_plane_gl (sink, plane, gl_tex, gl_target,
+                                                 width, height, gl_format,
+                                                 bpp, rowstride, data);
+}
+#endif
+
+static void
+clutter_gst_video_sink_upload_plane (ClutterGstVideoSink *sink,
+                                     int                  plane,
+                                     CoglHandle           tex,
+                                     int                  width,
+                                     int                  height,
+                                     CoglPixelFormat      format,
+                                     int                  bpp,
+                                     int                  rowstride,
+                                     const guint8        *data)
+{
+  ClutterGstVideoSinkPrivate *priv = sink->priv;
+
+  if (tex == COGL_INVALID_HANDLE)
+    return;
+
+#ifdef CLUTTER_COGL_HAS_GL
+  if (priv->use_pbo && priv->syms.glMapBufferARB &&
+      clutter_gst_video_sink_upload_plane_pbo (sink, plane, tex, width, height,
+                                               format, bpp, rowstride, data))
+    return;
+#endif
+
+  cogl_texture_set_region (tex, 0, 0, 0, 0, width, height, width, height,
+                           format, rowstride, data);
+}
+
+/* Index of the histogram bucket for a duration, buckets are powers of two
+ * milliseconds up to 64ms */
+static int
+clutter_gst_video_sink_stats_bucket (GstClockTime duration)
+{
+  guint64 ms = duration / GST_MSECOND;
+  int bucket = 0;
+
+  while (ms > 0 && bucket < CLUTTER_GST_VIDEO_SINK_STATS_BUCKETS - 1)
+    {
+      ms >>= 1;
+      bucket++;
+    }
+
+  return bucket;
+}
+
+/* runs after the texture has been painted with its current frame */
+static void
+clutter_gst_video_sink_painted (ClutterActor        *actor,
+                                ClutterGstVideoSink *sink)
+{
+  ClutterGstVideoSinkPrivate *priv = sink->priv;
+  GstClockTime now;
+
+  /* the same frame gets painted again whenever the stage redraws, only
+   * count the first paint */
+  if (!GST_CLOCK_TIME_IS_VALID (priv->unpainted_time))
+    return;
+
+  now = gst_util_get_timestamp ();
+
+  g_mutex_lock (priv->buffer_lock);
+  priv->stats.painted++;
+  if (now >= priv->unpainted_time)
+    priv->stats.latency_histogram[
+      clutter_gst_video_sink_stats_bucket (now - priv->unpainted_time)]++;
+  g_mutex_unlock (priv->buffer_lock);
+
+  priv->unpainted_time = GST_CLOCK_TIME_NONE;
+}
+
+/* to be called once all the planes of a frame have been uploaded */
+static void
+clutter_gst_video_sink_uploaded (ClutterGstVideoSink *sink)
+{
+  ClutterGstVideoSinkPrivate *priv = sink->priv;
+
+  priv->pbo_index ^= 1;
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (priv->texture));
+}
+
+/* single plane formats: RGB, BGR, RGBA, BGRA and AYUV */
+static void
+clutter_gst_video_sink_upload_packed (ClutterGstVideoSink *sink,
+                                      GstBuffer           *buffer,
+                                      CoglPixelFormat      format,
+                                      int                  bpp)
+{
+  ClutterGstVideoSinkPrivate *priv = sink->priv;
+  GstVideoFrame frame;
+
+  if (!gst_video_frame_map (&frame, &priv->info, buffer, GST_MAP_READ))
+    {
+      GST_WARNING_OBJECT (sink, "could not map video frame");
+      return;
+    }
+
+  clutter_gst_video_sink_ensure_textures (sink, format);
+
+  clutter_gst_video_sink_upload_plane (sink, 0, priv->y_tex,
+                                       GST_VIDEO_FRAME_WIDTH (&frame),
+                                       GST_VIDEO_FRAME_HEIGHT (&frame),
+                                       format, bpp,
+                                       GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0),
+                                       GST_VIDEO_FRAME_PLANE_DATA (&frame, 0));
+  clutter_gst_video_sink_uploaded (sink);
+
+  gst_video_frame_unmap (&frame);
+}
+
 /*
  * RGB 24 / BGR 24
  *
@@ -352,16 +756,11 @@ clutter_gst_rgb24_upload (ClutterGstVideoSink *sink,
 {
   ClutterGstVideoSinkPrivate *priv= sink->priv;
 
-  clutter_texture_set_from_rgb_data (priv->texture,
-                                     GST_BUFFER_DATA (buffer),
-                                     FALSE,
-                                     priv->width,
-                                     priv->height,
-                                     GST_ROUND_UP_4 (3 * priv->width),
-                                     3,
-                                     priv->bgr ?
-                                     CLUTTER_TEXTURE_RGB_FLAG_BGR : 0,
-                                     NULL);
+  clutter_gst_video_sink_upload_packed (sink, buffer,
+                                        priv->bgr ?
+                                        COGL_PIXEL_FORMAT_BGR_888 :
+                                        COGL_PIXEL_FORMAT_RGB_888,
+                                        3);
 }
 
 static ClutterGstRenderer rgb24_renderer =
@@ -369,7 +768,7 @@ static ClutterGstRenderer rgb24_renderer =
   "RGB 24",
   CLUTTER_GST_RGB24,
   0,
-  GST_STATIC_CAPS (GST_VIDEO_CAPS_RGB ";" GST_VIDEO_CAPS_BGR),
+  GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{ RGB, BGR }")),
   clutter_gst_dummy_init,
   clutter_gst_dummy_deinit,
   clutter_gst_rgb24_upload,
@@ -385,16 +784,11 @@ clutter_gst_rgb32_upload (ClutterGstVideoSink *sink,
 {
   ClutterGstVideoSinkPrivate *priv= sink->priv;
 
-  clutter_texture_set_from_rgb_data (priv->texture,
-                                     GST_BUFFER_DATA (buffer),
-                                     TRUE,
-                                     priv->width,
-                                     priv->height,
-                                     GST_ROUND_UP_4 (4 * priv->width),
-                                     4,
-                                     priv->bgr ?
-                                     CLUTTER_TEXTURE_RGB_FLAG_BGR : 0,
-                                     NULL);
+  clutter_gst_video_sink_upload_packed (sink, buffer,
+                                        priv->bgr ?
+                                        COGL_PIXEL_FORMAT_BGRA_8888 :
+                                        COGL_PIXEL_FORMAT_RGBA_8888,
+                                        4);
 }
 
 static ClutterGstRenderer rgb32_renderer =
@@ -402,7 +796,7 @@ static ClutterGstRenderer rgb32_renderer =
   "RGB 32",
   CLUTTER_GST_RGB32,
   0,
-  GST_STATIC_CAPS (GST_VIDEO_CAPS_RGBA ";" GST_VIDEO_CAPS_BGRA),
+  GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{ RGBA, BGRA }")),
   clutter_gst_dummy_init,
   clutter_gst_dummy_deinit,
   clutter_gst_rgb32_upload,
@@ -419,42 +813,36 @@ clutter_gst_yv12_upload (ClutterGstVideoSink *sink,
                          GstBuffer           *buffer)
 {
   ClutterGstVideoSinkPrivate *priv = sink->priv;
+  GstVideoFrame frame;
+  int plane;
 
-  CoglHandle y_tex = cogl_texture_new_from_data (priv->width,
-                                                 priv->height,
-                                                 COGL_TEXTURE_NO_SLICING,
-                                                 COGL_PIXEL_FORMAT_G_8,
-                                                 COGL_PIXEL_FORMAT_G_8,
-                                                 priv->width,
-                                                 GST_BUFFER_DATA (buffer));
-
-  clutter_texture_set_cogl_texture (priv->texture, y_tex);
-  cogl_texture_unref (y_tex);
+  if (!gst_video_frame_map (&frame, &priv->info, buffer, GST_MAP_READ))
+    {
+      GST_WARNING_OBJECT (sink, "could not map video frame");
+      return;
+    }
 
-  if (priv->u_tex)
-    cogl_texture_unref (priv->u_tex);
+  clutter_gst_video_sink_ensure_textures (sink, COGL_PIXEL_FORMAT_G_8);
 
-  if (priv->v_tex)
-    cogl_texture_unref (priv->v_tex);
+  /* The planes are uploaded in memory order, v_tex getting the first chroma
+   * plane and u_tex the second; the YV12 and I420 renderers bind them to
+   * the right samplers. The strides come from the frame, decoders often pad
+   * the lines. */
+  for (plane = 0; plane < 3; plane++)
+    {
+      CoglHandle tex = plane == 0 ? priv->y_tex :
+                       plane == 1 ? priv->v_tex : priv->u_tex;
+
+      clutter_gst_video_sink_upload_plane (sink, plane, tex,
+                                           GST_VIDEO_FRAME_COMP_WIDTH (&frame, plane),
+                                           GST_VIDEO_FRAME_COMP_HEIGHT (&frame, plane),
+                                           COGL_PIXEL_FORMAT_G_8, 1,
+                                           GST_VIDEO_FRAME_PLANE_STRIDE (&frame, plane),
+                                           GST_VIDEO_FRAME_PLANE_DATA (&frame, plane));
+    }
+  clutter_gst_video_sink_uploaded (sink);
 
-  priv->v_tex = cogl_texture_new_from_data (priv->width / 2,
-                                            priv->height / 2,
-                                            COGL_TEXTURE_NO_SLICING,
-                                            COGL_PIXEL_FORMAT_G_8,
-                                            COGL_PIXEL_FORMAT_G_8,
-                                            priv->width / 2,
-                                            GST_BUFFER_DATA (buffer) +
-                                            (priv->width * priv->height));
-
-  priv->u_tex = cogl_texture_new_from_data (priv->width / 2,
-                                            priv->height / 2,
-                                            COGL_TEXTURE_NO_SLICING,
-                                            COGL_PIXEL_FORMAT_G_8,
-                                            COGL_PIXEL_FORMAT_G_8,
-                                            priv->width / 2,
-                                            GST_BUFFER_DATA (buffer)
-                                            + (priv->width * priv->height)
-                                            + (priv->width / 2 * priv->height / 2));
+  gst_video_frame_unmap (&frame);
 }
 
 static void
@@ -518,6 +906,7 @@ static void
 clutter_gst_yv12_glsl_deinit (ClutterGstVideoSink *sink)
 {
   clutter_gst_video_sink_set_glsl_shader (sink, NULL);
+  clutter_gst_video_sink_free_textures (sink);
 }
 
 
@@ -526,7 +915,7 @@ static ClutterGstRenderer yv12_glsl_renderer =
   "YV12 glsl",
   CLUTTER_GST_YV12,
   CLUTTER_GST_GLSL | CLUTTER_GST_MULTI_TEXTURE,
-  GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ("YV12")),
+  GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("YV12")),
   clutter_gst_yv12_glsl_init,
   clutter_gst_yv12_glsl_deinit,
   clutter_gst_yv12_upload,
@@ -611,6 +1000,7 @@ static void
 clutter_gst_yv12_fp_deinit (ClutterGstVideoSink *sink)
 {
   clutter_gst_video_sink_set_fp_shader (sink, NULL, 0);
+  clutter_gst_video_sink_free_textures (sink);
 }
 
 static ClutterGstRenderer yv12_fp_renderer =
@@ -618,7 +1008,7 @@ static ClutterGstRenderer yv12_fp_renderer =
   "YV12 fp",
   CLUTTER_GST_YV12,
   CLUTTER_GST_FP | CLUTTER_GST_MULTI_TEXTURE,
-  GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ("YV12")),
+  GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("YV12")),
   clutter_gst_yv12_fp_init,
   clutter_gst_yv12_fp_deinit,
   clutter_gst_yv12_upload,
@@ -659,7 +1049,7 @@ static ClutterGstRenderer i420_glsl_renderer =
   "I420 glsl",
   CLUTTER_GST_I420,
   CLUTTER_GST_GLSL | CLUTTER_GST_MULTI_TEXTURE,
-  GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ("I420")),
+  GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("I420")),
   clutter_gst_i420_glsl_init,
   clutter_gst_yv12_glsl_deinit,
   clutter_gst_yv12_upload,
@@ -696,7 +1086,7 @@ static ClutterGstRenderer i420_fp_renderer =
   "I420 fp",
   CLUTTER_GST_I420,
   CLUTTER_GST_FP | CLUTTER_GST_MULTI_TEXTURE,
-  GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ("I420")),
+  GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("I420")),
   clutter_gst_i420_fp_init,
   clutter_gst_yv12_fp_deinit,
   clutter_gst_yv12_upload,
@@ -721,23 +1111,15 @@ static void
 clutter_gst_ayuv_glsl_deinit(ClutterGstVideoSink *sink)
 {
   clutter_gst_video_sink_set_glsl_shader (sink, NULL);
+  clutter_gst_video_sink_free_textures (sink);
 }
 
 static void
 clutter_gst_ayuv_upload (ClutterGstVideoSink *sink,
                          GstBuffer           *buffer)
 {
-  ClutterGstVideoSinkPrivate *priv= sink->priv;
-
-  clutter_texture_set_from_rgb_data (priv->texture,
-                                     GST_BUFFER_DATA (buffer),
-                                     TRUE,
-                                     priv->width,
-                                     priv->height,
-                                     GST_ROUND_UP_4 (4 * priv->width),
-                                     4,
-                                     0,
-                                     NULL);
+  clutter_gst_video_sink_upload_packed (sink, buffer,
+                                        COGL_PIXEL_FORMAT_RGBA_8888, 4);
 }
 
 static ClutterGstRenderer ayuv_glsl_renderer =
@@ -745,12 +1127,89 @@ static ClutterGstRenderer ayuv_glsl_renderer =
   "AYUV glsl",
   CLUTTER_GST_AYUV,
   CLUTTER_GST_GLSL,
-  GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ("AYUV")),
+  GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("AYUV")),
   clutter_gst_ayuv_glsl_init,
   clutter_gst_ayuv_glsl_deinit,
   clutter_gst_ayuv_upload,
 };
 
+/*
+ * NV12
+ *
+ * 8 bit Y plane followed by an interleaved 8 bit 2x2 subsampled UV plane.
+ * This is what most hardware and modern software decoders output, so
+ * handling it here saves a full colorspace conversion on the CPU.
+ */
+
+#ifdef CLUTTER_COGL_HAS_GL
+static void
+clutter_gst_nv12_upload (ClutterGstVideoSink *sink,
+                         GstBuffer           *buffer)
+{
+  ClutterGstVideoSinkPrivate *priv = sink->priv;
+  GstVideoFrame frame;
+
+  if (!gst_video_frame_map (&frame, &priv->info, buffer, GST_MAP_READ))
+    {
+      GST_WARNING_OBJECT (sink, "could not map video frame");
+      return;
+    }
+
+  clutter_gst_video_sink_ensure_textures (sink, COGL_PIXEL_FORMAT_G_8);
+
+  clutter_gst_video_sink_upload_plane (sink, 0, priv->y_tex,
+                                       GST_VIDEO_FRAME_COMP_WIDTH (&frame, 0),
+                                       GST_VIDEO_FRAME_COMP_HEIGHT (&frame, 0),
+                                       COGL_PIXEL_FORMAT_G_8, 1,
+                                       GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0),
+                                       GST_VIDEO_FRAME_PLANE_DATA (&frame, 0));
+
+  if (priv->uv_gl_tex)
+    clutter_gst_video_sink_upload_plane_gl (sink, 1, priv->uv_gl_tex,
+                                            GL_TEXTURE_2D,
+                                            GST_VIDEO_FRAME_COMP_WIDTH (&frame, 1),
+                                            GST_VIDEO_FRAME_COMP_HEIGHT (&frame, 1),
+                                            GL_LUMINANCE_ALPHA, 2,
+                                            GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 1),
+                                            GST_VIDEO_FRAME_PLANE_DATA (&frame, 1));
+  clutter_gst_video_sink_uploaded (sink);
+
+  gst_video_frame_unmap (&frame);
+}
+
+static void
+clutter_gst_nv12_glsl_init (ClutterGstVideoSink *sink)
+{
+  ClutterGstVideoSinkPrivate *priv = sink->priv;
+  GLint location;
+
+  clutter_gst_video_sink_set_glsl_shader (sink, nv12_to_rgba_shader);
+
+  cogl_program_use (priv->program);
+  location = cogl_program_get_uniform_location (priv->program, "ytex");
+  cogl_program_uniform_1i (location, 0);
+  location = cogl_program_get_uniform_location (priv->program, "uvtex");
+  cogl_program_uniform_1i (location, 1);
+  cogl_program_use (COGL_INVALID_HANDLE);
+
+  /* the UV texture is u_tex, bound to layer 1 like the YV12 one */
+  _renderer_connect_signals (sink,
+                             clutter_gst_yv12_glsl_paint,
+                             clutter_gst_yv12_glsl_post_paint);
+}
+
+static ClutterGstRenderer nv12_glsl_renderer =
+{
+  "NV12 glsl",
+  CLUTTER_GST_NV12,
+  CLUTTER_GST_GLSL | CLUTTER_GST_MULTI_TEXTURE,
+  GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("NV12")),
+  clutter_gst_nv12_glsl_init,
+  clutter_gst_yv12_glsl_deinit,
+  clutter_gst_nv12_upload,
+};
+#endif
+
 static GSList *
 clutter_gst_build_renderers_list (ClutterGstSymbols *syms)
 {
@@ -771,6 +1230,7 @@ clutter_gst_build_renderers_list (ClutterGstSymbols *syms)
 #ifdef CLUTTER_COGL_HAS_GL
       &yv12_fp_renderer,
       &i420_fp_renderer,
+      &nv12_glsl_renderer,
 #endif
       &ayuv_glsl_renderer,
       NULL
@@ -804,6 +1264,28 @@ clutter_gst_build_renderers_list (ClutterGstSymbols *syms)
           features |= CLUTTER_GST_FP;
         }
     }
+
+  if (cogl_check_extension ("GL_ARB_pixel_buffer_object", gl_extensions))
+    {
+      syms->glGenBuffersARB = (GLGENBUFFERSPROC)
+        cogl_get_proc_address ("glGenBuffersARB");
+      syms->glDeleteBuffersARB = (GLDELETEBUFFERSPROC)
+        cogl_get_proc_address ("glDeleteBuffersARB");
+      syms->glBindBufferARB = (GLBINDBUFFERPROC)
+        cogl_get_proc_address ("glBindBufferARB");
+      syms->glBufferDataARB = (GLBUFFERDATAPROC)
+        cogl_get_proc_address ("glBufferDataARB");
+      syms->glMapBufferARB = (GLMAPBUFFERPROC)
+        cogl_get_proc_address ("glMapBufferARB");
+      syms->glUnmapBufferARB = (GLUNMAPBUFFERPROC)
+        cogl_get_proc_address ("glUnmapBufferARB");
+
+      /* the upload path only checks glMapBufferARB */
+      if (!syms->glGenBuffersARB || !syms->glDeleteBuffersARB ||
+          !syms->glBindBufferARB || !syms->glBufferDataARB ||
+          !syms->glUnmapBufferARB)
+        syms->glMapBufferARB = NULL;
+    }
 #endif
 
   if (cogl_features_available (COGL_FEATURE_SHADERS_GLSL))
@@ -868,12 +1350,155 @@ clutter_gst_find_renderer_by_format (ClutterGstVideoSink  *sink,
   return renderer;
 }
 
+static void
+clutter_gst_queued_frame_free (ClutterGstQueuedFrame *frame)
+{
+  gst_buffer_unref (frame->buffer);
+  g_slice_free (ClutterGstQueuedFrame, frame);
+}
+
+/* called with the buffer_lock held */
+static void
+clutter_gst_video_sink_clear_frames (ClutterGstVideoSink *sink)
+{
+  ClutterGstQueuedFrame *frame;
+
+  while ((frame = g_queue_pop_head (sink->priv->frames)) != NULL)
+    clutter_gst_queued_frame_free (frame);
+}
+
+/* The latest buffer running time due half a stage frame from now, which is
+ * about when the frame uploaded now will hit the screen. Like the base
+ * class, a buffer is due at its running time plus the pipeline latency,
+ * which includes our render delay, plus ts-offset. */
+static GstClockTime
+clutter_gst_video_sink_next_paint_time (ClutterGstVideoSink *sink)
+{
+  GstElement *element = GST_ELEMENT (sink);
+  GstBaseSink *bsink = GST_BASE_SINK (sink);
+  GstClock *clock;
+  GstClockTime now, base_time;
+  GstClockTimeDiff deadline;
+  guint frame_rate;
+
+  clock = gst_element_get_clock (element);
+  if (clock == NULL)
+    return GST_CLOCK_TIME_NONE;
+
+  now = gst_clock_get_time (clock);
+  base_time = gst_element_get_base_time (element);
+  gst_object_unref (clock);
+
+  frame_rate = MAX (clutter_get_default_frame_rate (), 1);
+
+  deadline = GST_CLOCK_DIFF (base_time, now) + GST_SECOND / frame_rate / 2;
+  deadline -= gst_base_sink_get_latency (bsink);
+  deadline -= gst_base_sink_get_ts_offset (bsink);
+
+  return deadline > 0 ? (GstClockTime) deadline : 0;
+}
+
+/* Runs in the clutter thread right before the stage is painted. Uploads the
+ * most recent frame due by the time the paint hits the screen; earlier ones
+ * were never going to be seen and are dropped without an upload. */
+static gboolean
+clutter_gst_video_sink_repaint (gpointer data)
+{
+  ClutterGstVideoSink        *sink = data;
+  ClutterGstVideoSinkPrivate *priv = sink->priv;
+  ClutterGstQueuedFrame      *frame, *due = NULL;
+  GstClockTime                deadline, start;
+  gboolean                    pending;
+
+  if (priv->renderer_state != CLUTTER_GST_RENDERER_RUNNING)
+    return TRUE;
+
+  deadline = clutter_gst_video_sink_next_paint_time (sink);
+
+  g_mutex_lock (priv->buffer_lock);
+  while ((frame = g_queue_peek_head (priv->frames)) != NULL)
+    {
+      if (GST_CLOCK_TIME_IS_VALID (frame->running_time) &&
+          GST_CLOCK_TIME_IS_VALID (deadline) &&
+          frame->running_time > deadline)
+        break;
+
+      g_queue_pop_head (priv->frames);
+      if (due)
+        {
+          priv->stats.dropped++;
+          clutter_gst_queued_frame_free (due);
+        }
+      due = frame;
+    }
+  pending = !g_queue_is_empty (priv->frames);
+  g_mutex_unlock (priv->buffer_lock);
+
+  if (due)
+    {
+      start = gst_util_get_timestamp ();
+      priv->renderer->upload (sink, due->buffer);
+
+      g_mutex_lock (priv->buffer_lock);
+      priv->stats.uploaded++;
+      priv->stats.upload_histogram[
+        clutter_gst_video_sink_stats_bucket (gst_util_get_timestamp () - start)]++;
+      g_mutex_unlock (priv->buffer_lock);
+
+      priv->unpainted_time = due->received;
+      clutter_gst_queued_frame_free (due);
+    }
+  else if (pending)
+    {
+      /* nothing due yet, come back on the next frame */
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (priv->texture));
+    }
+
+  return TRUE;
+}
+
+/* Pacing mode: keep the frame along with its running time for the repaint
+ * function instead of uploading the newest frame from an idle */
+static void
+clutter_gst_video_sink_queue_frame (ClutterGstVideoSink *sink,
+                                    GstBuffer           *buffer,
+                                    gboolean             preroll)
+{
+  ClutterGstVideoSinkPrivate *priv = sink->priv;
+  GstBaseSink *bsink = GST_BASE_SINK (sink);
+  ClutterGstQueuedFrame *frame;
+  GstClockTime running_time = GST_CLOCK_TIME_NONE;
+
+  if (!preroll && GST_BUFFER_PTS_IS_VALID (buffer))
+    {
+      GST_OBJECT_LOCK (bsink);
+      running_time = gst_segment_to_running_time (&bsink->segment,
+                                                  GST_FORMAT_TIME,
+                                                  GST_BUFFER_PTS (buffer));
+      GST_OBJECT_UNLOCK (bsink);
+    }
+
+  frame = g_slice_new (ClutterGstQueuedFrame);
+  frame->buffer = gst_buffer_ref (buffer);
+  frame->running_time = running_time;
+  frame->received = gst_util_get_timestamp ();
+
+  /* called with the buffer_lock held */
+  if (g_queue_get_length (priv->frames) >= CLUTTER_GST_PACING_QUEUE_LENGTH)
+    {
+      priv->stats.dropped++;
+      clutter_gst_queued_frame_free (g_queue_pop_head (priv->frames));
+    }
+  g_queue_push_tail (priv->frames, frame);
+}
+
 static gboolean
 clutter_gst_video_sink_idle_func (gpointer data)
 {
   ClutterGstVideoSink        *sink;
   ClutterGstVideoSinkPrivate *priv;
   GstBuffer                  *buffer;
+  GstClockTime                buffer_time, start;
 
   sink = data;
   priv = sink->priv;
@@ -891,6 +1516,20 @@ clutter_gst_video_sink_idle_func (gpointer data)
       priv->renderer_state = CLUTTER_GST_RENDERER_RUNNING;
     }
 
+  if (priv->pacing)
+    {
+      g_mutex_lock (priv->buffer_lock);
+      priv->idle_id = 0;
+      g_mutex_unlock (priv->buffer_lock);
+
+      if (priv->repaint_id == 0)
+        priv->repaint_id =
+          clutter_threads_add_repaint_func (clutter_gst_video_sink_repaint,
+                                            sink, NULL);
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (priv->texture));
+      return FALSE;
+    }
+
   g_mutex_lock (priv->buffer_lock);
   if (!priv->buffer)
     {
@@ -909,32 +1548,29 @@ clutter_gst_video_sink_idle_func (gpointer data)
       return FALSE;
     }
 
+  buffer_time = priv->buffer_time;
   priv->idle_id = 0;
   g_mutex_unlock (priv->buffer_lock);
 
+  start = gst_util_get_timestamp ();
   priv->renderer->upload (sink, buffer);
 
+  g_mutex_lock (priv->buffer_lock);
+  priv->stats.uploaded++;
+  priv->stats.upload_histogram[
+    clutter_gst_video_sink_stats_bucket (gst_util_get_timestamp () - start)]++;
+  g_mutex_unlock (priv->buffer_lock);
+
+  /* a frame replaced before its first paint never made it to the screen */
+  priv->unpainted_time = buffer_time;
+
   gst_buffer_unref (buffer);
   
   return FALSE;
 }
 
 static void
-clutter_gst_video_sink_base_init (gpointer g_class)
-{
-  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
-
-  gst_element_class_add_pad_template
-                     (element_class,
-                      gst_static_pad_template_get (&sinktemplate_all));
-
-  gst_element_class_set_details (element_class,
-                                 &clutter_gst_video_sink_details);
-}
-
-static void
-clutter_gst_video_sink_init (ClutterGstVideoSink      *sink,
-                             ClutterGstVideoSinkClass *klass)
+clutter_gst_video_sink_init (ClutterGstVideoSink *sink)
 {
   ClutterGstVideoSinkPrivate *priv;
 
@@ -946,13 +1582,16 @@ clutter_gst_video_sink_init (ClutterGstVideoSink      *sink,
   priv->renderers = clutter_gst_build_renderers_list (&priv->syms);
   priv->caps = clutter_gst_build_caps (priv->renderers);
   priv->renderer_state = CLUTTER_GST_RENDERER_STOPPED;
+  priv->unpainted_time = GST_CLOCK_TIME_NONE;
+  priv->frames = g_queue_new ();
 
   priv->signal_handler_ids = g_array_new (FALSE, FALSE, sizeof (gulong));
 }
 
 static GstFlowReturn
-clutter_gst_video_sink_render (GstBaseSink *bsink,
-                               GstBuffer   *buffer)
+clutter_gst_video_sink_show_frame (GstBaseSink *bsink,
+                                   GstBuffer   *buffer,
+                                   gboolean     preroll)
 {
   ClutterGstVideoSink *sink;
   ClutterGstVideoSinkPrivate *priv;
@@ -962,11 +1601,22 @@ clutter_gst_video_sink_render (GstBaseSink *bsink,
 
 
   g_mutex_lock (priv->buffer_lock);
-  if (priv->buffer)
-    { 
-      gst_buffer_unref (priv->buffer);
+  priv->stats.received++;
+  if (priv->pacing)
+    {
+      clutter_gst_video_sink_queue_frame (sink, buffer, preroll);
+    }
+  else
+    {
+      if (priv->buffer)
+        { 
+          /* the clutter thread didn't get to upload the previous frame */
+          priv->stats.dropped++;
+          gst_buffer_unref (priv->buffer);
+        }
+      priv->buffer = gst_buffer_ref (buffer);
+      priv->buffer_time = gst_util_get_timestamp ();
     }
-  priv->buffer = gst_buffer_ref (buffer);
 
   if (priv->idle_id == 0)
     {
@@ -983,13 +1633,51 @@ clutter_gst_video_sink_render (GstBaseSink *bsink,
   return GST_FLOW_OK;
 }
 
+static GstFlowReturn
+clutter_gst_video_sink_render (GstBaseSink *bsink,
+                               GstBuffer   *buffer)
+{
+  return clutter_gst_video_sink_show_frame (bsink, buffer, FALSE);
+}
+
+static GstFlowReturn
+clutter_gst_video_sink_preroll (GstBaseSink *bsink,
+                                GstBuffer   *buffer)
+{
+  /* the preroll frame is shown straight away, the clock isn't running */
+  return clutter_gst_video_sink_show_frame (bsink, buffer, TRUE);
+}
+
+static gboolean
+clutter_gst_video_sink_event (GstBaseSink *bsink,
+                              GstEvent    *event)
+{
+  ClutterGstVideoSinkPrivate *priv = CLUTTER_GST_VIDEO_SINK (bsink)->priv;
+
+  /* queued frames belong to the old segment after a seek */
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_START)
+    {
+      g_mutex_lock (priv->buffer_lock);
+      clutter_gst_video_sink_clear_frames (CLUTTER_GST_VIDEO_SINK (bsink));
+      g_mutex_unlock (priv->buffer_lock);
+    }
+
+  return GST_BASE_SINK_CLASS (parent_class)->event (bsink, event);
+}
+
 static GstCaps *
-clutter_gst_video_sink_get_caps (GstBaseSink *bsink)
+clutter_gst_video_sink_get_caps (GstBaseSink *bsink,
+                                 GstCaps     *filter)
 {
   ClutterGstVideoSink *sink;
 
   sink = CLUTTER_GST_VIDEO_SINK (bsink);
-  return gst_caps_copy (sink->priv->caps);
+
+  if (filter)
+    return gst_caps_intersect_full (filter, sink->priv->caps,
+                                    GST_CAPS_INTERSECT_FIRST);
+
+  return gst_caps_ref (sink->priv->caps);
 }
 
 static gboolean
@@ -998,83 +1686,55 @@ clutter_gst_video_sink_set_caps (GstBaseSink *bsink,
 {
   ClutterGstVideoSink        *sink;
   ClutterGstVideoSinkPrivate *priv;
-  GstCaps                    *intersection;
-  GstStructure               *structure;
-  gboolean                    ret;
-  const GValue               *fps;
-  const GValue               *par;
-  gint                        width, height;
-  guint32                     fourcc;
-  int                         red_mask, blue_mask;
+  GstVideoInfo                info;
 
   sink = CLUTTER_GST_VIDEO_SINK(bsink);
   priv = sink->priv;
 
-  intersection = gst_caps_intersect (priv->caps, caps);
-  if (gst_caps_is_empty (intersection)) 
+  if (!gst_caps_can_intersect (priv->caps, caps))
     return FALSE;
 
-  gst_caps_unref (intersection);
-
-  structure = gst_caps_get_structure (caps, 0);
-
-  ret  = gst_structure_get_int (structure, "width", &width);
-  ret &= gst_structure_get_int (structure, "height", &height);
-  fps  = gst_structure_get_value (structure, "framerate");
-  ret &= (fps != NULL);
-
-  par  = gst_structure_get_value (structure, "pixel-aspect-ratio");
-
-  if (!ret)
+  if (!gst_video_info_from_caps (&info, caps))
     return FALSE;
 
-  priv->width  = width;
-  priv->height = height;
-
-  /* We dont yet use fps or pixel aspect into but handy to have */
-  priv->fps_n  = gst_value_get_fraction_numerator (fps);
-  priv->fps_d  = gst_value_get_fraction_denominator (fps);
-
-  if (par) 
-    {
-      priv->par_n = gst_value_get_fraction_numerator (par);
-      priv->par_d = gst_value_get_fraction_denominator (par);
-    } 
-  else 
-    priv->par_n = priv->par_d = 1;
-
-  ret = gst_structure_get_fourcc (structure, "format", &fourcc);
-  if (ret && (fourcc == GST_MAKE_FOURCC ('Y', 'V', '1', '2')))
+  switch (GST_VIDEO_INFO_FORMAT (&info))
     {
+    case GST_VIDEO_FORMAT_YV12:
       priv->format = CLUTTER_GST_YV12;
-    }
-  else if (ret && (fourcc == GST_MAKE_FOURCC ('I', '4', '2', '0')))
-    {
+      break;
+    case GST_VIDEO_FORMAT_I420:
       priv->format = CLUTTER_GST_I420;
-    }
-  else if (ret && (fourcc == GST_MAKE_FOURCC ('A', 'Y', 'U', 'V')))
-    {
+      break;
+    case GST_VIDEO_FORMAT_NV12:
+      priv->format = CLUTTER_GST_NV12;
+      break;
+    case GST_VIDEO_FORMAT_AYUV:
       priv->format = CLUTTER_GST_AYUV;
       priv->bgr = FALSE;
+      break;
+    case GST_VIDEO_FORMAT_RGB:
+    case GST_VIDEO_FORMAT_BGR:
+      priv->format = CLUTTER_GST_RGB24;
+      priv->bgr = GST_VIDEO_INFO_FORMAT (&info) == GST_VIDEO_FORMAT_BGR;
+      break;
+    case GST_VIDEO_FORMAT_RGBA:
+    case GST_VIDEO_FORMAT_BGRA:
+      priv->format = CLUTTER_GST_RGB32;
+      priv->bgr = GST_VIDEO_INFO_FORMAT (&info) == GST_VIDEO_FORMAT_BGRA;
+      break;
+    default:
+      return FALSE;
     }
-  else
-    {
-      guint32 mask;
-      gst_structure_get_int (structure, "red_mask", &red_mask);
-      gst_structure_get_int (structure, "blue_mask", &blue_mask);
-      
-      mask = red_mask | blue_mask;
-      if (mask < 0x1000000)
-        {
-          priv->format = CLUTTER_GST_RGB24;
-          priv->bgr = (red_mask == 0xff0000) ? FALSE : TRUE;
-        }
-      else
-        {
-          priv->format = CLUTTER_GST_RGB32;
-          priv->bgr = (red_mask == 0xff000000) ? FALSE : TRUE;
-        }
-    }
+
+  priv->info = info;
+  priv->width  = GST_VIDEO_INFO_WIDTH (&info);
+  priv->height = GST_VIDEO_INFO_HEIGHT (&info);
+
+  /* We dont yet use fps or pixel aspect into but handy to have */
+  priv->fps_n  = GST_VIDEO_INFO_FPS_N (&info);
+  priv->fps_d  = GST_VIDEO_INFO_FPS_D (&info);
+  priv->par_n  = GST_VIDEO_INFO_PAR_N (&info);
+  priv->par_d  = GST_VIDEO_INFO_PAR_D (&info);
 
   /* find a renderer that can display our format */
   priv->renderer = clutter_gst_find_renderer_by_format (sink, priv->format);
@@ -1086,6 +1746,23 @@ clutter_gst_video_sink_set_caps (GstBaseSink *bsink,
 
   GST_INFO_OBJECT (sink, "using the %s renderer", priv->renderer->name);
 
+  /* Have the base class hand us frames early enough to fill the pacing
+   * queue, it adds the delay to the latency it reports */
+  if (priv->pacing)
+    {
+      GstClockTime duration = GST_SECOND / 25;
+
+      if (priv->fps_n > 0 && priv->fps_d > 0)
+        duration = gst_util_uint64_scale_int (GST_SECOND, priv->fps_d,
+                                              priv->fps_n);
+      gst_base_sink_set_render_delay (bsink,
+        (CLUTTER_GST_PACING_QUEUE_LENGTH - 1) * duration);
+    }
+  else
+    {
+      gst_base_sink_set_render_delay (bsink, 0);
+    }
+
   return TRUE;
 }
 
@@ -1105,14 +1782,30 @@ clutter_gst_video_sink_dispose (GObject *object)
       priv->renderer_state = CLUTTER_GST_RENDERER_STOPPED;
     }
 
+  clutter_gst_video_sink_free_textures (self);
+
   if (priv->idle_id > 0)
     {
       g_source_remove (priv->idle_id);
       priv->idle_id = 0;
     }
 
+  if (priv->repaint_id > 0)
+    {
+      clutter_threads_remove_repaint_func (priv->repaint_id);
+      priv->repaint_id = 0;
+    }
+
+  if (priv->frames)
+    {
+      clutter_gst_video_sink_clear_frames (self);
+      g_queue_free (priv->frames);
+      priv->frames = NULL;
+    }
+
   if (priv->texture)
     {
+      g_signal_handler_disconnect (priv->texture, priv->paint_handler_id);
       g_object_unref (priv->texture);
       priv->texture = NULL;
     }
@@ -1164,9 +1857,24 @@ clutter_gst_video_sink_set_property (GObject *object,
     {
     case PROP_TEXTURE:
       if (priv->texture)
-        g_object_unref (priv->texture);
+        {
+          g_signal_handler_disconnect (priv->texture, priv->paint_handler_id);
+          g_object_unref (priv->texture);
+        }
 
       priv->texture = CLUTTER_TEXTURE (g_value_dup_object (value));
+      priv->paint_handler_id = 0;
+      if (priv->texture)
+        priv->paint_handler_id =
+          g_signal_connect_after (priv->texture, "paint",
+                                  G_CALLBACK (clutter_gst_video_sink_painted),
+                                  sink);
+      break;
+    case PROP_USE_PBO:
+      priv->use_pbo = g_value_get_boolean (value);
+      break;
+    case PROP_PACING:
+      priv->pacing = g_value_get_boolean (value);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -1189,6 +1897,12 @@ clutter_gst_video_sink_get_property (GObject *object,
     case PROP_TEXTURE:
       g_value_set_object (value, sink->priv->texture);
       break;
+    case PROP_USE_PBO:
+      g_value_set_boolean (value, sink->priv->use_pbo);
+      break;
+    case PROP_PACING:
+      g_value_set_boolean (value, sink->priv->pacing);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1206,6 +1920,7 @@ clutter_gst_video_sink_stop (GstBaseSink *base_sink)
   if (priv->buffer)
     gst_buffer_unref (priv->buffer);
   priv->buffer = NULL;
+  clutter_gst_video_sink_clear_frames (sink);
   g_mutex_unlock (priv->buffer_lock);
 
   priv->renderer_state = CLUTTER_GST_RENDERER_STOPPED;
@@ -1225,10 +1940,23 @@ static void
 clutter_gst_video_sink_class_init (ClutterGstVideoSinkClass *klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
   GstBaseSinkClass *gstbase_sink_class = GST_BASE_SINK_CLASS (klass);
 
   g_type_class_add_private (klass, sizeof (ClutterGstVideoSinkPrivate));
 
+  gst_element_class_add_pad_template
+                     (element_class,
+                      gst_static_pad_template_get (&sinktemplate_all));
+
+  gst_element_class_set_static_metadata (element_class,
+      "Clutter video sink",
+      "Sink/Video",
+      "Sends video data from a GStreamer pipeline to a Clutter texture",
+      "Jonathan Matthew <jonathan@kaolin.wh9.net>, "
+      "Matthew Allum <mallum@o-hand.com, "
+      "Chris Lord <chris@o-hand.com>");
+
   gobject_class->set_property = clutter_gst_video_sink_set_property;
   gobject_class->get_property = clutter_gst_video_sink_get_property;
 
@@ -1236,7 +1964,8 @@ clutter_gst_video_sink_class_init (ClutterGstVideoSinkClass *klass)
   gobject_class->finalize = clutter_gst_video_sink_finalize;
 
   gstbase_sink_class->render = clutter_gst_video_sink_render;
-  gstbase_sink_class->preroll = clutter_gst_video_sink_render;
+  gstbase_sink_class->preroll = clutter_gst_video_sink_preroll;
+  gstbase_sink_class->event = clutter_gst_video_sink_event;
   gstbase_sink_class->stop = clutter_gst_video_sink_stop;
   gstbase_sink_class->set_caps = clutter_gst_video_sink_set_caps;
   gstbase_sink_class->get_caps = clutter_gst_video_sink_get_caps;
@@ -1248,23 +1977,62 @@ clutter_gst_video_sink_class_init (ClutterGstVideoSinkClass *klass)
                                     "Target ClutterTexture object",
                                     CLUTTER_TYPE_TEXTURE,
                                     G_PARAM_READWRITE));
+
+  g_object_class_install_property
+              (gobject_class, PROP_USE_PBO,
+               g_param_spec_boolean ("use-pbo",
+                                     "use-pbo",
+                                     "Stream frames to the GPU through pixel "
+                                     "buffer objects when supported",
+                                     FALSE,
+                                     G_PARAM_READWRITE));
+
+  g_object_class_install_property
+              (gobject_class, PROP_PACING,
+               g_param_spec_boolean ("pacing",
+                                     "pacing",
+                                     "Queue a few frames and upload the one "
+                                     "due at the next stage paint. Set "
+                                     "before the caps are negotiated",
+                                     FALSE,
+                                     G_PARAM_READWRITE));
 }
 
 /**
- * clutter_gst_video_sink_new:
- * @texture: a #ClutterTexture
+ * clutter_gst_video_sink_get_stats:
+ * @sink: a #ClutterGstVideoSink
+ * @stats: return location for the statistics
  *
- * Creates a new GStreamer video sink which uses @texture as the target
- * for sinking a video stream from GStreamer.
+ * Copies the frame statistics gathered since the sink was created or
+ * clutter_gst_video_sink_reset_stats() was last called. Can be called from
+ * any thread.
+ */
+void
+clutter_gst_video_sink_get_stats (ClutterGstVideoSink      *sink,
+                                  ClutterGstVideoSinkStats *stats)
+{
+  g_return_if_fail (CLUTTER_GST_IS_VIDEO_SINK (sink));
+  g_return_if_fail (stats != NULL);
+
+  g_mutex_lock (sink->priv->buffer_lock);
+  *stats = sink->priv->stats;
+  g_mutex_unlock (sink->priv->buffer_lock);
+}
+
+/**
+ * clutter_gst_video_sink_reset_stats:
+ * @sink: a #ClutterGstVideoSink
  *
- * Return value: a #GstElement for the newly created video sink
+ * Clears the frame statistics, e.g. when a new stream starts.
  */
-GstElement *
-clutter_gst_video_sink_new (ClutterTexture *texture)
+void
+clutter_gst_video_sink_reset_stats (ClutterGstVideoSink *sink)
 {
-  return g_object_new (CLUTTER_GST_TYPE_VIDEO_SINK,
-                       "texture", texture,
-                       NULL);
+  g_return_if_fail (CLUTTER_GST_IS_VIDEO_SINK (sink));
+
+  g_mutex_lock (sink->priv->buffer_lock);
+  memset (&sink->priv->stats, 0, sizeof (ClutterGstVideoSinkStats));
+  g_mutex_unlock (sink->priv->buffer_lock);
 }
 
 static gboolean
@@ -1277,12 +2045,37 @@ plugin_init (GstPlugin *plugin)
   return ret;
 }
 
-GST_PLUGIN_DEFINE_STATIC (GST_VERSION_MAJOR,
-                          GST_VERSION_MINOR,
-                          "cluttersink",
-                          "Element to render to Clutter textures",
-                          plugin_init,
-                          VERSION,
-                          "LGPL", /* license */
-                          PACKAGE,
-                          "http://www.clutter-project.org");
+/**
+ * clutter_gst_video_sink_new:
+ * @texture: a #ClutterTexture
+ *
+ * Creates a new GStreamer video sink which uses @texture as the target
+ * for sinking a video stream from GStreamer.
+ *
+ * Return value: a #GstElement for the newly created video sink
+ */
+GstElement *
+clutter_gst_video_sink_new (ClutterTexture *texture)
+{
+  static gsize plugin_registered = 0;
+
+  /* GStreamer 1.0 has no constructor based static plugins anymore */
+  if (g_once_init_enter (&plugin_registered))
+    {
+      gst_plugin_register_static (GST_VERSION_MAJOR,
+                                  GST_VERSION_MINOR,
+                                  "cluttersink",
+                                  "Element to render to Clutter textures",
+                                  plugin_init,
+                                  VERSION,
+                                  "LGPL", /* license */
+                                  PACKAGE,
+                                  PACKAGE,
+                                  "http://www.clutter-project.org");
+      g_once_init_leave (&plugin_registered, 1);
+    }
+
+  return g_object_new (CLUTTER_GST_TYPE_VIDEO_SINK,
+                       "texture", texture,
+                       NULL);
+}
@@ -95,8 +95,37 @@ struct _ClutterGstVideoSinkClass
   void (* _clutter_reserved6) (void);
 };
 
+#define CLUTTER_GST_VIDEO_SINK_STATS_BUCKETS 8
+
+/**
+ * ClutterGstVideoSinkStats:
+ * @received: frames handed to the sink by the pipeline
+ * @dropped: frames replaced by a newer one before they could be uploaded
+ * @uploaded: frames uploaded to the texture
+ * @painted: uploaded frames that were painted at least once
+ * @upload_histogram: upload times in buckets of < 1, 2, 4, 8, 16, 32, 64
+ *   and >= 64 milliseconds
+ * @latency_histogram: time from the sink receiving a frame to its first
+ *   paint, in the same buckets
+ *
+ * Frame statistics of a #ClutterGstVideoSink, see
+ * clutter_gst_video_sink_get_stats().
+ */
+typedef struct
+{
+  guint64 received;
+  guint64 dropped;
+  guint64 uploaded;
+  guint64 painted;
+  guint32 upload_histogram[CLUTTER_GST_VIDEO_SINK_STATS_BUCKETS];
+  guint32 latency_histogram[CLUTTER_GST_VIDEO_SINK_STATS_BUCKETS];
+} ClutterGstVideoSinkStats;
+
 GType       clutter_gst_video_sink_get_type    (void) G_GNUC_CONST;
 GstElement *clutter_gst_video_sink_new         (ClutterTexture *texture);
+void        clutter_gst_video_sink_get_stats   (ClutterGstVideoSink      *sink,
+                                                ClutterGstVideoSinkStats *stats);
+void        clutter_gst_video_sink_reset_stats (ClutterGstVideoSink      *sink);
 
 G_END_DECLS
 
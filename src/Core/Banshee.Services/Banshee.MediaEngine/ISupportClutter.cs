@@ -27,6 +27,7 @@
 //
 
 using System;
+using System.Runtime.InteropServices;
 
 namespace Banshee.MediaEngine
 {
@@ -35,5 +36,24 @@ namespace Banshee.MediaEngine
         void EnableClutterVideoSink (IntPtr videoTexture);
         void DisableClutterVideoSink ();
         bool IsClutterVideoSinkInitialized { get; }
+        ClutterVideoSinkStats GetClutterVideoSinkStats ();
+        void ResetClutterVideoSinkStats ();
+    }
+
+    // Mirrors ClutterGstVideoSinkStats in libbanshee. The histogram buckets
+    // are < 1, 2, 4, 8, 16, 32, 64 and >= 64 milliseconds.
+    [StructLayout (LayoutKind.Sequential)]
+    public struct ClutterVideoSinkStats
+    {
+        public ulong Received;
+        public ulong Dropped;
+        public ulong Uploaded;
+        public ulong Painted;
+
+        [MarshalAs (UnmanagedType.ByValArray, SizeConst = 8)]
+        public uint [] UploadHistogram;
+
+        [MarshalAs (UnmanagedType.ByValArray, SizeConst = 8)]
+        public uint [] LatencyHistogram;
     }
 }
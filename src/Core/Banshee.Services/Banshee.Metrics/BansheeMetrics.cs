@@ -25,6 +25,7 @@
 // THE SOFTWARE.
 
 using System;
+using System.Collections.Generic;
 using System.Linq;
 using System.Reflection;
 using Mono.Unix;
@@ -79,6 +80,9 @@ namespace Banshee.Metrics
         private Metric shutdown, duration, active_source_changed, sqlite_executed;
         private Metric playback_source_changed, shuffle_changed, repeat_changed;
 
+        private const int MaxLatencySamples = 1000;
+        private Dictionary<string, List<double>> latencies = new Dictionary<string, List<double>> ();
+
         private BansheeMetrics ()
         {
             banshee_metrics = this;
@@ -231,6 +235,43 @@ namespace Banshee.Metrics
             return metrics.Add (String.Format ("Banshee/{0}", name), func);
         }
 
+        // Latencies are too frequent to push one sample each; they are kept
+        // in memory and only their percentiles are recorded, at shutdown
+        public void AddLatency (string name, double ms)
+        {
+            lock (latencies) {
+                List<double> samples;
+                if (!latencies.TryGetValue (name, out samples)) {
+                    latencies[name] = samples = new List<double> ();
+                }
+
+                if (samples.Count < MaxLatencySamples) {
+                    samples.Add (ms);
+                }
+            }
+        }
+
+        private void PushLatencyPercentiles ()
+        {
+            lock (latencies) {
+                foreach (var latency in latencies) {
+                    var samples = latency.Value;
+                    samples.Sort ();
+                    Add (String.Format ("{0}Percentiles", latency.Key)).PushSample (String.Format (
+                        System.Globalization.CultureInfo.InvariantCulture, "n={0} p50={1:0} p90={2:0} p99={3:0}",
+                        samples.Count, Percentile (samples, 50), Percentile (samples, 90), Percentile (samples, 99)
+                    ));
+                }
+                latencies.Clear ();
+            }
+        }
+
+        private static double Percentile (List<double> sorted, int percent)
+        {
+            int rank = (int)Math.Ceiling (percent / 100.0 * sorted.Count);
+            return sorted[Math.Max (0, rank - 1)];
+        }
+
         public void Dispose ()
         {
             var handler = Stopped;
@@ -282,6 +323,7 @@ namespace Banshee.Metrics
         {
             shutdown.TakeSample ();
             duration.TakeSample ();
+            PushLatencyPercentiles ();
             return true;
         }
 